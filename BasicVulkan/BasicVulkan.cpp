@@ -1,6 +1,8 @@
 #include <vw/window.hpp>
 #include <vw/camera.hpp>
 #include <vw/modelLoader.hpp>
+#include <vw/memoryAllocator.hpp>
+#include <vw/uploadBatcher.hpp>
 
 #include <vulkan/vulkan.hpp>
 #include <GLFW/glfw3.h>
@@ -95,6 +97,8 @@ private:
 
     vk::PhysicalDevice m_physicalDevice = nullptr;
     vk::UniqueDevice m_device;
+    std::unique_ptr<vw::util::MemoryAllocator> m_memoryAllocator;
+    std::unique_ptr<vw::util::UploadBatcher> m_uploadBatcher;
 
     vk::Queue m_graphicsQueue;
     vk::Queue m_presentQueue;
@@ -302,6 +306,8 @@ private:
 
         m_commandPool.reset(nullptr);
 
+        m_uploadBatcher.reset(nullptr);
+        m_memoryAllocator.reset(nullptr);
         m_device.reset(nullptr);
         m_callback.reset(nullptr);
         m_surface.reset(nullptr);
@@ -435,9 +441,11 @@ private:
         }
 
         m_device = m_physicalDevice.createDeviceUnique(createInfo);
+        m_memoryAllocator = std::make_unique<vw::util::MemoryAllocator>(m_device, m_physicalDevice);
 
         m_graphicsQueue = m_device->getQueue(indices.graphicsFamily, 0);
         m_presentQueue = m_device->getQueue(indices.presentFamily, 0);
+        m_uploadBatcher = std::make_unique<vw::util::UploadBatcher>(m_device, *m_memoryAllocator, m_graphicsQueue, static_cast<uint32_t>(indices.graphicsFamily));
     }
 
     void createSwapChain()
@@ -756,7 +764,8 @@ private:
         vw::scene::ModelLoader<vw::scene::VertexDescription::PositionNormalColorTexture> ml;
         m_dragonModel = ml.loadModel("../models/stanford_dragon/dragon.obj", vw::scene::ModelLoader<vw::scene::VertexDescription::PositionNormalColorTexture>::NormalCreation::AssimpSmoothNormals);
         m_dragonModel.scale(glm::vec3{ 0.1f });
-        m_dragonModel.createBuffers(m_device, m_physicalDevice, m_commandPool, m_graphicsQueue);
+        m_dragonModel.createBuffers(m_device, *m_memoryAllocator, *m_uploadBatcher);
+        m_uploadBatcher->submit();
 
         m_triangle = ml.loadTriangle();
     }
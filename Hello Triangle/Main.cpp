@@ -17,6 +17,10 @@
 #include "modelGroupDemo.hpp"
 #include "pushConstantDemo.hpp"
 #include "modelRepositoryDemo.hpp"
+#include "cullBenchmark.hpp"
+#include "cullCheck.hpp"
+#include "overdrawBenchmark.hpp"
+#include "weldBenchmark.hpp"
 
 constexpr uint32_t k_width = 800;
 constexpr uint32_t k_height = 600;
@@ -60,6 +64,10 @@ int main()
     try
     {
         //runAllDemos(k_enableValidationLayers, k_width, k_height);
+        //bmvk::runWeldBenchmark({ "../models/bunny/bun_zipper.ply", "../models/stanford_dragon/dragon.obj" }, 10);
+        //bmvk::runOverdrawBenchmark({ "../models/bunny/bun_zipper.ply", "../models/stanford_dragon/dragon.obj" }, 16);
+        //bmvk::runCullBenchmark(100000, 100);
+        //bmvk::runCullCheck(100000);
         runDemo<bmvk::ModelRepositoryDemo>(k_enableValidationLayers, k_width, k_height);
     }
     catch (const std::runtime_error & e)
@@ -19,6 +19,11 @@ namespace bmvk
         device->bindBufferMemory(*m_buffer, *memory, offset);
     }
 
+    void Buffer::bindToMemory(const vk::UniqueDevice & device, const vw::util::Allocation & allocation) const
+    {
+        device->bindBufferMemory(*m_buffer, allocation.memory, allocation.offset);
+    }
+
     void Buffer::copyToImage(CommandBuffer & cmdBuffer, vk::UniqueImage & image, uint32_t width, uint32_t height) const
     {
         vk::BufferImageCopy region{ 0, 0, 0, { vk::ImageAspectFlagBits::eColor, 0, 0, 1 }, {}, { width, height, 1 } };
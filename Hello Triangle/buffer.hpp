@@ -3,6 +3,8 @@
 #include <type_traits>
 #include <vulkan/vulkan.hpp>
 
+#include <vw/memoryAllocator.hpp>
+
 namespace bmvk
 {
     class CommandBuffer;
@@ -22,6 +24,7 @@ namespace bmvk
         vk::MemoryRequirements getMemoryRequirements(const vk::UniqueDevice & device) const;
 
         void bindToMemory(const vk::UniqueDevice & device, const vk::UniqueDeviceMemory & memory, const vk::DeviceSize offset = 0) const;
+        void bindToMemory(const vk::UniqueDevice & device, const vw::util::Allocation & allocation) const;
         void copyToImage(CommandBuffer & cmdBuffer, vk::UniqueImage & image, uint32_t width, uint32_t height) const;
         void copyToBuffer(CommandBuffer & cmdBuffer, vk::UniqueBuffer & buffer, vk::DeviceSize size, vk::DeviceSize srcOffset = 0, vk::DeviceSize dstOffset = 0) const;
     private:
@@ -3,50 +3,32 @@
 #include <type_traits>
 #include <vulkan/vulkan.hpp>
 
-#include "buffer.hpp"
+#include <vw/memoryAllocator.hpp>
+#include <vw/uploadBatcher.hpp>
+
 #include "device.hpp"
 
 namespace bmvk
 {
     class Device;
-
-    struct StagingBuffer
-    {
-        StagingBuffer(Device & device, Buffer && _buffer, vk::UniqueDeviceMemory && _memory)
-            : buffer{std::move(_buffer)},
-              memory{std::move(_memory)},
-              m_device{device}
-        {
-        }
-
-        void fill(const void * const objPtr, size_t objSize, vk::DeviceSize offset = 0) const
-        {
-            auto data{ reinterpret_cast<vk::DeviceSize *>(m_device.mapMemory(memory, objSize, offset)) };
-            memcpy(data + offset, objPtr, objSize);
-            m_device.unmapMemory(memory);
-        }
-
-        Buffer buffer;
-        vk::UniqueDeviceMemory memory;
-    private:
-        Device & m_device;
-    };
+    class Queue;
 
     class BufferFactory
     {
     public:
-        BufferFactory(Device & device, const vk::PhysicalDevice & physicalDevice);
+        BufferFactory(Device & device, vw::util::MemoryAllocator & allocator, const Queue & queue, const Queue & transferQueue);
         BufferFactory(const BufferFactory &) = delete;
         BufferFactory(BufferFactory && other) = default;
         BufferFactory & operator=(const BufferFactory &) = delete;
         BufferFactory & operator=(BufferFactory &&) = delete;
 
-        StagingBuffer createStagingBuffer(const vk::DeviceSize size) const;
+        // Uploads are collected until submit() is called on the batcher. They run on the transfer queue if the device has one,
+        // the batcher's acquire() has to be called before the uploaded resources are used on the queue.
+        auto & getUploadBatcher() noexcept { return m_uploadBatcher; }
+        // Waits until all submitted uploads have completed
+        void waitIdle() { m_uploadBatcher.waitIdle(); }
     private:
-        Device & m_device;
-        vk::PhysicalDeviceMemoryProperties m_memoryProperties;
-
-        uint32_t findMemoryType(uint32_t typeFilter, vk::MemoryPropertyFlags properties) const;
+        vw::util::UploadBatcher m_uploadBatcher;
     };
 
     static_assert(std::is_move_constructible_v<BufferFactory>);
@@ -65,7 +65,7 @@ namespace bmvk
         std::vector<vk::UniqueFramebuffer> m_swapChainFramebuffers;
 
         vk::UniqueImage m_textureImage;
-        vk::UniqueDeviceMemory m_textureImageMemory;
+        vw::util::UniqueAllocation m_textureImageMemory;
         vk::UniqueImageView m_textureImageView;
         Sampler m_textureSampler;
 
@@ -75,14 +75,11 @@ namespace bmvk
         vk::DeviceSize m_combinedBufferOffset;
 
         vk::UniqueBuffer m_uniformBuffer;
-        vk::UniqueDeviceMemory m_uniformBufferMemory;
+        vw::util::UniqueAllocation m_uniformBufferMemory;
 
         vk::UniqueDescriptorPool m_descriptorPool;
         std::vector<vk::UniqueDescriptorSet> m_descriptorSets;
         std::vector<CommandBuffer> m_commandBuffers;
-        vk::UniqueSemaphore m_imageAvailableSemaphore;
-        vk::UniqueSemaphore m_renderFinishedSemaphore;
-        vk::UniqueSemaphore m_renderImguiFinishedSemaphore;
 
         void createDescriptorSetLayout();
         void createRenderPass();
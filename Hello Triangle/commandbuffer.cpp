@@ -17,6 +17,11 @@ namespace bmvk
         m_commandBuffer->copyBuffer(*srcBuffer, *dstBuffer, { { srcOffset, dstOffset, size } });
     }
 
+    void CommandBuffer::fillBuffer(const vk::UniqueBuffer & dstBuffer, vk::DeviceSize dstOffset, vk::DeviceSize size, uint32_t data) const
+    {
+        m_commandBuffer->fillBuffer(*dstBuffer, dstOffset, size, data);
+    }
+
     void CommandBuffer::copyBufferToImage(const vk::UniqueBuffer & srcBuffer, vk::UniqueImage & dstImage, vk::ImageLayout dstImageLayout, vk::ArrayProxy<const vk::BufferImageCopy> regions) const
     {
         m_commandBuffer->copyBufferToImage(*srcBuffer, *dstImage, dstImageLayout, regions);
@@ -71,4 +76,9 @@ namespace bmvk
     {
         m_commandBuffer->drawIndexed(indexCount, instanceCount, firstIndex, vertexOffset, firstInstance);
     }
+
+    void CommandBuffer::dispatch(uint32_t groupCountX, uint32_t groupCountY, uint32_t groupCountZ) const
+    {
+        m_commandBuffer->dispatch(groupCountX, groupCountY, groupCountZ);
+    }
 }
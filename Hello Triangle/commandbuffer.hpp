@@ -22,6 +22,7 @@ namespace bmvk
         void end() const;
 
         void copyBuffer(const vk::UniqueBuffer & srcBuffer, vk::UniqueBuffer & dstBuffer, vk::DeviceSize size, vk::DeviceSize srcOffset = 0, vk::DeviceSize dstOffset = 0) const;
+        void fillBuffer(const vk::UniqueBuffer & dstBuffer, vk::DeviceSize dstOffset, vk::DeviceSize size, uint32_t data) const;
         void copyBufferToImage(const vk::UniqueBuffer & srcBuffer, vk::UniqueImage & dstImage, vk::ImageLayout dstImageLayout, vk::ArrayProxy<const vk::BufferImageCopy> regions) const;
 
         void beginRenderPass(const vk::UniqueRenderPass & renderPass, const vk::UniqueFramebuffer & framebuffer, vk::Rect2D renderArea, vk::ArrayProxy<vk::ClearValue> clearColors, vk::SubpassContents contents = vk::SubpassContents::eInline) const;
@@ -41,6 +42,7 @@ namespace bmvk
         void bindIndexBuffer(const vk::UniqueBuffer & buffer, vk::IndexType type = vk::IndexType::eUint16, const vk::DeviceSize offset = 0) const;
 
         void drawIndexed(uint32_t indexCount, uint32_t instanceCount = 1, uint32_t firstIndex = 0, int32_t vertexOffset = 0, uint32_t firstInstance = 0) const;
+        void dispatch(uint32_t groupCountX, uint32_t groupCountY = 1, uint32_t groupCountZ = 1) const;
     private:
         vk::UniqueCommandBuffer m_commandBuffer;
     };
@@ -20,10 +20,7 @@ namespace bmvk
 
     template <vw::scene::VertexDescription VD>
     CoordinatesDemo<VD>::CoordinatesDemo(const bool enableValidationLayers, const uint32_t width, const uint32_t height)
-        : ImguiBaseDemo{ enableValidationLayers, width, height, "Coordinates Demo", DebugReport::ReportLevel::WarningsAndAbove },
-        m_imageAvailableSemaphore{ m_device.createSemaphore() },
-        m_renderFinishedSemaphore{ m_device.createSemaphore() },
-        m_renderImguiFinishedSemaphore{ m_device.createSemaphore() }
+        : ImguiBaseDemo{ enableValidationLayers, width, height, "Coordinates Demo", DebugReport::ReportLevel::WarningsAndAbove }
     {
         setupCamera();
 
@@ -34,6 +31,7 @@ namespace bmvk
         createFramebuffers();
         loadCube();
         loadDragon();
+        m_bufferFactory.getUploadBatcher().submit();
         createUniformBuffer();
         createDescriptorPool();
         createDescriptorSet();
@@ -43,6 +41,9 @@ namespace bmvk
     template <vw::scene::VertexDescription VD>
     void CoordinatesDemo<VD>::run()
     {
+        // The uploads have to be acquired by the queue before the first frame uses them
+        m_bufferFactory.waitIdle();
+
         while (!m_window.shouldClose())
         {
             /*
@@ -93,9 +94,6 @@ namespace bmvk
         }
 
         m_commandBuffers.clear();
-        m_depthImageView.reset(nullptr);
-        m_depthImage.reset(nullptr);
-        m_depthImageMemory.reset(nullptr);
         m_colorPipeline.reset(nullptr);
         m_normalPipeline.reset(nullptr);
         m_pipelineLayout.reset(nullptr);
@@ -135,7 +133,9 @@ namespace bmvk
         vk::AttachmentDescription depthAttachment{ {}, m_instance.getPhysicalDevice().findDepthFormat(), vk::SampleCountFlagBits::e1, vk::AttachmentLoadOp::eClear, vk::AttachmentStoreOp::eDontCare, vk::AttachmentLoadOp::eDontCare, vk::AttachmentStoreOp::eDontCare, vk::ImageLayout::eUndefined, vk::ImageLayout::eDepthStencilAttachmentOptimal };
         vk::AttachmentReference depthAttachmentRef{ 1, vk::ImageLayout::eDepthStencilAttachmentOptimal };
         vk::SubpassDescription subpass{ {}, vk::PipelineBindPoint::eGraphics, 0, nullptr, 1, &colorAttachmentRef, nullptr, &depthAttachmentRef };
-        vk::SubpassDependency dependency{ VK_SUBPASS_EXTERNAL, 0, vk::PipelineStageFlagBits::eColorAttachmentOutput, vk::PipelineStageFlagBits::eColorAttachmentOutput,{}, vk::AccessFlagBits::eColorAttachmentRead | vk::AccessFlagBits::eColorAttachmentWrite };
+        // The frames in flight share the depth image, so its clear waits for the depth writes of the previous frame
+        const auto stages{ vk::PipelineStageFlagBits::eColorAttachmentOutput | vk::PipelineStageFlagBits::eEarlyFragmentTests | vk::PipelineStageFlagBits::eLateFragmentTests };
+        vk::SubpassDependency dependency{ VK_SUBPASS_EXTERNAL, 0, stages, stages, vk::AccessFlagBits::eDepthStencilAttachmentWrite, vk::AccessFlagBits::eColorAttachmentRead | vk::AccessFlagBits::eColorAttachmentWrite | vk::AccessFlagBits::eDepthStencilAttachmentWrite };
         std::vector<vk::AttachmentDescription> vec{ colorAttachment, depthAttachment };
         RenderPassCreateInfo renderPassInfo{ {}, vec, subpass, dependency };
         m_renderPass = reinterpret_cast<const vk::UniqueDevice &>(m_device)->createRenderPassUnique(renderPassInfo);
@@ -194,7 +194,7 @@ namespace bmvk
         m_swapChainFramebuffers.clear();
         for (auto & uniqueImageView : m_swapchain.getImageViews())
         {
-            std::vector<vk::ImageView> imageViews{ *uniqueImageView, *m_depthImageView };
+            std::vector<vk::ImageView> imageViews{ *uniqueImageView, *m_transientAttachments.getImageView(m_depthAttachment) };
             m_swapChainFramebuffers.emplace_back(m_device.createFramebuffer(m_renderPass, imageViews, m_swapchain.getExtent().width, m_swapchain.getExtent().height, 1));
         }
     }
@@ -237,7 +237,7 @@ namespace bmvk
         // down
         createSide(m_cube, { 0.f, -1.f, 0.f }, { -1.f, -1.f, -1.f }, { 1.f, -1.f, -1.f }, { 1.f, -1.f, 1.f }, { -1.f, -1.f, 1.f }, 20);
 
-        m_cube.createBuffers(reinterpret_cast<const vk::UniqueDevice &>(m_device), static_cast<vk::PhysicalDevice>(m_instance.getPhysicalDevice()), m_commandPool, static_cast<vk::Queue>(m_queue));
+        m_cube.createBuffers(reinterpret_cast<const vk::UniqueDevice &>(m_device), *m_memoryAllocator, m_bufferFactory.getUploadBatcher());
     }
 
     template <vw::scene::VertexDescription VD>
@@ -246,30 +246,24 @@ namespace bmvk
         vw::scene::ModelLoader<VD> ml;
         m_dragon = ml.loadModel(K_MODEL_PATH, vw::scene::ModelLoader<VD>::NormalCreation::Explicit);
 
-        m_dragon.createBuffers(reinterpret_cast<const vk::UniqueDevice &>(m_device), static_cast<vk::PhysicalDevice>(m_instance.getPhysicalDevice()), m_commandPool, static_cast<vk::Queue>(m_queue));
+        m_dragon.createBuffers(reinterpret_cast<const vk::UniqueDevice &>(m_device), *m_memoryAllocator, m_bufferFactory.getUploadBatcher());
     }
 
     template <vw::scene::VertexDescription VD>
     void CoordinatesDemo<VD>::createDepthResources()
     {
-        const auto depthFormat{ m_instance.getPhysicalDevice().findDepthFormat() };
-        createImage(m_swapchain.getExtent().width, m_swapchain.getExtent().height, depthFormat, vk::ImageTiling::eOptimal, vk::ImageUsageFlagBits::eDepthStencilAttachment, vk::MemoryPropertyFlagBits::eDeviceLocal, m_depthImage, m_depthImageMemory);
-        m_depthImageView = createImageView(m_depthImage, depthFormat, vk::ImageAspectFlagBits::eDepth);
-
-        auto cmdBuffer{ m_device.allocateCommandBuffer(m_commandPool) };
-        cmdBuffer.begin(vk::CommandBufferUsageFlagBits::eOneTimeSubmit);
-        transitionImageLayout(cmdBuffer, m_depthImage, depthFormat, vk::ImageLayout::eUndefined, vk::ImageLayout::eDepthStencilAttachmentOptimal);
-        cmdBuffer.end();
-        m_queue.submit(cmdBuffer);
-        m_queue.waitIdle();
+        // The render pass starts the depth attachment in undefined layout, so it needs no transition
+        m_transientAttachments.clear();
+        m_depthAttachment = m_transientAttachments.addAttachment(m_instance.getPhysicalDevice().findDepthFormat(), m_swapchain.getExtent(), vk::ImageUsageFlagBits::eDepthStencilAttachment, vk::ImageAspectFlagBits::eDepth);
+        m_transientAttachments.build();
     }
 
     template <vw::scene::VertexDescription VD>
     void CoordinatesDemo<VD>::createUniformBuffer()
     {
         const auto bufferSize{ sizeof(UniformBufferObject) };
-        const auto uniformBufferUsageFlags{ vk::BufferUsageFlagBits::eUniformBuffer };
-        const auto uniformBufferMemoryPropertyFlags{ vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent };
+        const auto uniformBufferUsageFlags{ vk::BufferUsageFlagBits::eUniformBuffer | vk::BufferUsageFlagBits::eTransferDst };
+        const auto uniformBufferMemoryPropertyFlags{ vk::MemoryPropertyFlagBits::eDeviceLocal };
         createBuffer(bufferSize, uniformBufferUsageFlags, uniformBufferMemoryPropertyFlags, m_uniformBuffer, m_uniformBufferMemory);
     }
 
@@ -344,33 +338,25 @@ namespace bmvk
         ubo.proj[1][1] *= -1;
         ubo.normal = glm::inverseTranspose(ubo.view * ubo.model);
 
-        m_device.copyToMemory(m_uniformBufferMemory, ubo);
+        m_frameScheduler.updateBuffer(m_uniformBuffer, ubo);
     }
 
     template <vw::scene::VertexDescription VD>
     void CoordinatesDemo<VD>::drawFrame()
     {
-        m_queue.waitIdle();
         timing(false);
 
-        uint32_t imageIndex;
-        try
-        {
-            imageIndex = m_device.acquireNextImage(m_swapchain, m_imageAvailableSemaphore);
-        }
-        catch (const vk::OutOfDateKHRError &)
+        if (!m_frameScheduler.beginFrame(m_device, m_swapchain))
         {
             recreateSwapChain();
             return;
         }
 
-        m_queue.submit(m_commandBuffers[imageIndex], m_imageAvailableSemaphore, m_renderFinishedSemaphore, vk::PipelineStageFlagBits::eColorAttachmentOutput);
-        ImguiBaseDemo<VD>::drawFrame(imageIndex, m_renderFinishedSemaphore, m_renderImguiFinishedSemaphore);
+        const auto & frame{ m_frameScheduler.getFrame() };
+        m_frameScheduler.submit(m_device, m_queue, m_commandBuffers[m_frameScheduler.getImageIndex()], frame.imageAvailableSemaphore, frame.renderFinishedSemaphore, vk::PipelineStageFlagBits::eColorAttachmentOutput);
+        ImguiBaseDemo<VD>::drawFrame();
 
-        auto waitSemaphore{ *m_renderImguiFinishedSemaphore };
-        auto swapchain{ *reinterpret_cast<const vk::UniqueSwapchainKHR &>(m_swapchain) };
-        auto success{ m_queue.present(waitSemaphore, swapchain, imageIndex) };
-        if (!success)
+        if (!m_frameScheduler.endFrame(m_queue, m_swapchain, frame.overlayFinishedSemaphore))
         {
             recreateSwapChain();
         }
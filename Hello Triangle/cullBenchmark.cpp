@@ -0,0 +1,112 @@
+#include "cullBenchmark.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <limits>
+#include <malloc.h>
+#include <memory>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+#include <vw/camera.hpp>
+#include <vw/culling.hpp>
+
+namespace bmvk
+{
+    namespace
+    {
+        // The same operations in the same order as cullSpheres, so both agree on every sphere
+        size_t cullSpheresScalar(const std::array<glm::vec4, 6> & planes, const float * x, const float * y, const float * z, const float * radius, const size_t count, uint8_t * visible)
+        {
+            size_t numVisible = 0;
+            for (size_t i = 0; i < count; ++i)
+            {
+                auto inside{ true };
+                for (const auto & plane : planes)
+                {
+                    auto distance{ x[i] * plane.x + plane.w };
+                    distance = distance + y[i] * plane.y;
+                    distance = distance + z[i] * plane.z;
+                    inside = inside && distance >= -radius[i];
+                }
+
+                visible[i] = static_cast<uint8_t>(inside);
+                numVisible += visible[i];
+            }
+
+            return numVisible;
+        }
+
+        template<typename F>
+        double measureBest(const uint32_t runs, size_t & numVisible, const F & cull)
+        {
+            auto best{ std::chrono::steady_clock::duration::max() };
+            for (uint32_t i = 0; i < runs; ++i)
+            {
+                const auto start{ std::chrono::steady_clock::now() };
+                numVisible = cull();
+                best = std::min(best, std::chrono::steady_clock::now() - start);
+            }
+
+            return std::chrono::duration<double, std::milli>(best).count();
+        }
+    }
+
+    void runCullBenchmark(const uint32_t numSpheres, const uint32_t runs)
+    {
+        // Padded to whole batches like the instance bounds of the model repository, unused entries are never visible
+        const auto count{ (numSpheres + vw::util::k_cullBatchSize - 1) / vw::util::k_cullBatchSize * vw::util::k_cullBatchSize };
+        const std::unique_ptr<float, decltype(&_aligned_free)> bounds{ static_cast<float *>(_aligned_malloc(4 * count * sizeof(float), 32)), &_aligned_free };
+        if (!bounds)
+        {
+            throw std::runtime_error("sphere bounds pointer must not be null");
+        }
+
+        auto * x{ bounds.get() };
+        auto * y{ x + count };
+        auto * z{ y + count };
+        auto * radius{ z + count };
+        std::mt19937 generator{ 5489u };
+        std::uniform_real_distribution<float> position{ -60.f, 60.f };
+        std::uniform_real_distribution<float> size{ 0.5f, 2.f };
+        for (size_t i = 0; i < numSpheres; ++i)
+        {
+            x[i] = position(generator);
+            y[i] = position(generator);
+            z[i] = position(generator) - 20.f;
+            radius[i] = size(generator);
+        }
+        std::fill(x + numSpheres, x + count, 0.f);
+        std::fill(y + numSpheres, y + count, 0.f);
+        std::fill(z + numSpheres, z + count, 0.f);
+        std::fill(radius + numSpheres, radius + count, -std::numeric_limits<float>::infinity());
+
+        // The camera of the model repository demo
+        const vw::util::Camera camera{ { 0.f, 0.f, 25.f }, { 0.f, 0.f, -1.f }, { 0.f, 1.f, 0.f }, 45.f, 4.f / 3.f, 0.01f, std::numeric_limits<float>::infinity() };
+        const auto & planes{ camera.getFrustumPlanes() };
+
+        std::vector<uint8_t> scalarVisibility(count);
+        size_t scalarVisible;
+        const auto scalarTime{ measureBest(runs, scalarVisible, [&]()
+        {
+            return cullSpheresScalar(planes, x, y, z, radius, count, scalarVisibility.data());
+        }) };
+
+        std::vector<uint8_t> simdVisibility(count);
+        size_t simdVisible;
+        const auto simdTime{ measureBest(runs, simdVisible, [&]()
+        {
+            return vw::util::cullSpheres(planes, x, y, z, radius, count, simdVisibility.data());
+        }) };
+
+        if (scalarVisible != simdVisible || scalarVisibility != simdVisibility)
+        {
+            throw std::runtime_error("culling results differ");
+        }
+
+        std::cout << numSpheres << " spheres, " << simdVisible << " visible, " << vw::util::k_cullBatchSize << " per batch" << std::endl;
+        std::cout << "  scalar " << scalarTime << " ms, cullSpheres " << simdTime << " ms, " << scalarTime / simdTime << "x" << std::endl;
+    }
+}
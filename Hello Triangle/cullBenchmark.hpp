@@ -0,0 +1,10 @@
+#pragma once
+
+#include <cstdint>
+
+namespace bmvk
+{
+    // Culls randomly placed spheres against the frustum of the model repository demo with vw::util::cullSpheres and with a
+    // scalar loop doing the same comparisons, and prints the best time of each out of the given number of runs
+    void runCullBenchmark(const uint32_t numSpheres, const uint32_t runs);
+}
@@ -0,0 +1,176 @@
+#include "cullCheck.hpp"
+
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include <glm/glm.hpp>
+#include <glm/gtc/constants.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+
+#include <vw/bounds.hpp>
+#include <vw/camera.hpp>
+#include <vw/modelRepository.hpp>
+#include <vw/util.hpp>
+
+#include "bufferFactory.hpp"
+#include "instance.hpp"
+#include "shader.hpp"
+
+namespace bmvk
+{
+    namespace
+    {
+        constexpr auto k_vertexDescription{ vw::scene::VertexDescription::PositionNormalColor };
+        constexpr auto k_instanceFormat{ vw::util::InstanceFormat::Matrix };
+        const std::string K_CULL_SHADER_PATH{ "../shaders/modelRepositoryDemo/cull.comp.spv" };
+
+        // Instances closer to a plane than this are moved, the shader and the CPU culling may round differently there
+        constexpr auto k_planeMargin{ 1e-2f };
+
+        struct UniformBufferObject
+        {
+            glm::mat4 view;
+            glm::mat4 proj;
+        };
+
+        void createCube(std::vector<vw::scene::Vertex<k_vertexDescription>> & vertices, std::vector<uint32_t> & indices)
+        {
+            for (auto i = 0; i < 8; ++i)
+            {
+                const glm::vec3 pos{ i & 1 ? 1.f : -1.f, i & 2 ? 1.f : -1.f, i & 4 ? 1.f : -1.f };
+                vertices.push_back(vw::scene::Vertex<k_vertexDescription>{ pos, glm::normalize(pos), glm::vec3{ 1.f } });
+            }
+
+            indices = { 0, 2, 1, 1, 2, 3, 4, 5, 6, 5, 7, 6, 0, 1, 4, 1, 5, 4, 2, 6, 3, 3, 6, 7, 0, 4, 2, 2, 4, 6, 1, 3, 5, 3, 7, 5 };
+        }
+
+        bool isNearPlane(const std::array<glm::vec4, 6> & planes, const glm::vec4 & sphere)
+        {
+            for (const auto & plane : planes)
+            {
+                if (std::abs(glm::dot(glm::vec3(plane), glm::vec3(sphere)) + plane.w + sphere.w) < k_planeMargin)
+                {
+                    return true;
+                }
+            }
+
+            return false;
+        }
+    }
+
+    void runCullCheck(const uint32_t numInstances)
+    {
+        Instance instance{ "Cull Check", VK_MAKE_VERSION(1, 0, 0), "bmvk", VK_MAKE_VERSION(1, 0, 0), false };
+        auto device{ instance.getPhysicalDevice().createLogicalDevice(instance.getLayerNames(), false) };
+        const auto & vkDevice{ reinterpret_cast<const vk::UniqueDevice &>(device) };
+        const auto & physicalDevice{ reinterpret_cast<const vk::PhysicalDevice &>(instance.getPhysicalDevice()) };
+        const auto queue{ device.createQueue() };
+        const auto transferQueue{ device.createTransferQueue() };
+        const auto commandPool{ device.createCommandPool() };
+        vw::util::MemoryAllocator allocator{ vkDevice, physicalDevice };
+        BufferFactory bufferFactory{ device, allocator, queue, transferQueue };
+        vw::scene::ModelRepository<k_vertexDescription> repository{ vkDevice, physicalDevice, allocator, numInstances, 1, k_instanceFormat };
+        if (!repository.drawsIndirect())
+        {
+            throw std::runtime_error("culling requires drawIndirectFirstInstance");
+        }
+
+        std::vector<vw::scene::Vertex<k_vertexDescription>> vertices;
+        std::vector<uint32_t> indices;
+        createCube(vertices, indices);
+        const auto sphere{ vw::scene::computeBoundingSphere(vertices) };
+        const auto cubeResourceId{ repository.addResource(std::move(vertices), std::move(indices), vkDevice, allocator, bufferFactory.getUploadBatcher()) };
+        bufferFactory.waitIdle();
+
+        // The camera of the model repository demo, the instances are spread over a volume larger than its frustum
+        const vw::util::Camera camera{ { 0.f, 0.f, 25.f }, { 0.f, 0.f, -1.f }, { 0.f, 1.f, 0.f }, 45.f, 4.f / 3.f, 0.01f, std::numeric_limits<float>::infinity() };
+        const auto & planes{ camera.getFrustumPlanes() };
+        std::mt19937 generator{ 5489u };
+        std::uniform_real_distribution<float> position{ -60.f, 60.f };
+        std::uniform_real_distribution<float> angle{ 0.f, glm::two_pi<float>() };
+        const auto ids{ repository.createInstances(cubeResourceId, numInstances) };
+        for (const auto & id : ids)
+        {
+            glm::mat4 model;
+            do
+            {
+                const glm::vec3 translation{ position(generator), position(generator), position(generator) - 20.f };
+                const auto axis{ glm::normalize(glm::vec3{ position(generator), position(generator), position(generator) } + glm::vec3{ 0.f, 0.f, 1e-3f }) };
+                model = glm::rotate(glm::translate(glm::mat4{ 1.f }, translation), angle(generator), axis);
+            } while (isNearPlane(planes, glm::vec4{ glm::vec3(model * glm::vec4{ glm::vec3(sphere), 1.f }), sphere.w }));
+
+            repository.setModelMatrix(id, model);
+        }
+        repository.flushDynamicBuffer(vkDevice, 0);
+
+        // The shader extracts the planes from the matrices, the flipped y axis only swaps the top and bottom plane
+        vk::UniqueBuffer uniformBuffer;
+        vw::util::UniqueAllocation uniformBufferAllocation;
+        vw::util::createBuffer(vkDevice, allocator, sizeof(UniformBufferObject), vk::BufferUsageFlagBits::eUniformBuffer, vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent, uniformBuffer, uniformBufferAllocation, vw::util::MemoryUsage::Other);
+        UniformBufferObject ubo{ camera.getViewMatrix(), camera.getProjMatrix() };
+        ubo.proj[1][1] *= -1;
+        memcpy(uniformBufferAllocation->mapped, &ubo, sizeof(ubo));
+
+        std::vector<vk::DescriptorSetLayoutBinding> bindings{ { 0, vk::DescriptorType::eUniformBuffer, 1, vk::ShaderStageFlagBits::eCompute } };
+        for (uint32_t binding = 1; binding <= 6; ++binding)
+        {
+            bindings.emplace_back(binding, vk::DescriptorType::eStorageBuffer, 1, vk::ShaderStageFlagBits::eCompute);
+        }
+        const auto descriptorSetLayout{ device.createDescriptorSetLayout(bindings) };
+        std::vector<vk::DescriptorPoolSize> poolSizes{ { vk::DescriptorType::eUniformBuffer, 1 }, { vk::DescriptorType::eStorageBuffer, 6 } };
+        const auto descriptorPool{ device.createDescriptorPool(vk::DescriptorPoolCreateFlagBits::eFreeDescriptorSet, 1, poolSizes) };
+        const vk::DescriptorSetAllocateInfo allocInfo{ *descriptorPool, 1, &*descriptorSetLayout };
+        auto descriptorSets{ vkDevice->allocateDescriptorSetsUnique(allocInfo) };
+        const auto & descriptorSet{ descriptorSets[0] };
+
+        const vk::DescriptorBufferInfo uniformInfo{ *uniformBuffer, 0, sizeof(UniformBufferObject) };
+        const auto cullInfos{ repository.getCullingDescriptorBufferInfos(0) };
+        std::vector<vk::WriteDescriptorSet> writes{ WriteDescriptorSet{ descriptorSet, 0, 0, 1, vk::DescriptorType::eUniformBuffer, nullptr, &uniformInfo } };
+        for (size_t i = 0; i < cullInfos.size(); ++i)
+        {
+            writes.emplace_back(WriteDescriptorSet{ descriptorSet, static_cast<uint32_t>(i + 1), 0, 1, vk::DescriptorType::eStorageBuffer, nullptr, &cullInfos[i] });
+        }
+        device.updateDescriptorSets(writes);
+
+        const Shader cullShader{ K_CULL_SHADER_PATH, device };
+        const vk::PushConstantRange pushConstantRange{ vk::ShaderStageFlagBits::eCompute, 0, sizeof(uint32_t) };
+        const auto pipelineLayout{ device.createPipelineLayout({ *descriptorSetLayout }, { pushConstantRange }) };
+        const vk::SpecializationMapEntry formatEntry{ 0, 0, sizeof(vw::util::InstanceFormat) };
+        const vk::SpecializationInfo specializationInfo{ 1, &formatEntry, sizeof(k_instanceFormat), &k_instanceFormat };
+        const auto pipeline{ device.createComputePipeline(cullShader, pipelineLayout, &specializationInfo) };
+
+        // The culled commands are read back, the instance counts are the visible instances of each resource
+        const auto culledCommandsSize{ sizeof(vk::DrawIndexedIndirectCommand) };
+        vk::UniqueBuffer readbackBuffer;
+        vw::util::UniqueAllocation readbackBufferAllocation;
+        vw::util::createBuffer(vkDevice, allocator, culledCommandsSize, vk::BufferUsageFlagBits::eTransferDst, vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent, readbackBuffer, readbackBufferAllocation, vw::util::MemoryUsage::Other);
+
+        const auto cmdBuffer{ device.allocateCommandBuffer(commandPool) };
+        const auto & cb_vk{ reinterpret_cast<const vk::UniqueCommandBuffer &>(cmdBuffer) };
+        cmdBuffer.begin(vk::CommandBufferUsageFlagBits::eOneTimeSubmit);
+        cmdBuffer.bindPipeline(pipeline, vk::PipelineBindPoint::eCompute);
+        repository.cull(cb_vk, pipelineLayout, descriptorSet, 0);
+        const vk::BufferMemoryBarrier copyBarrier{ vk::AccessFlagBits::eShaderWrite, vk::AccessFlagBits::eTransferRead, VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED, cullInfos[4].buffer, 0, VK_WHOLE_SIZE };
+        cb_vk->pipelineBarrier(vk::PipelineStageFlagBits::eComputeShader, vk::PipelineStageFlagBits::eTransfer, {}, nullptr, copyBarrier, nullptr);
+        cb_vk->copyBuffer(cullInfos[4].buffer, *readbackBuffer, vk::BufferCopy{ 0, 0, culledCommandsSize });
+        const vk::BufferMemoryBarrier hostBarrier{ vk::AccessFlagBits::eTransferWrite, vk::AccessFlagBits::eHostRead, VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED, *readbackBuffer, 0, VK_WHOLE_SIZE };
+        cb_vk->pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eHost, {}, nullptr, hostBarrier, nullptr);
+        cmdBuffer.end();
+
+        const auto fence{ device.createFence() };
+        queue.submit(cmdBuffer, *fence);
+        vkDevice->waitForFences(*fence, VK_TRUE, std::numeric_limits<uint64_t>::max());
+
+        const auto gpuVisible{ static_cast<const vk::DrawIndexedIndirectCommand *>(readbackBufferAllocation->mapped)->instanceCount };
+        const auto cpuVisible{ repository.cull(planes) };
+        std::cout << "cull check: " << gpuVisible << " of " << numInstances << " visible on the gpu, " << cpuVisible << " on the cpu" << std::endl;
+        if (gpuVisible != cpuVisible)
+        {
+            throw std::runtime_error("gpu and cpu culling disagree");
+        }
+    }
+}
@@ -0,0 +1,11 @@
+#pragma once
+
+#include <cstdint>
+
+namespace bmvk
+{
+    // Culls randomly placed cubes with the culling shader of the model repository demo on a headless device, software
+    // implementations like lavapipe included, and compares the number of visible instances with the CPU culling. Throws
+    // if they differ.
+    void runCullCheck(const uint32_t numInstances);
+}
@@ -5,14 +5,18 @@
 namespace bmvk
 {
     template <vw::scene::VertexDescription VD>
-    Demo<VD>::Demo(const bool enableValidationLayers, const uint32_t width, const uint32_t height, std::string name, const DebugReport::ReportLevel reportLevel, const uint32_t maxModelRepositoryInstances)
+    Demo<VD>::Demo(const bool enableValidationLayers, const uint32_t width, const uint32_t height, std::string name, const DebugReport::ReportLevel reportLevel, const uint32_t initialModelRepositoryInstances, const vw::util::InstanceFormat instanceFormat)
       : m_window{ width, height, name },
         m_instance{ name, VK_MAKE_VERSION(1, 0, 0), "bmvk", VK_MAKE_VERSION(1, 0, 0), m_window, enableValidationLayers, reportLevel },
         m_device{ m_instance.getPhysicalDevice().createLogicalDevice(m_instance.getLayerNames()) },
         m_queue{ m_device.createQueue() },
+        m_transferQueue{ m_device.createTransferQueue() },
         m_commandPool{ m_device.createCommandPool() },
-        m_bufferFactory{ m_device, reinterpret_cast<const vk::PhysicalDevice &>(m_instance.getPhysicalDevice()) },
-        m_modelRepository{ reinterpret_cast<const vk::UniqueDevice &>(m_device), reinterpret_cast<const vk::PhysicalDevice &>(m_instance.getPhysicalDevice()), maxModelRepositoryInstances },
+        m_memoryAllocator{ std::make_unique<vw::util::MemoryAllocator>(reinterpret_cast<const vk::UniqueDevice &>(m_device), reinterpret_cast<const vk::PhysicalDevice &>(m_instance.getPhysicalDevice())) },
+        m_transientAttachments{ reinterpret_cast<const vk::UniqueDevice &>(m_device), *m_memoryAllocator },
+        m_frameScheduler{ m_device, *m_memoryAllocator, k_maxFramesInFlight },
+        m_bufferFactory{ m_device, *m_memoryAllocator, m_queue, m_transferQueue },
+        m_modelRepository{ reinterpret_cast<const vk::UniqueDevice &>(m_device), reinterpret_cast<const vk::PhysicalDevice &>(m_instance.getPhysicalDevice()), *m_memoryAllocator, initialModelRepositoryInstances, k_maxFramesInFlight, instanceFormat },
         m_nanosecondsPerTimestampIncrement{ m_instance.getPhysicalDevice().getProperties().limits.timestampPeriod },
         m_timepoint{ std::chrono::steady_clock::now() },
         m_timepointCount{ 0 },
@@ -21,52 +25,36 @@ namespace bmvk
     }
 
     template <vw::scene::VertexDescription VD>
-    void Demo<VD>::copyBuffer(vk::UniqueBuffer & srcBuffer, vk::UniqueBuffer & dstBuffer, vk::DeviceSize size) const
+    void Demo<VD>::copyBuffer(vk::UniqueBuffer & srcBuffer, vk::UniqueBuffer & dstBuffer, vk::DeviceSize size)
     {
-        auto cmdBuffer{ m_device.allocateCommandBuffer(m_commandPool) };
-        cmdBuffer.begin(vk::CommandBufferUsageFlagBits::eOneTimeSubmit);
-        cmdBuffer.copyBuffer(srcBuffer, dstBuffer, size);
-        cmdBuffer.end();
-        m_queue.submit(cmdBuffer);
-        m_queue.waitIdle();
+        // The caller releases the source right away, so only this batch is waited for instead of the whole queue
+        auto & uploads{ m_bufferFactory.getUploadBatcher() };
+        uploads.copyBuffer(srcBuffer, dstBuffer, size);
+        uploads.wait(uploads.submit());
     }
 
     template <vw::scene::VertexDescription VD>
-    void Demo<VD>::copyBufferToImage(vk::UniqueBuffer & buffer, vk::UniqueImage & image, uint32_t width, uint32_t height) const
+    void Demo<VD>::copyBufferToImage(vk::UniqueBuffer & buffer, vk::UniqueImage & image, uint32_t width, uint32_t height)
     {
-        auto cmdBuffer{ m_device.allocateCommandBuffer(m_commandPool) };
-        cmdBuffer.begin(vk::CommandBufferUsageFlagBits::eOneTimeSubmit);
-        vk::BufferImageCopy region{ 0, 0, 0, { vk::ImageAspectFlagBits::eColor, 0, 0, 1 }, {}, { width, height, 1 } };
-        cmdBuffer.copyBufferToImage(buffer, image, vk::ImageLayout::eTransferDstOptimal, region);
-        cmdBuffer.end();
-        m_queue.submit(cmdBuffer);
-        m_queue.waitIdle();
+        auto & uploads{ m_bufferFactory.getUploadBatcher() };
+        uploads.copyBufferToImage(buffer, image, width, height);
+        uploads.wait(uploads.submit());
     }
 
     template <vw::scene::VertexDescription VD>
-    void Demo<VD>::createBuffer(vk::DeviceSize size, vk::BufferUsageFlags usage, vk::MemoryPropertyFlags properties, vk::UniqueBuffer & buffer, vk::UniqueDeviceMemory & bufferMemory) const
+    void Demo<VD>::createBuffer(vk::DeviceSize size, vk::BufferUsageFlags usage, vk::MemoryPropertyFlags properties, vk::UniqueBuffer & buffer, vw::util::UniqueAllocation & bufferMemory) const
     {
         vk::BufferCreateInfo bufferInfo{ {}, size, usage };
         buffer = reinterpret_cast<const vk::UniqueDevice &>(m_device)->createBufferUnique(bufferInfo);
-
-        const auto memRequirements{ reinterpret_cast<const vk::UniqueDevice &>(m_device)->getBufferMemoryRequirements(*buffer) };
-        vk::MemoryAllocateInfo allocInfo{ memRequirements.size, m_instance.getPhysicalDevice().findMemoryType(memRequirements.memoryTypeBits, properties) };
-        bufferMemory = reinterpret_cast<const vk::UniqueDevice &>(m_device)->allocateMemoryUnique(allocInfo);
-
-        reinterpret_cast<const vk::UniqueDevice &>(m_device)->bindBufferMemory(*buffer, *bufferMemory, 0);
+        bufferMemory = m_memoryAllocator->allocateBufferMemory(buffer, properties, vw::util::toMemoryUsage(usage));
     }
 
     template <vw::scene::VertexDescription VD>
-    void Demo<VD>::createImage(uint32_t width, uint32_t height, vk::Format format, vk::ImageTiling tiling, vk::ImageUsageFlags usage, vk::MemoryPropertyFlags properties, vk::UniqueImage & image, vk::UniqueDeviceMemory & imageMemory)
+    void Demo<VD>::createImage(uint32_t width, uint32_t height, vk::Format format, vk::ImageTiling tiling, vk::ImageUsageFlags usage, vk::MemoryPropertyFlags properties, vk::UniqueImage & image, vw::util::UniqueAllocation & imageMemory)
     {
         vk::ImageCreateInfo imageInfo{ {}, vk::ImageType::e2D, format, { width, height, 1 }, 1, 1, vk::SampleCountFlagBits::e1, tiling, usage, vk::SharingMode::eExclusive };
         image = reinterpret_cast<const vk::UniqueDevice &>(m_device)->createImageUnique(imageInfo);
-
-        const auto memRequirements{ reinterpret_cast<const vk::UniqueDevice &>(m_device)->getImageMemoryRequirements(*image) };
-        vk::MemoryAllocateInfo allocInfo{ memRequirements.size, m_instance.getPhysicalDevice().findMemoryType(memRequirements.memoryTypeBits, properties) };
-        imageMemory = reinterpret_cast<const vk::UniqueDevice &>(m_device)->allocateMemoryUnique(allocInfo);
-
-        reinterpret_cast<const vk::UniqueDevice &>(m_device)->bindImageMemory(*image, *imageMemory, 0);
+        imageMemory = m_memoryAllocator->allocateImageMemory(image, properties, tiling, vw::util::toMemoryUsage(usage));
     }
 
     template <vw::scene::VertexDescription VD>
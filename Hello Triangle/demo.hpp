@@ -4,6 +4,8 @@
 #include <vulkan/vulkan.hpp>
 
 #include <vw/camera.hpp>
+#include <vw/memoryAllocator.hpp>
+#include <vw/transientAttachmentAllocator.hpp>
 #include <vw/window.hpp>
 #include <vw/modelRepository.hpp>
 
@@ -11,6 +13,7 @@
 #include "device.hpp"
 #include "queue.hpp"
 #include "bufferFactory.hpp"
+#include "frameScheduler.hpp"
 
 namespace bmvk
 {
@@ -18,7 +21,7 @@ namespace bmvk
     class Demo
     {
     public:
-        Demo(const bool enableValidationLayers, const uint32_t width, const uint32_t height, std::string name, const DebugReport::ReportLevel reportLevel, const uint32_t maxModelRepositoryInstances = 1024);
+        Demo(const bool enableValidationLayers, const uint32_t width, const uint32_t height, std::string name, const DebugReport::ReportLevel reportLevel, const uint32_t initialModelRepositoryInstances = 1024, const vw::util::InstanceFormat instanceFormat = vw::util::InstanceFormat::Matrix);
         Demo(const Demo &) = delete;
         Demo(Demo && other) = default;
         Demo & operator=(const Demo &) = delete;
@@ -30,13 +33,20 @@ namespace bmvk
         virtual void keyCallback(int key, int scancode, int action, int mods) {}
     protected:
         static const vw::scene::VertexDescription k_vertexDescription = VD;
+        static const uint32_t k_maxFramesInFlight = 2;
 
         vw::util::Camera m_camera;
         vw::util::Window m_window;
         Instance m_instance;
         Device m_device;
         Queue m_queue;
+        Queue m_transferQueue;
         vk::UniqueCommandPool m_commandPool;
+        // Held by pointer, allocations keep pointing at the allocator when the demo is moved
+        std::unique_ptr<vw::util::MemoryAllocator> m_memoryAllocator;
+        // Depth buffers and other attachments that are recreated with the swapchain
+        vw::util::TransientAttachmentAllocator m_transientAttachments;
+        FrameScheduler m_frameScheduler;
         BufferFactory m_bufferFactory;
 
         vw::scene::ModelRepository<VD> m_modelRepository;
@@ -45,12 +55,11 @@ namespace bmvk
         double m_avgFrameTime = 0.0;
         double m_avgFps = 0.0;
         float m_nanosecondsPerTimestampIncrement;
-        bool m_firstRender = true;
 
-        void copyBuffer(vk::UniqueBuffer & srcBuffer, vk::UniqueBuffer & dstBuffer, vk::DeviceSize size) const;
-        void copyBufferToImage(vk::UniqueBuffer & buffer, vk::UniqueImage & image, uint32_t width, uint32_t height) const;
-        void createBuffer(vk::DeviceSize size, vk::BufferUsageFlags usage, vk::MemoryPropertyFlags properties, vk::UniqueBuffer & buffer, vk::UniqueDeviceMemory & bufferMemory) const;
-        void createImage(uint32_t width, uint32_t height, vk::Format format, vk::ImageTiling tiling, vk::ImageUsageFlags usage, vk::MemoryPropertyFlags properties, vk::UniqueImage & image, vk::UniqueDeviceMemory & imageMemory);
+        void copyBuffer(vk::UniqueBuffer & srcBuffer, vk::UniqueBuffer & dstBuffer, vk::DeviceSize size);
+        void copyBufferToImage(vk::UniqueBuffer & buffer, vk::UniqueImage & image, uint32_t width, uint32_t height);
+        void createBuffer(vk::DeviceSize size, vk::BufferUsageFlags usage, vk::MemoryPropertyFlags properties, vk::UniqueBuffer & buffer, vw::util::UniqueAllocation & bufferMemory) const;
+        void createImage(uint32_t width, uint32_t height, vk::Format format, vk::ImageTiling tiling, vk::ImageUsageFlags usage, vk::MemoryPropertyFlags properties, vk::UniqueImage & image, vw::util::UniqueAllocation & imageMemory);
         vk::UniqueImageView createImageView(const vk::UniqueImage & image, vk::Format format, vk::ImageAspectFlags aspectFlags = vk::ImageAspectFlagBits::eColor) const;
         bool hasStencilComponent(const vk::Format format) const;
         void transitionImageLayout(const CommandBuffer & cmdBuffer, const vk::UniqueImage & image, vk::Format format, vk::ImageLayout oldLayout, vk::ImageLayout newLayout) const;
@@ -11,10 +11,7 @@ namespace bmvk
     template <vw::scene::VertexDescription VD>
     DepthBufferDemo<VD>::DepthBufferDemo(const bool enableValidationLayers, const uint32_t width, const uint32_t height)
         : ImguiBaseDemo{ enableValidationLayers, width, height, "DepthBuffer Demo", DebugReport::ReportLevel::WarningsAndAbove },
-        m_textureSampler{ m_device.createSampler(true) },
-        m_imageAvailableSemaphore{ m_device.createSemaphore() },
-        m_renderFinishedSemaphore{ m_device.createSemaphore() },
-        m_renderImguiFinishedSemaphore{ m_device.createSemaphore() }
+        m_textureSampler{ m_device.createSampler(true) }
     {
         createDescriptorSetLayout();
         createRenderPass();
@@ -24,6 +21,7 @@ namespace bmvk
         createTextureImage();
         createTextureImageView();
         createCombinedBuffer();
+        m_bufferFactory.getUploadBatcher().submit();
         createUniformBuffer();
         createDescriptorPool();
         createDescriptorSet();
@@ -33,6 +31,9 @@ namespace bmvk
     template <vw::scene::VertexDescription VD>
     void DepthBufferDemo<VD>::run()
     {
+        // The uploads have to be acquired by the queue before the first frame uses them
+        m_bufferFactory.waitIdle();
+
         while (!m_window.shouldClose())
         {
             /*
@@ -83,9 +84,6 @@ namespace bmvk
         }
 
         m_commandBuffers.clear();
-        m_depthImageView.reset(nullptr);
-        m_depthImageMemory.reset(nullptr);
-        m_depthImage.reset(nullptr);
         m_graphicsPipeline.reset(nullptr);
         m_pipelineLayout.reset(nullptr);
         m_renderPass.reset(nullptr);
@@ -117,7 +115,9 @@ namespace bmvk
         vk::AttachmentDescription depthAttachment{ {}, m_instance.getPhysicalDevice().findDepthFormat(), vk::SampleCountFlagBits::e1, vk::AttachmentLoadOp::eClear, vk::AttachmentStoreOp::eDontCare, vk::AttachmentLoadOp::eDontCare, vk::AttachmentStoreOp::eDontCare, vk::ImageLayout::eUndefined, vk::ImageLayout::eDepthStencilAttachmentOptimal };
         vk::AttachmentReference depthAttachmentRef{ 1, vk::ImageLayout::eDepthStencilAttachmentOptimal };
         vk::SubpassDescription subpass{ {}, vk::PipelineBindPoint::eGraphics, 0, nullptr, 1, &colorAttachmentRef, nullptr, &depthAttachmentRef };
-        vk::SubpassDependency dependency{ VK_SUBPASS_EXTERNAL, 0, vk::PipelineStageFlagBits::eColorAttachmentOutput, vk::PipelineStageFlagBits::eColorAttachmentOutput,{}, vk::AccessFlagBits::eColorAttachmentRead | vk::AccessFlagBits::eColorAttachmentWrite };
+        // The frames in flight share the depth image, so its clear waits for the depth writes of the previous frame
+        const auto stages{ vk::PipelineStageFlagBits::eColorAttachmentOutput | vk::PipelineStageFlagBits::eEarlyFragmentTests | vk::PipelineStageFlagBits::eLateFragmentTests };
+        vk::SubpassDependency dependency{ VK_SUBPASS_EXTERNAL, 0, stages, stages, vk::AccessFlagBits::eDepthStencilAttachmentWrite, vk::AccessFlagBits::eColorAttachmentRead | vk::AccessFlagBits::eColorAttachmentWrite | vk::AccessFlagBits::eDepthStencilAttachmentWrite };
         std::vector<vk::AttachmentDescription> vec{ colorAttachment, depthAttachment };
         RenderPassCreateInfo renderPassInfo{ {}, vec, subpass, dependency };
         m_renderPass = reinterpret_cast<const vk::UniqueDevice &>(m_device)->createRenderPassUnique(renderPassInfo);
@@ -158,7 +158,7 @@ namespace bmvk
         m_swapChainFramebuffers.clear();
         for (auto & uniqueImageView : m_swapchain.getImageViews())
         {
-            std::vector<vk::ImageView> imageViews{ *uniqueImageView, *m_depthImageView };
+            std::vector<vk::ImageView> imageViews{ *uniqueImageView, *m_transientAttachments.getImageView(m_depthAttachment) };
             m_swapChainFramebuffers.emplace_back(m_device.createFramebuffer(m_renderPass, imageViews, m_swapchain.getExtent().width, m_swapchain.getExtent().height, 1));
         }
     }
@@ -174,21 +174,10 @@ namespace bmvk
             throw std::runtime_error("failed to load texture image!");
         }
 
-        auto stagingBuffer{ m_bufferFactory.createStagingBuffer(imageSize) };
-        stagingBuffer.fill(pixels, imageSize);
-
-        stbi_image_free(pixels);
-
         createImage(texWidth, texHeight, vk::Format::eR8G8B8A8Unorm, vk::ImageTiling::eOptimal, vk::ImageUsageFlagBits::eTransferDst | vk::ImageUsageFlagBits::eSampled, vk::MemoryPropertyFlagBits::eDeviceLocal, m_textureImage, m_textureImageMemory);
 
-        auto cmdBuffer{ m_device.allocateCommandBuffer(m_commandPool) };
-        cmdBuffer.begin(vk::CommandBufferUsageFlagBits::eOneTimeSubmit);
-        transitionImageLayout(cmdBuffer, m_textureImage, vk::Format::eR8G8B8A8Unorm, vk::ImageLayout::eUndefined, vk::ImageLayout::eTransferDstOptimal);
-        stagingBuffer.buffer.copyToImage(cmdBuffer, m_textureImage, texWidth, texHeight);
-        transitionImageLayout(cmdBuffer, m_textureImage, vk::Format::eB8G8R8A8Unorm, vk::ImageLayout::eTransferDstOptimal, vk::ImageLayout::eShaderReadOnlyOptimal);
-        cmdBuffer.end();
-        m_queue.submit(cmdBuffer);
-        m_queue.waitIdle();
+        m_bufferFactory.getUploadBatcher().uploadImage(pixels, imageSize, m_textureImage, texWidth, texHeight);
+        stbi_image_free(pixels);
     }
 
     template <vw::scene::VertexDescription VD>
@@ -200,16 +189,10 @@ namespace bmvk
     template <vw::scene::VertexDescription VD>
     void DepthBufferDemo<VD>::createDepthResources()
     {
-        const auto depthFormat{ m_instance.getPhysicalDevice().findDepthFormat() };
-        createImage(m_swapchain.getExtent().width, m_swapchain.getExtent().height, depthFormat, vk::ImageTiling::eOptimal, vk::ImageUsageFlagBits::eDepthStencilAttachment, vk::MemoryPropertyFlagBits::eDeviceLocal, m_depthImage, m_depthImageMemory);
-        m_depthImageView = createImageView(m_depthImage, depthFormat, vk::ImageAspectFlagBits::eDepth);
-
-        auto cmdBuffer{ m_device.allocateCommandBuffer(m_commandPool) };
-        cmdBuffer.begin(vk::CommandBufferUsageFlagBits::eOneTimeSubmit);
-        transitionImageLayout(cmdBuffer, m_depthImage, depthFormat, vk::ImageLayout::eUndefined, vk::ImageLayout::eDepthStencilAttachmentOptimal);
-        cmdBuffer.end();
-        m_queue.submit(cmdBuffer);
-        m_queue.waitIdle();
+        // The render pass starts the depth attachment in undefined layout, so it needs no transition
+        m_transientAttachments.clear();
+        m_depthAttachment = m_transientAttachments.addAttachment(m_instance.getPhysicalDevice().findDepthFormat(), m_swapchain.getExtent(), vk::ImageUsageFlagBits::eDepthStencilAttachment, vk::ImageAspectFlagBits::eDepth);
+        m_transientAttachments.build();
     }
 
     template <vw::scene::VertexDescription VD>
@@ -218,11 +201,6 @@ namespace bmvk
         const auto vertexBufferSize{ sizeof vertices[0] * vertices.size() };
         const auto indexBufferSize{ sizeof indices[0] * indices.size() };
 
-        auto vertexStagingBuffer{ m_bufferFactory.createStagingBuffer(vertexBufferSize) };
-        vertexStagingBuffer.fill(vertices.data(), vertexBufferSize);
-        auto indexStagingBuffer{ m_bufferFactory.createStagingBuffer(indexBufferSize) };
-        indexStagingBuffer.fill(indices.data(), indexBufferSize);
-
         const auto vertexBufferUsageFlags{ vk::BufferUsageFlagBits::eTransferDst | vk::BufferUsageFlagBits::eVertexBuffer };
         const auto indexBufferUsageFlags{ vk::BufferUsageFlagBits::eTransferDst | vk::BufferUsageFlagBits::eIndexBuffer };
         const auto bufferMemoryPropertyFlags{ vk::MemoryPropertyFlagBits::eDeviceLocal };
@@ -254,21 +232,17 @@ namespace bmvk
         reinterpret_cast<const vk::UniqueDevice &>(m_device)->bindBufferMemory(*m_vertexBuffer, *m_combinedBufferMemory, 0);
         reinterpret_cast<const vk::UniqueDevice &>(m_device)->bindBufferMemory(*m_indexBuffer, *m_combinedBufferMemory, m_combinedBufferOffset);
 
-        auto cmdBuffer{ m_device.allocateCommandBuffer(m_commandPool) };
-        cmdBuffer.begin(vk::CommandBufferUsageFlagBits::eOneTimeSubmit);
-        vertexStagingBuffer.buffer.copyToBuffer(cmdBuffer, m_vertexBuffer, vertexBufferSize);
-        indexStagingBuffer.buffer.copyToBuffer(cmdBuffer, m_indexBuffer, indexBufferSize);
-        cmdBuffer.end();
-        m_queue.submit(cmdBuffer);
-        m_queue.waitIdle();
+        auto & uploads{ m_bufferFactory.getUploadBatcher() };
+        uploads.uploadBuffer(vertices.data(), vertexBufferSize, m_vertexBuffer);
+        uploads.uploadBuffer(indices.data(), indexBufferSize, m_indexBuffer);
     }
 
     template <vw::scene::VertexDescription VD>
     void DepthBufferDemo<VD>::createUniformBuffer()
     {
         const auto bufferSize{ sizeof(UniformBufferObject) };
-        const auto uniformBufferUsageFlags{ vk::BufferUsageFlagBits::eUniformBuffer };
-        const auto uniformBufferMemoryPropertyFlags{ vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent };
+        const auto uniformBufferUsageFlags{ vk::BufferUsageFlagBits::eUniformBuffer | vk::BufferUsageFlagBits::eTransferDst };
+        const auto uniformBufferMemoryPropertyFlags{ vk::MemoryPropertyFlagBits::eDeviceLocal };
         createBuffer(bufferSize, uniformBufferUsageFlags, uniformBufferMemoryPropertyFlags, m_uniformBuffer, m_uniformBufferMemory);
     }
 
@@ -331,33 +305,25 @@ namespace bmvk
         ubo.proj = glm::perspective(glm::radians(45.f), m_swapchain.getRatio(), 0.1f, 10.f);
         ubo.proj[1][1] *= -1;
 
-        m_device.copyToMemory(m_uniformBufferMemory, ubo);
+        m_frameScheduler.updateBuffer(m_uniformBuffer, ubo);
     }
 
     template <vw::scene::VertexDescription VD>
     void DepthBufferDemo<VD>::drawFrame()
     {
-        m_queue.waitIdle();
         timing(false);
 
-        uint32_t imageIndex;
-        try
-        {
-            imageIndex = m_device.acquireNextImage(m_swapchain, m_imageAvailableSemaphore);
-        }
-        catch (const vk::OutOfDateKHRError &)
+        if (!m_frameScheduler.beginFrame(m_device, m_swapchain))
         {
             recreateSwapChain();
             return;
         }
 
-        m_queue.submit(m_commandBuffers[imageIndex], m_imageAvailableSemaphore, m_renderFinishedSemaphore, vk::PipelineStageFlagBits::eColorAttachmentOutput);
-        ImguiBaseDemo<VD>::drawFrame(imageIndex, m_renderFinishedSemaphore, m_renderImguiFinishedSemaphore);
+        const auto & frame{ m_frameScheduler.getFrame() };
+        m_frameScheduler.submit(m_device, m_queue, m_commandBuffers[m_frameScheduler.getImageIndex()], frame.imageAvailableSemaphore, frame.renderFinishedSemaphore, vk::PipelineStageFlagBits::eColorAttachmentOutput);
+        ImguiBaseDemo<VD>::drawFrame();
 
-        auto waitSemaphore{ *m_renderImguiFinishedSemaphore };
-        auto swapchain{ *reinterpret_cast<const vk::UniqueSwapchainKHR &>(m_swapchain) };
-        auto success{ m_queue.present(waitSemaphore, swapchain, imageIndex) };
-        if (!success)
+        if (!m_frameScheduler.endFrame(m_queue, m_swapchain, frame.overlayFinishedSemaphore))
         {
             recreateSwapChain();
         }
@@ -5,9 +5,10 @@
 
 namespace bmvk
 {
-    Device::Device(vk::UniqueDevice && device, const uint32_t queueFamilyIndex)
+    Device::Device(vk::UniqueDevice && device, const uint32_t queueFamilyIndex, const uint32_t transferQueueFamilyIndex)
       : m_device{ std::move(device) },
-        m_queueFamilyIndex{ queueFamilyIndex }
+        m_queueFamilyIndex{ queueFamilyIndex },
+        m_transferQueueFamilyIndex{ transferQueueFamilyIndex }
     {
     }
 
@@ -16,6 +17,11 @@ namespace bmvk
         return Queue(m_device->getQueue(m_queueFamilyIndex, 0));
     }
 
+    Queue Device::createTransferQueue() const
+    {
+        return Queue(m_device->getQueue(m_transferQueueFamilyIndex, 0));
+    }
+
     vk::UniqueImageView Device::createImageView(vk::ImageViewCreateInfo info) const
     {
         return m_device->createImageViewUnique(info);
@@ -38,9 +44,14 @@ namespace bmvk
         return m_device->createSemaphoreUnique(vk::SemaphoreCreateInfo());
     }
 
-    vk::UniqueCommandPool Device::createCommandPool() const
+    vk::UniqueFence Device::createFence(const bool signaled) const
+    {
+        return m_device->createFenceUnique({ signaled ? vk::FenceCreateFlagBits::eSignaled : vk::FenceCreateFlags() });
+    }
+
+    vk::UniqueCommandPool Device::createCommandPool(const vk::CommandPoolCreateFlags flags) const
     {
-        vk::CommandPoolCreateInfo poolInfo{ {}, m_queueFamilyIndex };
+        vk::CommandPoolCreateInfo poolInfo{ flags, m_queueFamilyIndex };
         return m_device->createCommandPoolUnique(poolInfo);
     }
 
@@ -89,6 +100,17 @@ namespace bmvk
         return m_device->createPipelineLayoutUnique(info);
     }
 
+    vk::UniquePipeline Device::createComputePipeline(const Shader & shader, const vk::UniquePipelineLayout & layout, const vk::SpecializationInfo * specializationInfo) const
+    {
+        const vk::ComputePipelineCreateInfo info{ {}, shader.createPipelineShaderStageCreateInfo(vk::ShaderStageFlagBits::eCompute, specializationInfo), *layout };
+        return m_device->createComputePipelineUnique(nullptr, info);
+    }
+
+    MappedBuffer Device::createMappedBuffer(vw::util::MemoryAllocator & allocator, const vk::DeviceSize size, const vk::BufferUsageFlags usage, const vw::util::MemoryUsage memoryUsage) const
+    {
+        return MappedBuffer{ m_device, allocator, size, usage, memoryUsage };
+    }
+
     void * Device::mapMemory(const vk::UniqueDeviceMemory & memory, const vk::DeviceSize size, const vk::DeviceSize offset, const vk::MemoryMapFlags flags) const
     {
         return m_device->mapMemory(*memory, offset, size, flags);
@@ -99,13 +121,6 @@ namespace bmvk
         m_device->unmapMemory(*memory);
     }
 
-    void Device::copyToMemory(const vk::UniqueDeviceMemory & memory, const void * const objPtr, size_t objSize) const
-    {
-        auto data{ mapMemory(memory, objSize) };
-        memcpy(data, objPtr, objSize);
-        unmapMemory(memory);
-    }
-
     uint32_t Device::acquireNextImage(const Swapchain & swapchain, OptRefSemaphore semaphore, OptRefFence fence) const
     {
         return m_device->acquireNextImageKHR(*reinterpret_cast<const vk::UniqueSwapchainKHR &>(swapchain), std::numeric_limits<uint64_t>::max(), semaphore, fence).value;
@@ -16,10 +16,7 @@ namespace bmvk
 
     template <vw::scene::VertexDescription VD>
     DragonDemo<VD>::DragonDemo(const bool enableValidationLayers, const uint32_t width, const uint32_t height)
-        : ImguiBaseDemo{ enableValidationLayers, width, height, "Dragon Demo", DebugReport::ReportLevel::WarningsAndAbove },
-        m_imageAvailableSemaphore{ m_device.createSemaphore() },
-        m_renderFinishedSemaphore{ m_device.createSemaphore() },
-        m_renderImguiFinishedSemaphore{ m_device.createSemaphore() }
+        : ImguiBaseDemo{ enableValidationLayers, width, height, "Dragon Demo", DebugReport::ReportLevel::WarningsAndAbove }
     {
         setupCamera();
 
@@ -29,6 +26,7 @@ namespace bmvk
         createDepthResources();
         createFramebuffers();
         loadModel(K_MODEL_PATH);
+        m_bufferFactory.getUploadBatcher().submit();
         createUniformBuffer();
         createDescriptorPool();
         createDescriptorSet();
@@ -38,6 +36,9 @@ namespace bmvk
     template <vw::scene::VertexDescription VD>
     void DragonDemo<VD>::run()
     {
+        // The uploads have to be acquired by the queue before the first frame uses them
+        m_bufferFactory.waitIdle();
+
         while (!m_window.shouldClose())
         {
             /*
@@ -53,9 +54,18 @@ namespace bmvk
             // Tip: if we don't call ImGui::Begin()/ImGui::End() the widgets appears in a window automatically called "Debug"
             {
                 ImGui::SetNextWindowPos(ImVec2(20, 20));
-                ImGui::SetNextWindowSize(ImVec2(400, 50), ImGuiCond_Always);
+                ImGui::SetNextWindowSize(ImVec2(400, 80), ImGuiCond_Always);
                 ImGui::Begin("Performance");
                 ImGui::Text("Application average %.3f ms/frame (%.1f FPS)", m_avgFrameTime / 1000.0, m_avgFps);
+                if (m_optimizationStatistics)
+                {
+                    const auto & statistics{ *m_optimizationStatistics };
+                    ImGui::Text("Vertex cache ACMR %.3f -> %.3f, ATVR %.3f -> %.3f", statistics.before.acmr, statistics.after.acmr, statistics.before.atvr, statistics.after.atvr);
+                }
+                else
+                {
+                    ImGui::Text("Vertex cache optimized on import, loaded from the mesh cache");
+                }
                 ImGui::End();
             }
 
@@ -88,9 +98,6 @@ namespace bmvk
         }
 
         m_commandBuffers.clear();
-        m_depthImageView.reset(nullptr);
-        m_depthImage.reset(nullptr);
-        m_depthImageMemory.reset(nullptr);
         m_graphicsPipeline.reset(nullptr);
         m_pipelineLayout.reset(nullptr);
         m_renderPass.reset(nullptr);
@@ -129,7 +136,9 @@ namespace bmvk
         vk::AttachmentDescription depthAttachment{ {}, m_instance.getPhysicalDevice().findDepthFormat(), vk::SampleCountFlagBits::e1, vk::AttachmentLoadOp::eClear, vk::AttachmentStoreOp::eDontCare, vk::AttachmentLoadOp::eDontCare, vk::AttachmentStoreOp::eDontCare, vk::ImageLayout::eUndefined, vk::ImageLayout::eDepthStencilAttachmentOptimal };
         vk::AttachmentReference depthAttachmentRef{ 1, vk::ImageLayout::eDepthStencilAttachmentOptimal };
         vk::SubpassDescription subpass{ {}, vk::PipelineBindPoint::eGraphics, 0, nullptr, 1, &colorAttachmentRef, nullptr, &depthAttachmentRef };
-        vk::SubpassDependency dependency{ VK_SUBPASS_EXTERNAL, 0, vk::PipelineStageFlagBits::eColorAttachmentOutput, vk::PipelineStageFlagBits::eColorAttachmentOutput,{}, vk::AccessFlagBits::eColorAttachmentRead | vk::AccessFlagBits::eColorAttachmentWrite };
+        // The frames in flight share the depth image, so its clear waits for the depth writes of the previous frame
+        const auto stages{ vk::PipelineStageFlagBits::eColorAttachmentOutput | vk::PipelineStageFlagBits::eEarlyFragmentTests | vk::PipelineStageFlagBits::eLateFragmentTests };
+        vk::SubpassDependency dependency{ VK_SUBPASS_EXTERNAL, 0, stages, stages, vk::AccessFlagBits::eDepthStencilAttachmentWrite, vk::AccessFlagBits::eColorAttachmentRead | vk::AccessFlagBits::eColorAttachmentWrite | vk::AccessFlagBits::eDepthStencilAttachmentWrite };
         std::vector<vk::AttachmentDescription> vec{ colorAttachment, depthAttachment };
         RenderPassCreateInfo renderPassInfo{ {}, vec, subpass, dependency };
         m_renderPass = reinterpret_cast<const vk::UniqueDevice &>(m_device)->createRenderPassUnique(renderPassInfo);
@@ -168,7 +177,7 @@ namespace bmvk
         m_swapChainFramebuffers.clear();
         for (auto & uniqueImageView : m_swapchain.getImageViews())
         {
-            std::vector<vk::ImageView> imageViews{ *uniqueImageView, *m_depthImageView };
+            std::vector<vk::ImageView> imageViews{ *uniqueImageView, *m_transientAttachments.getImageView(m_depthAttachment) };
             m_swapChainFramebuffers.emplace_back(m_device.createFramebuffer(m_renderPass, imageViews, m_swapchain.getExtent().width, m_swapchain.getExtent().height, 1));
         }
     }
@@ -177,33 +186,28 @@ namespace bmvk
     void DragonDemo<VD>::loadModel(std::string_view file)
     {
         vw::scene::ModelLoader<VD> ml;
-        m_dragonModel = ml.loadModel(file, vw::scene::ModelLoader<VD>::NormalCreation::AssimpSmoothNormals);
+        m_dragonModel = ml.loadModel(file, vw::scene::ModelLoader<VD>::NormalCreation::AssimpSmoothNormals, true);
+        m_optimizationStatistics = ml.getOptimizationStatistics();
         m_dragonModel.scale(glm::vec3{ 0.1f });
 
-        m_dragonModel.createBuffers(reinterpret_cast<const vk::UniqueDevice &>(m_device), static_cast<vk::PhysicalDevice>(m_instance.getPhysicalDevice()), m_commandPool, static_cast<vk::Queue>(m_queue));
+        m_dragonModel.createBuffers(reinterpret_cast<const vk::UniqueDevice &>(m_device), *m_memoryAllocator, m_bufferFactory.getUploadBatcher());
     }
 
     template <vw::scene::VertexDescription VD>
     void DragonDemo<VD>::createDepthResources()
     {
-        const auto depthFormat{ m_instance.getPhysicalDevice().findDepthFormat() };
-        createImage(m_swapchain.getExtent().width, m_swapchain.getExtent().height, depthFormat, vk::ImageTiling::eOptimal, vk::ImageUsageFlagBits::eDepthStencilAttachment, vk::MemoryPropertyFlagBits::eDeviceLocal, m_depthImage, m_depthImageMemory);
-        m_depthImageView = createImageView(m_depthImage, depthFormat, vk::ImageAspectFlagBits::eDepth);
-
-        auto cmdBuffer{ m_device.allocateCommandBuffer(m_commandPool) };
-        cmdBuffer.begin(vk::CommandBufferUsageFlagBits::eOneTimeSubmit);
-        transitionImageLayout(cmdBuffer, m_depthImage, depthFormat, vk::ImageLayout::eUndefined, vk::ImageLayout::eDepthStencilAttachmentOptimal);
-        cmdBuffer.end();
-        m_queue.submit(cmdBuffer);
-        m_queue.waitIdle();
+        // The render pass starts the depth attachment in undefined layout, so it needs no transition
+        m_transientAttachments.clear();
+        m_depthAttachment = m_transientAttachments.addAttachment(m_instance.getPhysicalDevice().findDepthFormat(), m_swapchain.getExtent(), vk::ImageUsageFlagBits::eDepthStencilAttachment, vk::ImageAspectFlagBits::eDepth);
+        m_transientAttachments.build();
     }
 
     template <vw::scene::VertexDescription VD>
     void DragonDemo<VD>::createUniformBuffer()
     {
         const auto bufferSize{ sizeof(UniformBufferObject) };
-        const auto uniformBufferUsageFlags{ vk::BufferUsageFlagBits::eUniformBuffer };
-        const auto uniformBufferMemoryPropertyFlags{ vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent };
+        const auto uniformBufferUsageFlags{ vk::BufferUsageFlagBits::eUniformBuffer | vk::BufferUsageFlagBits::eTransferDst };
+        const auto uniformBufferMemoryPropertyFlags{ vk::MemoryPropertyFlagBits::eDeviceLocal };
         createBuffer(bufferSize, uniformBufferUsageFlags, uniformBufferMemoryPropertyFlags, m_uniformBuffer, m_uniformBufferMemory);
     }
 
@@ -265,33 +269,25 @@ namespace bmvk
         ubo.proj[1][1] *= -1;
         ubo.normal = glm::inverseTranspose(ubo.view * ubo.model);
 
-        m_device.copyToMemory(m_uniformBufferMemory, ubo);
+        m_frameScheduler.updateBuffer(m_uniformBuffer, ubo);
     }
 
     template <vw::scene::VertexDescription VD>
     void DragonDemo<VD>::drawFrame()
     {
-        m_queue.waitIdle();
         timing(false);
 
-        uint32_t imageIndex;
-        try
-        {
-            imageIndex = m_device.acquireNextImage(m_swapchain, m_imageAvailableSemaphore);
-        }
-        catch (const vk::OutOfDateKHRError &)
+        if (!m_frameScheduler.beginFrame(m_device, m_swapchain))
         {
             recreateSwapChain();
             return;
         }
 
-        m_queue.submit(m_commandBuffers[imageIndex], m_imageAvailableSemaphore, m_renderFinishedSemaphore, vk::PipelineStageFlagBits::eColorAttachmentOutput);
-        ImguiBaseDemo<VD>::drawFrame(imageIndex, m_renderFinishedSemaphore, m_renderImguiFinishedSemaphore);
+        const auto & frame{ m_frameScheduler.getFrame() };
+        m_frameScheduler.submit(m_device, m_queue, m_commandBuffers[m_frameScheduler.getImageIndex()], frame.imageAvailableSemaphore, frame.renderFinishedSemaphore, vk::PipelineStageFlagBits::eColorAttachmentOutput);
+        ImguiBaseDemo<VD>::drawFrame();
 
-        auto waitSemaphore{ *m_renderImguiFinishedSemaphore };
-        auto swapchain{ *reinterpret_cast<const vk::UniqueSwapchainKHR &>(m_swapchain) };
-        auto success{ m_queue.present(waitSemaphore, swapchain, imageIndex) };
-        if (!success)
+        if (!m_frameScheduler.endFrame(m_queue, m_swapchain, frame.overlayFinishedSemaphore))
         {
             recreateSwapChain();
         }
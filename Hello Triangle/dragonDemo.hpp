@@ -5,6 +5,9 @@
 #include <glm/glm.hpp>
 #include <glm/gtx/hash.hpp>
 
+#include <optional>
+
+#include <vw/meshOptimizer.hpp>
 #include <vw/model.hpp>
 
 #include "imguiBaseDemo.hpp"
@@ -37,21 +40,17 @@ namespace bmvk
         vk::UniquePipeline m_graphicsPipeline;
         std::vector<vk::UniqueFramebuffer> m_swapChainFramebuffers;
 
-        vk::UniqueDeviceMemory m_depthImageMemory;
-        vk::UniqueImage m_depthImage;
-        vk::UniqueImageView m_depthImageView;
+        vw::util::TransientAttachmentAllocator::AttachmentId m_depthAttachment = 0;
 
-        vk::UniqueDeviceMemory m_uniformBufferMemory;
+        vw::util::UniqueAllocation m_uniformBufferMemory;
         vk::UniqueBuffer m_uniformBuffer;
 
         vk::UniqueDescriptorPool m_descriptorPool;
         std::vector<vk::UniqueDescriptorSet> m_descriptorSets;
         std::vector<CommandBuffer> m_commandBuffers;
-        vk::UniqueSemaphore m_imageAvailableSemaphore;
-        vk::UniqueSemaphore m_renderFinishedSemaphore;
-        vk::UniqueSemaphore m_renderImguiFinishedSemaphore;
 
         vw::scene::Model<VD> m_dragonModel;
+        std::optional<vw::scene::MeshOptimizationStatistics> m_optimizationStatistics;
 
         void setupCamera();
 
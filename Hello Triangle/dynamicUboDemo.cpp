@@ -32,10 +32,7 @@ namespace bmvk
 
     template <vw::scene::VertexDescription VD>
     DynamicUboDemo<VD>::DynamicUboDemo(const bool enableValidationLayers, const uint32_t width, const uint32_t height)
-        : ImguiBaseDemo{ enableValidationLayers, width, height, "DynamicUbo Demo", DebugReport::ReportLevel::WarningsAndAbove },
-        m_imageAvailableSemaphore{ m_device.createSemaphore() },
-        m_renderFinishedSemaphore{ m_device.createSemaphore() },
-        m_renderImguiFinishedSemaphore{ m_device.createSemaphore() }
+        : ImguiBaseDemo{ enableValidationLayers, width, height, "DynamicUbo Demo", DebugReport::ReportLevel::WarningsAndAbove }
     {
         setupCamera();
 
@@ -45,6 +42,7 @@ namespace bmvk
         createDepthResources();
         createFramebuffers();
         loadCube();
+        m_bufferFactory.getUploadBatcher().submit();
         createUniformBuffer();
         createDynamicUniformBuffer();
         createDescriptorPool();
@@ -61,6 +59,9 @@ namespace bmvk
     template <vw::scene::VertexDescription VD>
     void DynamicUboDemo<VD>::run()
     {
+        // The uploads have to be acquired by the queue before the first frame uses them
+        m_bufferFactory.waitIdle();
+
         while (!m_window.shouldClose())
         {
             /*
@@ -116,9 +117,6 @@ namespace bmvk
         }
 
         m_commandBuffers.clear();
-        m_depthImageView.reset(nullptr);
-        m_depthImage.reset(nullptr);
-        m_depthImageMemory.reset(nullptr);
         m_pipeline.reset(nullptr);
         m_pipelineLayout.reset(nullptr);
         m_renderPass.reset(nullptr);
@@ -157,7 +155,9 @@ namespace bmvk
         vk::AttachmentDescription depthAttachment{ {}, m_instance.getPhysicalDevice().findDepthFormat(), vk::SampleCountFlagBits::e1, vk::AttachmentLoadOp::eClear, vk::AttachmentStoreOp::eDontCare, vk::AttachmentLoadOp::eDontCare, vk::AttachmentStoreOp::eDontCare, vk::ImageLayout::eUndefined, vk::ImageLayout::eDepthStencilAttachmentOptimal };
         vk::AttachmentReference depthAttachmentRef{ 1, vk::ImageLayout::eDepthStencilAttachmentOptimal };
         vk::SubpassDescription subpass{ {}, vk::PipelineBindPoint::eGraphics, 0, nullptr, 1, &colorAttachmentRef, nullptr, &depthAttachmentRef };
-        vk::SubpassDependency dependency{ VK_SUBPASS_EXTERNAL, 0, vk::PipelineStageFlagBits::eColorAttachmentOutput, vk::PipelineStageFlagBits::eColorAttachmentOutput,{}, vk::AccessFlagBits::eColorAttachmentRead | vk::AccessFlagBits::eColorAttachmentWrite };
+        // The frames in flight share the depth image, so its clear waits for the depth writes of the previous frame
+        const auto stages{ vk::PipelineStageFlagBits::eColorAttachmentOutput | vk::PipelineStageFlagBits::eEarlyFragmentTests | vk::PipelineStageFlagBits::eLateFragmentTests };
+        vk::SubpassDependency dependency{ VK_SUBPASS_EXTERNAL, 0, stages, stages, vk::AccessFlagBits::eDepthStencilAttachmentWrite, vk::AccessFlagBits::eColorAttachmentRead | vk::AccessFlagBits::eColorAttachmentWrite | vk::AccessFlagBits::eDepthStencilAttachmentWrite };
         std::vector<vk::AttachmentDescription> vec{ colorAttachment, depthAttachment };
         RenderPassCreateInfo renderPassInfo{ {}, vec, subpass, dependency };
         m_renderPass = reinterpret_cast<const vk::UniqueDevice &>(m_device)->createRenderPassUnique(renderPassInfo);
@@ -198,7 +198,7 @@ namespace bmvk
         m_swapChainFramebuffers.clear();
         for (auto & uniqueImageView : m_swapchain.getImageViews())
         {
-            std::vector<vk::ImageView> imageViews{ *uniqueImageView, *m_depthImageView };
+            std::vector<vk::ImageView> imageViews{ *uniqueImageView, *m_transientAttachments.getImageView(m_depthAttachment) };
             m_swapChainFramebuffers.emplace_back(m_device.createFramebuffer(m_renderPass, imageViews, m_swapchain.getExtent().width, m_swapchain.getExtent().height, 1));
         }
     }
@@ -241,30 +241,24 @@ namespace bmvk
         // down
         createSide(m_cube, { 0.f, -1.f, 0.f }, { -1.f, -1.f, -1.f }, { 1.f, -1.f, -1.f }, { 1.f, -1.f, 1.f }, { -1.f, -1.f, 1.f }, 20);
 
-        m_cube.createBuffers(reinterpret_cast<const vk::UniqueDevice &>(m_device), static_cast<vk::PhysicalDevice>(m_instance.getPhysicalDevice()), m_commandPool, static_cast<vk::Queue>(m_queue));
+        m_cube.createBuffers(reinterpret_cast<const vk::UniqueDevice &>(m_device), *m_memoryAllocator, m_bufferFactory.getUploadBatcher());
     }
 
     template <vw::scene::VertexDescription VD>
     void DynamicUboDemo<VD>::createDepthResources()
     {
-        const auto depthFormat{ m_instance.getPhysicalDevice().findDepthFormat() };
-        createImage(m_swapchain.getExtent().width, m_swapchain.getExtent().height, depthFormat, vk::ImageTiling::eOptimal, vk::ImageUsageFlagBits::eDepthStencilAttachment, vk::MemoryPropertyFlagBits::eDeviceLocal, m_depthImage, m_depthImageMemory);
-        m_depthImageView = createImageView(m_depthImage, depthFormat, vk::ImageAspectFlagBits::eDepth);
-
-        auto cmdBuffer{ m_device.allocateCommandBuffer(m_commandPool) };
-        cmdBuffer.begin(vk::CommandBufferUsageFlagBits::eOneTimeSubmit);
-        transitionImageLayout(cmdBuffer, m_depthImage, depthFormat, vk::ImageLayout::eUndefined, vk::ImageLayout::eDepthStencilAttachmentOptimal);
-        cmdBuffer.end();
-        m_queue.submit(cmdBuffer);
-        m_queue.waitIdle();
+        // The render pass starts the depth attachment in undefined layout, so it needs no transition
+        m_transientAttachments.clear();
+        m_depthAttachment = m_transientAttachments.addAttachment(m_instance.getPhysicalDevice().findDepthFormat(), m_swapchain.getExtent(), vk::ImageUsageFlagBits::eDepthStencilAttachment, vk::ImageAspectFlagBits::eDepth);
+        m_transientAttachments.build();
     }
 
     template <vw::scene::VertexDescription VD>
     void DynamicUboDemo<VD>::createUniformBuffer()
     {
         const auto bufferSize{ sizeof(UniformBufferObject) };
-        const auto uniformBufferUsageFlags{ vk::BufferUsageFlagBits::eUniformBuffer };
-        const auto uniformBufferMemoryPropertyFlags{ vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent };
+        const auto uniformBufferUsageFlags{ vk::BufferUsageFlagBits::eUniformBuffer | vk::BufferUsageFlagBits::eTransferDst };
+        const auto uniformBufferMemoryPropertyFlags{ vk::MemoryPropertyFlagBits::eDeviceLocal };
         createBuffer(bufferSize, uniformBufferUsageFlags, uniformBufferMemoryPropertyFlags, m_uniformBuffer, m_uniformBufferMemory);
     }
 
@@ -286,7 +280,7 @@ namespace bmvk
             throw std::runtime_error("model must not be null");
         }
 
-        createBuffer(bufferSize, vk::BufferUsageFlagBits::eUniformBuffer, vk::MemoryPropertyFlagBits::eHostVisible, m_dynamicUniformBuffer, m_dynamicUniformBufferMemory);
+        createBuffer(bufferSize, vk::BufferUsageFlagBits::eUniformBuffer | vk::BufferUsageFlagBits::eTransferDst, vk::MemoryPropertyFlagBits::eDeviceLocal, m_dynamicUniformBuffer, m_dynamicUniformBufferMemory);
 
         std::default_random_engine rndEngine(static_cast<unsigned int>(time(nullptr)));
         std::normal_distribution<float> rndDist(-1.0f, 1.0f);
@@ -366,7 +360,7 @@ namespace bmvk
         ubo.proj = m_camera.getProjMatrix();
         ubo.proj[1][1] *= -1;
 
-        m_device.copyToMemory(m_uniformBufferMemory, ubo);
+        m_frameScheduler.updateBuffer(m_uniformBuffer, ubo);
     }
 
     template <vw::scene::VertexDescription VD>
@@ -410,37 +404,25 @@ namespace bmvk
         m_animationTimer = 0.0f;
 
         const auto bufSize{ k_maxObjectInstances * m_dynamicAlignment };
-        auto data{ m_device.mapMemory(m_dynamicUniformBufferMemory, bufSize) };
-        memcpy(data, m_dynamicUniformBufferObject.model, bufSize);
-        vk::MappedMemoryRange mmr{ *m_dynamicUniformBufferMemory, 0, bufSize };
-        reinterpret_cast<const vk::UniqueDevice &>(m_device)->flushMappedMemoryRanges(mmr);
-        m_device.unmapMemory(m_dynamicUniformBufferMemory);
+        m_frameScheduler.updateBuffer(m_dynamicUniformBuffer, m_dynamicUniformBufferObject.model, bufSize);
     }
 
     template <vw::scene::VertexDescription VD>
     void DynamicUboDemo<VD>::drawFrame()
     {
-        m_queue.waitIdle();
         timing(false);
 
-        uint32_t imageIndex;
-        try
-        {
-            imageIndex = m_device.acquireNextImage(m_swapchain, m_imageAvailableSemaphore);
-        }
-        catch (const vk::OutOfDateKHRError &)
+        if (!m_frameScheduler.beginFrame(m_device, m_swapchain))
         {
             recreateSwapChain();
             return;
         }
 
-        m_queue.submit(m_commandBuffers[imageIndex], m_imageAvailableSemaphore, m_renderFinishedSemaphore, vk::PipelineStageFlagBits::eColorAttachmentOutput);
-        ImguiBaseDemo<VD>::drawFrame(imageIndex, m_renderFinishedSemaphore, m_renderImguiFinishedSemaphore);
+        const auto & frame{ m_frameScheduler.getFrame() };
+        m_frameScheduler.submit(m_device, m_queue, m_commandBuffers[m_frameScheduler.getImageIndex()], frame.imageAvailableSemaphore, frame.renderFinishedSemaphore, vk::PipelineStageFlagBits::eColorAttachmentOutput);
+        ImguiBaseDemo<VD>::drawFrame();
 
-        auto waitSemaphore{ *m_renderImguiFinishedSemaphore };
-        auto swapchain{ *reinterpret_cast<const vk::UniqueSwapchainKHR &>(m_swapchain) };
-        auto success{ m_queue.present(waitSemaphore, swapchain, imageIndex) };
-        if (!success)
+        if (!m_frameScheduler.endFrame(m_queue, m_swapchain, frame.overlayFinishedSemaphore))
         {
             recreateSwapChain();
         }
@@ -0,0 +1,160 @@
+#include "frameScheduler.hpp"
+
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+
+#include "swapchain.hpp"
+
+namespace bmvk
+{
+    FrameScheduler::FrameScheduler(const Device & device, vw::util::MemoryAllocator & allocator, const uint32_t framesInFlight)
+      : m_frameCompleted(framesInFlight, false),
+        m_allocator{ &allocator }
+    {
+        if (framesInFlight == 0)
+        {
+            throw std::invalid_argument("at least one frame has to be in flight");
+        }
+
+        m_frames.reserve(framesInFlight);
+        for (uint32_t i = 0; i < framesInFlight; ++i)
+        {
+            // Command buffers of a frame are only recorded once, the pool is reset as a whole when the frame begins
+            auto commandPool{ device.createCommandPool(vk::CommandPoolCreateFlagBits::eTransient) };
+            auto uploadCommandBuffer{ device.allocateCommandBuffer(commandPool) };
+            m_frames.emplace_back(FrameContext{ device.createFence(true), device.createSemaphore(), device.createSemaphore(), device.createSemaphore(), std::move(commandPool), std::move(uploadCommandBuffer) });
+        }
+    }
+
+    bool FrameScheduler::beginFrame(const Device & device, const Swapchain & swapchain)
+    {
+        const auto & device_vk{ reinterpret_cast<const vk::UniqueDevice &>(device) };
+        auto & frame{ m_frames[m_frameIndex] };
+        device_vk->waitForFences(*frame.fence, VK_TRUE, std::numeric_limits<uint64_t>::max());
+
+        try
+        {
+            m_imageIndex = device.acquireNextImage(swapchain, frame.imageAvailableSemaphore);
+        }
+        catch (const vk::OutOfDateKHRError &)
+        {
+            return false;
+        }
+
+        // The image may still be rendered to by another frame context if images are acquired out of order
+        if (m_imageIndex >= m_imageFrames.size())
+        {
+            m_imageFrames.resize(m_imageIndex + 1, -1);
+        }
+
+        const auto previousFrame{ m_imageFrames[m_imageIndex] };
+        if (previousFrame >= 0 && static_cast<uint32_t>(previousFrame) != m_frameIndex)
+        {
+            device_vk->waitForFences(*m_frames[previousFrame].fence, VK_TRUE, std::numeric_limits<uint64_t>::max());
+        }
+
+        m_imageFrames[m_imageIndex] = static_cast<int32_t>(m_frameIndex);
+
+        device_vk->resetFences(*frame.fence);
+        device_vk->resetCommandPool(*frame.commandPool, {});
+        m_uploadsSubmitted = false;
+        return true;
+    }
+
+    void FrameScheduler::submit(const Device & device, const Queue & queue, const CommandBuffer & cmdBuffer, const vk::UniqueSemaphore & waitSemaphore, const vk::UniqueSemaphore & signalSemaphore, const vk::PipelineStageFlags waitStages, const vk::Fence fence)
+    {
+        // The command buffers of a batch start in order, the barriers recorded with the copies make them visible to the frame
+        std::vector<vk::CommandBuffer> commandBuffers;
+        if (recordUploads(device))
+        {
+            commandBuffers.emplace_back(*reinterpret_cast<const vk::UniqueCommandBuffer &>(m_frames[m_frameIndex].uploadCommandBuffer));
+        }
+        commandBuffers.emplace_back(*reinterpret_cast<const vk::UniqueCommandBuffer &>(cmdBuffer));
+
+        const vk::SubmitInfo info{ 1, &*waitSemaphore, &waitStages, static_cast<uint32_t>(commandBuffers.size()), commandBuffers.data(), 1, &*signalSemaphore };
+        static_cast<const vk::Queue &>(queue).submit(info, fence);
+    }
+
+    bool FrameScheduler::endFrame(const Queue & queue, const Swapchain & swapchain, const vk::UniqueSemaphore & waitSemaphore)
+    {
+        auto semaphore{ *waitSemaphore };
+        auto swapchain_vk{ *reinterpret_cast<const vk::UniqueSwapchainKHR &>(swapchain) };
+        const auto success{ queue.present(semaphore, swapchain_vk, m_imageIndex) };
+
+        m_frameCompleted[m_frameIndex] = true;
+        m_frameIndex = (m_frameIndex + 1) % getFramesInFlight();
+        return success;
+    }
+
+    void FrameScheduler::updateBuffer(const vk::UniqueBuffer & buffer, const void * data, const vk::DeviceSize size, const vk::DeviceSize offset, const vk::PipelineStageFlags dstStages, const vk::AccessFlags dstAccess)
+    {
+        queueUpload(buffer, data, size, offset, dstStages, dstAccess);
+        m_pendingWaitStages |= dstStages;
+    }
+
+    void FrameScheduler::updateFrameLocalBuffer(const vk::UniqueBuffer & buffer, const void * data, const vk::DeviceSize size, const vk::DeviceSize offset, const vk::PipelineStageFlags dstStages, const vk::AccessFlags dstAccess)
+    {
+        queueUpload(buffer, data, size, offset, dstStages, dstAccess);
+    }
+
+    void FrameScheduler::queueUpload(const vk::UniqueBuffer & buffer, const void * data, const vk::DeviceSize size, const vk::DeviceSize offset, const vk::PipelineStageFlags dstStages, const vk::AccessFlags dstAccess)
+    {
+        const auto dataOffset{ static_cast<vk::DeviceSize>(m_pendingData.size()) };
+        m_pendingData.resize(m_pendingData.size() + size);
+        memcpy(m_pendingData.data() + dataOffset, data, size);
+        m_pendingUploads.emplace_back(PendingUpload{ *buffer, offset, size, dataOffset });
+        m_pendingStages |= dstStages;
+        m_pendingAccess |= dstAccess;
+    }
+
+    bool FrameScheduler::recordUploads(const Device & device)
+    {
+        // The upload command buffer is recorded once per frame
+        if (m_pendingUploads.empty() || m_uploadsSubmitted)
+        {
+            return false;
+        }
+
+        auto & frame{ m_frames[m_frameIndex] };
+        const auto size{ static_cast<vk::DeviceSize>(m_pendingData.size()) };
+        if (frame.transientBuffer.getSize() < size)
+        {
+            // The old buffer is not in use anymore, its frame has completed
+            const auto newSize{ std::max(size, 2 * frame.transientBuffer.getSize()) };
+            frame.transientBuffer = MappedBuffer{};
+            frame.transientBuffer = device.createMappedBuffer(*m_allocator, newSize, vk::BufferUsageFlagBits::eTransferSrc, vw::util::MemoryUsage::Staging);
+        }
+
+        frame.transientBuffer.write(m_pendingData.data(), size);
+        frame.transientBuffer.flush();
+
+        const auto & cmdBuffer{ frame.uploadCommandBuffer };
+        cmdBuffer.begin(vk::CommandBufferUsageFlagBits::eOneTimeSubmit);
+        const auto & cb_vk{ reinterpret_cast<const vk::UniqueCommandBuffer &>(cmdBuffer) };
+
+        // Frames still in flight may read shared destinations, so the copies wait for them. The earlier reads of frame local
+        // destinations belong to this frame's previous submission, whose fence has been waited for.
+        if (m_pendingWaitStages)
+        {
+            cb_vk->pipelineBarrier(m_pendingWaitStages, vk::PipelineStageFlagBits::eTransfer, {}, nullptr, nullptr, nullptr);
+        }
+
+        for (const auto & upload : m_pendingUploads)
+        {
+            cb_vk->copyBuffer(*static_cast<const vk::UniqueBuffer &>(frame.transientBuffer), upload.buffer, vk::BufferCopy{ upload.dataOffset, upload.offset, upload.size });
+        }
+
+        vk::MemoryBarrier barrier{ vk::AccessFlagBits::eTransferWrite, m_pendingAccess };
+        cb_vk->pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, m_pendingStages, {}, barrier, nullptr, nullptr);
+        cmdBuffer.end();
+
+        m_pendingData.clear();
+        m_pendingUploads.clear();
+        m_pendingStages = {};
+        m_pendingAccess = {};
+        m_pendingWaitStages = {};
+        m_uploadsSubmitted = true;
+        return true;
+    }
+}
@@ -0,0 +1,121 @@
+#pragma once
+
+#include <vulkan/vulkan.hpp>
+
+#include <vector>
+
+#include <vw/memoryAllocator.hpp>
+
+#include "commandbuffer.hpp"
+#include "device.hpp"
+#include "mappedBuffer.hpp"
+#include "queue.hpp"
+
+namespace bmvk
+{
+    class Swapchain;
+
+    // Keeps several frames in flight, so that the CPU can record frame n + 1 while the GPU still renders frame n. Every
+    // frame context owns its own synchronization objects, command pool and transient upload buffer, which are only
+    // reused once the fence of that frame has been signaled.
+    class FrameScheduler
+    {
+    public:
+        struct FrameContext
+        {
+            vk::UniqueFence fence;
+            vk::UniqueSemaphore imageAvailableSemaphore;
+            vk::UniqueSemaphore renderFinishedSemaphore;
+            vk::UniqueSemaphore overlayFinishedSemaphore;
+            vk::UniqueCommandPool commandPool;
+            CommandBuffer uploadCommandBuffer;
+
+            // Host visible source of the buffer updates recorded by this frame
+            MappedBuffer transientBuffer;
+        };
+
+        // The allocator has to outlive the scheduler
+        explicit FrameScheduler(const Device & device, vw::util::MemoryAllocator & allocator, const uint32_t framesInFlight);
+        FrameScheduler(const FrameScheduler &) = delete;
+        FrameScheduler(FrameScheduler && other) = default;
+        FrameScheduler & operator=(const FrameScheduler &) = delete;
+        FrameScheduler & operator=(FrameScheduler && other) = default;
+        ~FrameScheduler() {}
+
+        // Waits until the current frame context is free again and acquires the next swapchain image. Returns false if the
+        // swapchain is out of date.
+        bool beginFrame(const Device & device, const Swapchain & swapchain);
+        // Submits the buffer updates queued so far in one batch with cmdBuffer and ahead of it, so they are part of the work the
+        // frame's fence waits for. Updates queued after the first submit() of a frame wait for the next frame.
+        void submit(const Device & device, const Queue & queue, const CommandBuffer & cmdBuffer, const vk::UniqueSemaphore & waitSemaphore, const vk::UniqueSemaphore & signalSemaphore, const vk::PipelineStageFlags waitStages, const vk::Fence fence = nullptr);
+        // Presents the current image once waitSemaphore is signaled and advances to the next frame context. Returns false
+        // if the swapchain has to be recreated.
+        bool endFrame(const Queue & queue, const Swapchain & swapchain, const vk::UniqueSemaphore & waitSemaphore);
+        // Forgets which frame rendered to which image, needed after the swapchain has been recreated
+        void resetImages() { m_imageFrames.clear(); }
+
+        // Copies size bytes to buffer at offset with the next submit(). The data is captured immediately, so buffers read by
+        // frames still in flight are never written by the host. The buffer needs transfer dst usage.
+        // The copy has to wait for the frames still in flight that read the buffer, so it waits for all earlier work in
+        // dstStages: a buffer shared by all frames keeps their work in these stages from overlapping.
+        void updateBuffer(const vk::UniqueBuffer & buffer, const void * data, const vk::DeviceSize size, const vk::DeviceSize offset = 0, const vk::PipelineStageFlags dstStages = vk::PipelineStageFlagBits::eVertexShader, const vk::AccessFlags dstAccess = vk::AccessFlagBits::eUniformRead);
+        template <class T>
+        void updateBuffer(const vk::UniqueBuffer & buffer, const T & obj, const vk::PipelineStageFlags dstStages = vk::PipelineStageFlagBits::eVertexShader);
+        // Like updateBuffer(), for buffers of which every frame in flight has its own copy. Only the copy of the frame that
+        // submits next may be passed, its previous reads are complete, so the copy does not wait for the other frames.
+        void updateFrameLocalBuffer(const vk::UniqueBuffer & buffer, const void * data, const vk::DeviceSize size, const vk::DeviceSize offset = 0, const vk::PipelineStageFlags dstStages = vk::PipelineStageFlagBits::eVertexShader, const vk::AccessFlags dstAccess = vk::AccessFlagBits::eUniformRead);
+        template <class T>
+        void updateFrameLocalBuffer(const vk::UniqueBuffer & buffer, const T & obj, const vk::PipelineStageFlags dstStages = vk::PipelineStageFlagBits::eVertexShader);
+
+        const FrameContext & getFrame() const { return m_frames[m_frameIndex]; }
+        vk::Fence getFence() const { return *m_frames[m_frameIndex].fence; }
+        auto getFrameIndex() const noexcept { return m_frameIndex; }
+        auto getImageIndex() const noexcept { return m_imageIndex; }
+        auto getFramesInFlight() const noexcept { return static_cast<uint32_t>(m_frames.size()); }
+        // True once the current frame context has been submitted before, i.e. its queries hold results
+        bool hasFrameCompleted() const { return m_frameCompleted[m_frameIndex]; }
+    private:
+        struct PendingUpload
+        {
+            vk::Buffer buffer;
+            vk::DeviceSize offset;
+            vk::DeviceSize size;
+            vk::DeviceSize dataOffset;
+        };
+
+        std::vector<FrameContext> m_frames;
+        std::vector<bool> m_frameCompleted;
+        std::vector<int32_t> m_imageFrames;
+        uint32_t m_frameIndex = 0;
+        uint32_t m_imageIndex = 0;
+        vw::util::MemoryAllocator * m_allocator;
+
+        std::vector<char> m_pendingData;
+        std::vector<PendingUpload> m_pendingUploads;
+        vk::PipelineStageFlags m_pendingStages;
+        vk::AccessFlags m_pendingAccess;
+        // Stages of the earlier frames the copies wait for, only shared buffers add to them
+        vk::PipelineStageFlags m_pendingWaitStages;
+        bool m_uploadsSubmitted = false;
+
+        void queueUpload(const vk::UniqueBuffer & buffer, const void * data, const vk::DeviceSize size, const vk::DeviceSize offset, const vk::PipelineStageFlags dstStages, const vk::AccessFlags dstAccess);
+        bool recordUploads(const Device & device);
+    };
+
+    template <class T>
+    void FrameScheduler::updateBuffer(const vk::UniqueBuffer & buffer, const T & obj, const vk::PipelineStageFlags dstStages)
+    {
+        updateBuffer(buffer, &obj, sizeof obj, 0, dstStages);
+    }
+
+    template <class T>
+    void FrameScheduler::updateFrameLocalBuffer(const vk::UniqueBuffer & buffer, const T & obj, const vk::PipelineStageFlags dstStages)
+    {
+        updateFrameLocalBuffer(buffer, &obj, sizeof obj, 0, dstStages);
+    }
+
+    static_assert(std::is_move_constructible_v<FrameScheduler>);
+    static_assert(!std::is_copy_constructible_v<FrameScheduler>);
+    static_assert(std::is_move_assignable_v<FrameScheduler>);
+    static_assert(!std::is_copy_assignable_v<FrameScheduler>);
+}
@@ -1,6 +1,8 @@
 #include "imguiBaseDemo.hpp"
 
+#include <algorithm>
 #include <iostream>
+#include <string>
 
 #include <imgui/imgui.h>
 
@@ -9,26 +11,12 @@
 
 namespace bmvk
 {
-    static uint32_t getImguiMemoryType(vk::PhysicalDevice gpu, vk::MemoryPropertyFlags properties, uint32_t type_bits)
-    {
-        const auto prop{ gpu.getMemoryProperties() };
-        for (uint32_t i = 0; i < prop.memoryTypeCount; ++i)
-        {
-            if ((prop.memoryTypes[i].propertyFlags & properties) == properties && type_bits & 1 << i)
-            {
-                return i;
-            }
-        }
-
-        return 0xffffffff; // Unable to find memoryType
-    }
-
     template <vw::scene::VertexDescription VD>
-    ImguiBaseDemo<VD>::ImguiBaseDemo(const bool enableValidationLayers, const uint32_t width, const uint32_t height, std::string name, const DebugReport::ReportLevel reportLevel)
-      : Demo{ enableValidationLayers, width, height, name, reportLevel },
+    ImguiBaseDemo<VD>::ImguiBaseDemo(const bool enableValidationLayers, const uint32_t width, const uint32_t height, std::string name, const DebugReport::ReportLevel reportLevel, const uint32_t initialModelRepositoryInstances, const vw::util::InstanceFormat instanceFormat)
+      : Demo{ enableValidationLayers, width, height, name, reportLevel, initialModelRepositoryInstances, instanceFormat },
         m_swapchain{ m_instance.getPhysicalDevice(), m_instance.getSurface(), m_window.getSize(), m_device },
         m_fontSampler{ m_device.createSampler(false, -1000.f, 1000.f) },
-        m_imguiQueryPool{ reinterpret_cast<const vk::UniqueDevice &>(m_device)->createQueryPoolUnique({ {}, vk::QueryType::eTimestamp, 2 }) }
+        m_imguiQueryPool{ reinterpret_cast<const vk::UniqueDevice &>(m_device)->createQueryPoolUnique({ {}, vk::QueryType::eTimestamp, 2 * m_frameScheduler.getFramesInFlight() }) }
     {
         m_window.addWindowSizeFunc([this](int width, int height)
         {
@@ -58,6 +46,8 @@ namespace bmvk
 
         uploadFonts();
 
+        m_framesImgui.resize(m_frameScheduler.getFramesInFlight());
+
         auto & io = ImGui::GetIO();
         io.KeyMap[ImGuiKey_Tab] = GLFW_KEY_TAB;                         // Keyboard mapping. ImGui will use those indices to peek into the io.KeyDown[] array.
         io.KeyMap[ImGuiKey_LeftArrow] = GLFW_KEY_LEFT;
@@ -89,6 +79,7 @@ namespace bmvk
         m_renderPassImgui.reset(nullptr);
 
         m_swapchain.recreate(m_instance.getPhysicalDevice(), m_instance.getSurface(), m_window.getSize(), m_device);
+        m_frameScheduler.resetImages();
 
         createRenderPass();
         createGraphicsPipeline();
@@ -290,12 +281,7 @@ namespace bmvk
         vk::ImageCreateInfo imageInfo{ {}, vk::ImageType::e2D, vk::Format::eR8G8B8A8Unorm, vk::Extent3D(width, height, 1), 1, 1, vk::SampleCountFlagBits::e1, vk::ImageTiling::eOptimal, vk::ImageUsageFlagBits::eSampled | vk::ImageUsageFlagBits::eTransferDst };
         m_imguiFontImage = reinterpret_cast<const vk::UniqueDevice &>(m_device)->createImageUnique(imageInfo);
 
-        const auto imageReq{ reinterpret_cast<const vk::UniqueDevice &>(m_device)->getImageMemoryRequirements(*m_imguiFontImage) };
-        const auto imageMemoryTypeIndex{ getImguiMemoryType(static_cast<vk::PhysicalDevice>(m_instance.getPhysicalDevice()), vk::MemoryPropertyFlagBits::eDeviceLocal, imageReq.memoryTypeBits) };
-        vk::MemoryAllocateInfo imageMemoryAllocInfo{ imageReq.size, imageMemoryTypeIndex };
-        m_imguiFontMemory = reinterpret_cast<const vk::UniqueDevice &>(m_device)->allocateMemoryUnique(imageMemoryAllocInfo);
-
-        reinterpret_cast<const vk::UniqueDevice &>(m_device)->bindImageMemory(*m_imguiFontImage, *m_imguiFontMemory, 0);
+        m_imguiFontMemory = m_memoryAllocator->allocateImageMemory(m_imguiFontImage, vk::MemoryPropertyFlagBits::eDeviceLocal, vk::ImageTiling::eOptimal, vw::util::MemoryUsage::Ui);
 
         // Create the Image View:
         vk::ImageViewCreateInfo imageViewInfo{ {}, *m_imguiFontImage, vk::ImageViewType::e2D, vk::Format::eR8G8B8A8Unorm,{}, vk::ImageSubresourceRange{ vk::ImageAspectFlagBits::eColor, 0, 1, 0, 1 } };
@@ -308,30 +294,21 @@ namespace bmvk
         reinterpret_cast<const vk::UniqueDevice &>(m_device)->updateDescriptorSets(writeDesc, nullptr);
 
         // Create the Upload Buffer:
-        vk::BufferCreateInfo bufferInfo{ {}, upload_size, vk::BufferUsageFlagBits::eTransferSrc };
-        auto uploadBuffer{ reinterpret_cast<const vk::UniqueDevice &>(m_device)->createBufferUnique(bufferInfo) };
+        auto uploadBuffer{ m_device.createMappedBuffer(*m_memoryAllocator, upload_size, vk::BufferUsageFlagBits::eTransferSrc, vw::util::MemoryUsage::Staging) };
 
-        const auto bufferReq{ reinterpret_cast<const vk::UniqueDevice &>(m_device)->getBufferMemoryRequirements(*uploadBuffer) };
+        const auto bufferReq{ reinterpret_cast<const vk::UniqueDevice &>(m_device)->getBufferMemoryRequirements(*static_cast<const vk::UniqueBuffer &>(uploadBuffer)) };
         m_bufferMemoryAlignmentImgui = m_bufferMemoryAlignmentImgui > bufferReq.alignment ? m_bufferMemoryAlignmentImgui : bufferReq.alignment;
-        const auto bufferMemoryTypeIndex{ getImguiMemoryType(static_cast<vk::PhysicalDevice>(m_instance.getPhysicalDevice()), vk::MemoryPropertyFlagBits::eHostVisible, bufferReq.memoryTypeBits) };
-        vk::MemoryAllocateInfo bufferMemoryAllocInfo{ bufferReq.size, bufferMemoryTypeIndex };
-        auto uploadBufferMemory{ reinterpret_cast<const vk::UniqueDevice &>(m_device)->allocateMemoryUnique(bufferMemoryAllocInfo) };
-
-        reinterpret_cast<const vk::UniqueDevice &>(m_device)->bindBufferMemory(*uploadBuffer, *uploadBufferMemory, 0);
 
         // Upload to Buffer:
-        auto * map{ m_device.mapMemory(uploadBufferMemory, upload_size) };
-        memcpy(map, pixels, upload_size);
-        vk::MappedMemoryRange flushRange{ *uploadBufferMemory, 0, upload_size };
-        reinterpret_cast<const vk::UniqueDevice &>(m_device)->flushMappedMemoryRanges(flushRange);
-        m_device.unmapMemory(uploadBufferMemory);
+        uploadBuffer.write(pixels, upload_size);
+        uploadBuffer.flush();
 
         // Copy to Image:
         vk::ImageMemoryBarrier copyBarrier{ {}, vk::AccessFlagBits::eTransferWrite, vk::ImageLayout::eUndefined, vk::ImageLayout::eTransferDstOptimal, VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED, *m_imguiFontImage, vk::ImageSubresourceRange{ vk::ImageAspectFlagBits::eColor, 0, 1, 0, 1 } };
         cmdBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eHost, vk::PipelineStageFlagBits::eTransfer, {}, nullptr, nullptr, copyBarrier);
 
         vk::BufferImageCopy copyRegion{ 0, 0, 0, vk::ImageSubresourceLayers{ vk::ImageAspectFlagBits::eColor, 0, 0, 1 },{}, vk::Extent3D{ static_cast<uint32_t>(width), static_cast<uint32_t>(height), 1 } };
-        cmdBuffer.copyBufferToImage(uploadBuffer, m_imguiFontImage, vk::ImageLayout::eTransferDstOptimal, copyRegion);
+        cmdBuffer.copyBufferToImage(static_cast<const vk::UniqueBuffer &>(uploadBuffer), m_imguiFontImage, vk::ImageLayout::eTransferDstOptimal, copyRegion);
 
         vk::ImageMemoryBarrier useBarrier{ vk::AccessFlagBits::eTransferWrite, vk::AccessFlagBits::eShaderRead, vk::ImageLayout::eTransferDstOptimal, vk::ImageLayout::eShaderReadOnlyOptimal, VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED, *m_imguiFontImage, vk::ImageSubresourceRange{ vk::ImageAspectFlagBits::eColor, 0, 1, 0, 1 } };
         cmdBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eFragmentShader, {}, nullptr, nullptr, useBarrier);
@@ -343,8 +320,6 @@ namespace bmvk
         cmdBuffer.end();
         m_queue.submit(cmdBuffer);
         m_device.waitIdle();
-
-        uploadBuffer.reset(nullptr);
     }
 
     template <vw::scene::VertexDescription VD>
@@ -356,102 +331,55 @@ namespace bmvk
         }
 
         auto & io = ImGui::GetIO();
+        auto & frame{ m_framesImgui[m_frameScheduler.getFrameIndex()] };
 
         // Create the Vertex Buffer:
-        auto vertexSize{ draw_data->TotalVtxCount * sizeof(ImDrawVert) };
-        if (!m_vertexBufferImgui || m_vertexBufferSize < vertexSize)
+        const auto vertexSize{ draw_data->TotalVtxCount * sizeof(ImDrawVert) };
+        if (frame.vertexBuffer.getSize() < vertexSize)
         {
-            if (m_vertexBufferImgui)
-            {
-                m_vertexBufferImgui.reset(nullptr);
-            }
-
-            if (m_vertexBufferMemoryImgui)
-            {
-                m_vertexBufferMemoryImgui.reset(nullptr);
-            }
-
             const auto vertexBufferSize{ ((vertexSize - 1) / m_bufferMemoryAlignmentImgui + 1) * m_bufferMemoryAlignmentImgui };
-            vk::BufferCreateInfo bufferInfo{ {}, vertexBufferSize, vk::BufferUsageFlagBits::eVertexBuffer };
-            m_vertexBufferImgui = reinterpret_cast<const vk::UniqueDevice &>(m_device)->createBufferUnique(bufferInfo);
-
-            const auto req{ reinterpret_cast<const vk::UniqueDevice &>(m_device)->getBufferMemoryRequirements(*m_vertexBufferImgui) };
-            m_bufferMemoryAlignmentImgui = m_bufferMemoryAlignmentImgui > req.alignment ? m_bufferMemoryAlignmentImgui : req.alignment;
-
-            vk::MemoryAllocateInfo allocInfo{ req.size, getImguiMemoryType(static_cast<vk::PhysicalDevice>(m_instance.getPhysicalDevice()), vk::MemoryPropertyFlagBits::eHostVisible, req.memoryTypeBits) };
-            m_vertexBufferMemoryImgui = reinterpret_cast<const vk::UniqueDevice &>(m_device)->allocateMemoryUnique(allocInfo);
-
-            reinterpret_cast<const vk::UniqueDevice &>(m_device)->bindBufferMemory(*m_vertexBufferImgui, *m_vertexBufferMemoryImgui, 0);
-
-            m_vertexBufferSize = vertexBufferSize;
+            frame.vertexBuffer = MappedBuffer{};
+            frame.vertexBuffer = m_device.createMappedBuffer(*m_memoryAllocator, vertexBufferSize, vk::BufferUsageFlagBits::eVertexBuffer, vw::util::MemoryUsage::Ui);
         }
 
         // Create the Index Buffer:
-        auto indexSize{ draw_data->TotalIdxCount * sizeof(ImDrawIdx) };
-        if (!m_indexBufferImgui || m_indexBufferSize < indexSize)
+        const auto indexSize{ draw_data->TotalIdxCount * sizeof(ImDrawIdx) };
+        if (frame.indexBuffer.getSize() < indexSize)
         {
-            if (m_indexBufferImgui)
-            {
-                m_indexBufferImgui.reset(nullptr);
-            }
-
-            if (m_indexBufferMemoryImgui)
-            {
-                m_indexBufferMemoryImgui.reset(nullptr);
-            }
-
             const auto indexBufferSize{ ((indexSize - 1) / m_bufferMemoryAlignmentImgui + 1) * m_bufferMemoryAlignmentImgui };
-            vk::BufferCreateInfo bufferInfo{ {}, indexBufferSize, vk::BufferUsageFlagBits::eIndexBuffer };
-            m_indexBufferImgui = reinterpret_cast<const vk::UniqueDevice &>(m_device)->createBufferUnique(bufferInfo);
-
-            const auto req{ reinterpret_cast<const vk::UniqueDevice &>(m_device)->getBufferMemoryRequirements(*m_indexBufferImgui) };
-            m_bufferMemoryAlignmentImgui = m_bufferMemoryAlignmentImgui > req.alignment ? m_bufferMemoryAlignmentImgui : req.alignment;
-
-            vk::MemoryAllocateInfo allocInfo{ req.size, getImguiMemoryType(static_cast<vk::PhysicalDevice>(m_instance.getPhysicalDevice()), vk::MemoryPropertyFlagBits::eHostVisible, req.memoryTypeBits) };
-            m_indexBufferMemoryImgui = reinterpret_cast<const vk::UniqueDevice &>(m_device)->allocateMemoryUnique(allocInfo);
-
-            reinterpret_cast<const vk::UniqueDevice &>(m_device)->bindBufferMemory(*m_indexBufferImgui, *m_indexBufferMemoryImgui, 0);
-
-            m_indexBufferSize = indexBufferSize;
+            frame.indexBuffer = MappedBuffer{};
+            frame.indexBuffer = m_device.createMappedBuffer(*m_memoryAllocator, indexBufferSize, vk::BufferUsageFlagBits::eIndexBuffer, vw::util::MemoryUsage::Ui);
         }
 
         // Upload Vertex and index Data:
-        auto vtx_dst = reinterpret_cast<ImDrawVert *>(m_device.mapMemory(m_vertexBufferMemoryImgui, vertexSize));
-        auto idx_dst = reinterpret_cast<ImDrawIdx *>(m_device.mapMemory(m_indexBufferMemoryImgui, indexSize));
-        
+        auto vertices{ frame.vertexBuffer.template getWriteView<ImDrawVert>(draw_data->TotalVtxCount) };
+        auto indices{ frame.indexBuffer.template getWriteView<ImDrawIdx>(draw_data->TotalIdxCount) };
+        auto vtx_dst{ vertices.begin() };
+        auto idx_dst{ indices.begin() };
         for (auto n = 0; n < draw_data->CmdListsCount; ++n)
         {
             const ImDrawList * cmd_list = draw_data->CmdLists[n];
-            memcpy(vtx_dst, cmd_list->VtxBuffer.Data, cmd_list->VtxBuffer.Size * sizeof(ImDrawVert));
-            memcpy(idx_dst, cmd_list->IdxBuffer.Data, cmd_list->IdxBuffer.Size * sizeof(ImDrawIdx));
-            vtx_dst += cmd_list->VtxBuffer.Size;
-            idx_dst += cmd_list->IdxBuffer.Size;
+            vtx_dst = std::copy(cmd_list->VtxBuffer.begin(), cmd_list->VtxBuffer.end(), vtx_dst);
+            idx_dst = std::copy(cmd_list->IdxBuffer.begin(), cmd_list->IdxBuffer.end(), idx_dst);
         }
 
-        std::vector<vk::MappedMemoryRange> ranges =
-        {
-            { *m_vertexBufferMemoryImgui, 0, VK_WHOLE_SIZE },
-            { *m_indexBufferMemoryImgui, 0, VK_WHOLE_SIZE },
-        };
-        reinterpret_cast<const vk::UniqueDevice &>(m_device)->flushMappedMemoryRanges(ranges);
-
-        m_device.unmapMemory(m_vertexBufferMemoryImgui);
-        m_device.unmapMemory(m_indexBufferMemoryImgui);
+        frame.vertexBuffer.flush();
+        frame.indexBuffer.flush();
 
         // Bind pipeline and descriptor sets:
-        m_commandBufferImguiPtr->bindPipeline(m_graphicsPipelineImgui);
-        m_commandBufferImguiPtr->bindDescriptorSet(m_pipelineLayoutImgui, m_descriptorSetsImgui[0]);
+        frame.commandBufferPtr->bindPipeline(m_graphicsPipelineImgui);
+        frame.commandBufferPtr->bindDescriptorSet(m_pipelineLayoutImgui, m_descriptorSetsImgui[0]);
 
         // Bind Vertex And Index Buffer:
-        m_commandBufferImguiPtr->bindVertexBuffer(m_vertexBufferImgui);
-        m_commandBufferImguiPtr->bindIndexBuffer(m_indexBufferImgui);
+        frame.commandBufferPtr->bindVertexBuffer(static_cast<const vk::UniqueBuffer &>(frame.vertexBuffer));
+        frame.commandBufferPtr->bindIndexBuffer(static_cast<const vk::UniqueBuffer &>(frame.indexBuffer));
 
         // Setup viewport:
-        m_commandBufferImguiPtr->setViewport({ 0.f, 0.f, std::max(1.f, ImGui::GetIO().DisplaySize.x), std::max(1.f, ImGui::GetIO().DisplaySize.y), 0.f, 1.f });
+        frame.commandBufferPtr->setViewport({ 0.f, 0.f, std::max(1.f, ImGui::GetIO().DisplaySize.x), std::max(1.f, ImGui::GetIO().DisplaySize.y), 0.f, 1.f });
 
         // Setup scale and translation:
-        m_commandBufferImguiPtr->pushConstants<float>(m_pipelineLayoutImgui, vk::ShaderStageFlagBits::eVertex, 0, std::vector<float>{ 2.f / io.DisplaySize.x, 2.f / io.DisplaySize.y });
-        m_commandBufferImguiPtr->pushConstants<float>(m_pipelineLayoutImgui, vk::ShaderStageFlagBits::eVertex, 2, std::vector<float>{ -1.f, -1.f });
+        frame.commandBufferPtr->pushConstants<float>(m_pipelineLayoutImgui, vk::ShaderStageFlagBits::eVertex, 0, std::vector<float>{ 2.f / io.DisplaySize.x, 2.f / io.DisplaySize.y });
+        frame.commandBufferPtr->pushConstants<float>(m_pipelineLayoutImgui, vk::ShaderStageFlagBits::eVertex, 2, std::vector<float>{ -1.f, -1.f });
 
         // Render the command lists:
         auto vtxOffset = 0;
@@ -471,8 +399,8 @@ namespace bmvk
                     vk::Offset2D offset{ static_cast<int32_t>(pcmd->ClipRect.x) > 0 ? static_cast<int32_t>(pcmd->ClipRect.x) : 0, static_cast<int32_t>(pcmd->ClipRect.y) > 0 ? static_cast<int32_t>(pcmd->ClipRect.y) : 0 };
                     vk::Extent2D extent{ static_cast<uint32_t>(pcmd->ClipRect.z - pcmd->ClipRect.x), static_cast<uint32_t>(pcmd->ClipRect.w - pcmd->ClipRect.y + 1) }; // FIXME: Why +1 here?
                     vk::Rect2D scissor{ offset, extent };
-                    m_commandBufferImguiPtr->setScissor(scissor);
-                    m_commandBufferImguiPtr->drawIndexed(pcmd->ElemCount, 1, idxOffset, vtxOffset);
+                    frame.commandBufferPtr->setScissor(scissor);
+                    frame.commandBufferPtr->drawIndexed(pcmd->ElemCount, 1, idxOffset, vtxOffset);
                 }
 
                 idxOffset += pcmd->ElemCount;
@@ -483,37 +411,41 @@ namespace bmvk
     }
 
     template <vw::scene::VertexDescription VD>
-    void ImguiBaseDemo<VD>::drawFrame(uint32_t imageIndex, const vk::UniqueSemaphore & renderFinishedSemaphore, const vk::UniqueSemaphore & renderImguiFinishedSemaphore)
+    void ImguiBaseDemo<VD>::drawFrame()
     {
-        if (!m_firstRender)
+        // The queries of this frame context were written when it was last submitted, and its fence has been waited for
+        const auto firstQuery{ 2 * m_frameScheduler.getFrameIndex() };
+        if (m_frameScheduler.hasFrameCompleted())
         {
-            auto data = new uint64_t[2];
-            reinterpret_cast<const vk::UniqueDevice &>(m_device)->getQueryPoolResults(*m_imguiQueryPool, 0, 2, sizeof(uint64_t) * 2, data, 0, vk::QueryResultFlagBits::e64);
+            uint64_t data[2];
+            reinterpret_cast<const vk::UniqueDevice &>(m_device)->getQueryPoolResults(*m_imguiQueryPool, firstQuery, 2, sizeof(uint64_t) * 2, data, sizeof(uint64_t), vk::QueryResultFlagBits::e64);
             auto diff = (data[1] - data[0]) * m_nanosecondsPerTimestampIncrement / 1e6f;
             m_lastImguiFrameTimes.emplace_back(diff);
-            delete[] data;
         }
 
-        m_commandBufferImguiPtr.reset();
-        m_commandBufferImguiPtr = std::make_unique<CommandBuffer>(m_device.allocateCommandBuffer(m_commandPool));
-        m_commandBufferImguiPtr->begin(vk::CommandBufferUsageFlagBits::eOneTimeSubmit);
+        // The command pool of the frame has been reset, the previous command buffer can be freed
+        auto & frame{ m_framesImgui[m_frameScheduler.getFrameIndex()] };
+        frame.commandBufferPtr.reset();
+        frame.commandBufferPtr = std::make_unique<CommandBuffer>(m_device.allocateCommandBuffer(m_frameScheduler.getFrame().commandPool));
+        frame.commandBufferPtr->begin(vk::CommandBufferUsageFlagBits::eOneTimeSubmit);
 
-        const auto & cb_vk{ reinterpret_cast<const vk::UniqueCommandBuffer &>(*m_commandBufferImguiPtr) };
-        cb_vk->resetQueryPool(*m_imguiQueryPool, 0, 2);
-        cb_vk->writeTimestamp(vk::PipelineStageFlagBits::eBottomOfPipe, *m_imguiQueryPool, 0);
+        const auto & cb_vk{ reinterpret_cast<const vk::UniqueCommandBuffer &>(*frame.commandBufferPtr) };
+        cb_vk->resetQueryPool(*m_imguiQueryPool, firstQuery, 2);
+        cb_vk->writeTimestamp(vk::PipelineStageFlagBits::eBottomOfPipe, *m_imguiQueryPool, firstQuery);
 
         std::vector<vk::ClearValue> clearValues{ vk::ClearColorValue{ std::array<float, 4>{ 0.f, 0.f, 0.f, 1.f } } };
-        m_commandBufferImguiPtr->beginRenderPass(m_renderPassImgui, m_swapChainFramebuffers[imageIndex], { { 0, 0 }, m_swapchain.getExtent() }, clearValues);
+        frame.commandBufferPtr->beginRenderPass(m_renderPassImgui, m_swapChainFramebuffers[m_frameScheduler.getImageIndex()], { { 0, 0 }, m_swapchain.getExtent() }, clearValues);
 
         imguiRenderDrawLists(ImGui::GetDrawData());
 
-        m_commandBufferImguiPtr->endRenderPass();
+        frame.commandBufferPtr->endRenderPass();
 
-        cb_vk->writeTimestamp(vk::PipelineStageFlagBits::eBottomOfPipe, *m_imguiQueryPool, 1);
+        cb_vk->writeTimestamp(vk::PipelineStageFlagBits::eBottomOfPipe, *m_imguiQueryPool, firstQuery + 1);
 
-        m_commandBufferImguiPtr->end();
+        frame.commandBufferPtr->end();
 
-        m_queue.submit(*m_commandBufferImguiPtr.get(), renderFinishedSemaphore, renderImguiFinishedSemaphore, vk::PipelineStageFlagBits::eColorAttachmentOutput);
+        const auto & frameContext{ m_frameScheduler.getFrame() };
+        m_queue.submit(*frame.commandBufferPtr, frameContext.renderFinishedSemaphore, frameContext.overlayFinishedSemaphore, vk::PipelineStageFlagBits::eColorAttachmentOutput, m_frameScheduler.getFence());
     }
 
     template <vw::scene::VertexDescription VD>
@@ -561,6 +493,81 @@ namespace bmvk
 
         // Start the frame
         ImGui::NewFrame();
+
+        if (m_showMemoryWindow)
+        {
+            imguiMemoryWindow();
+        }
+    }
+
+    template <vw::scene::VertexDescription VD>
+    void ImguiBaseDemo<VD>::imguiMemoryWindow()
+    {
+        constexpr auto mib{ 1024.f * 1024.f };
+        const auto & statistics{ m_memoryAllocator->getStatistics() };
+        const auto & properties{ m_memoryAllocator->getMemoryProperties() };
+        const auto counterColumns = [mib](const char * name, const vw::util::MemoryCounter & counter)
+        {
+            ImGui::Text("%s", name);
+            ImGui::NextColumn();
+            ImGui::Text("%.2f", counter.bytes / mib);
+            ImGui::NextColumn();
+            ImGui::Text("%.2f", counter.peakBytes / mib);
+            ImGui::NextColumn();
+            ImGui::Text("%u", counter.count);
+            ImGui::NextColumn();
+            ImGui::Text("%llu", static_cast<unsigned long long>(counter.totalCount));
+            ImGui::NextColumn();
+        };
+        const auto headerColumns = [](const char * name)
+        {
+            for (const auto header : { name, "Live MiB", "Peak MiB", "Count", "Total" })
+            {
+                ImGui::Text("%s", header);
+                ImGui::NextColumn();
+            }
+
+            ImGui::Separator();
+        };
+
+        ImGui::Begin("Memory", &m_showMemoryWindow);
+
+        // Blocks are the device memory actually allocated, the rest is what has been suballocated from them
+        for (uint32_t i = 0; i < properties.memoryHeapCount; ++i)
+        {
+            const auto & blocks{ statistics.heapBlocks[i] };
+            const auto deviceLocal{ properties.memoryHeaps[i].flags & vk::MemoryHeapFlagBits::eDeviceLocal };
+            ImGui::Text("Heap %u%s: %.2f of %.2f MiB in %u blocks (peak %.2f MiB)", i, deviceLocal ? " (device local)" : "", blocks.bytes / mib, properties.memoryHeaps[i].size / mib, blocks.count, blocks.peakBytes / mib);
+        }
+
+        ImGui::Text("Suballocated: %.2f of %.2f MiB", statistics.total.bytes / mib, statistics.blocks.bytes / mib);
+        ImGui::Separator();
+
+        ImGui::Columns(5, "memoryUsages");
+        headerColumns("Usage");
+        for (size_t i = 0; i < statistics.usages.size(); ++i)
+        {
+            counterColumns(vw::util::toString(static_cast<vw::util::MemoryUsage>(i)), statistics.usages[i]);
+        }
+
+        ImGui::Columns(1);
+        ImGui::Separator();
+
+        ImGui::Columns(5, "memoryTypes");
+        headerColumns("Type");
+        for (uint32_t i = 0; i < properties.memoryTypeCount; ++i)
+        {
+            if (statistics.types[i].totalCount == 0)
+            {
+                continue;
+            }
+
+            const auto name{ "Type " + std::to_string(i) + " (heap " + std::to_string(properties.memoryTypes[i].heapIndex) + ")" };
+            counterColumns(name.c_str(), statistics.types[i]);
+        }
+
+        ImGui::Columns(1);
+        ImGui::End();
     }
 
     template <vw::scene::VertexDescription VD>
@@ -652,6 +659,11 @@ namespace bmvk
             std::cout << "Up: (" << up.x << '|' << up.y << '|' << up.z << ")\n";
         }
 
+        if (key == GLFW_KEY_M && action == GLFW_PRESS)
+        {
+            m_showMemoryWindow = !m_showMemoryWindow;
+        }
+
         if (key == GLFW_KEY_ESCAPE && action == GLFW_PRESS)
         {
             m_window.setShouldClose(true);
@@ -11,7 +11,7 @@ namespace bmvk
     class ImguiBaseDemo : protected Demo<VD>
     {
     public:
-        ImguiBaseDemo(const bool enableValidationLayers, const uint32_t width, const uint32_t height, std::string name, const DebugReport::ReportLevel reportLevel);
+        ImguiBaseDemo(const bool enableValidationLayers, const uint32_t width, const uint32_t height, std::string name, const DebugReport::ReportLevel reportLevel, const uint32_t initialModelRepositoryInstances = 1024, const vw::util::InstanceFormat instanceFormat = vw::util::InstanceFormat::Matrix);
         ImguiBaseDemo(const ImguiBaseDemo &) = delete;
         ImguiBaseDemo(ImguiBaseDemo && other) = default;
         ImguiBaseDemo & operator=(const ImguiBaseDemo &) = delete;
@@ -30,34 +30,40 @@ namespace bmvk
 
         std::vector<double> m_lastImguiFrameTimes;
 
-        void drawFrame(uint32_t imageIndex, const vk::UniqueSemaphore & renderFinishedSemaphore, const vk::UniqueSemaphore & renderImguiFinishedSemaphore);
+        // Renders the overlay on top of the current image after the render finished semaphore of the frame, and signals
+        // the overlay finished semaphore and the fence of the frame
+        void drawFrame();
+        // Starts the ImGui frame, the memory window toggled with M is added to it
         void imguiNewFrame();
     private:
+        // Every frame in flight records into its own command buffer and draws from its own vertex and index buffers
+        struct FrameResources
+        {
+            std::unique_ptr<CommandBuffer> commandBufferPtr;
+            MappedBuffer vertexBuffer;
+            MappedBuffer indexBuffer;
+        };
+
         vk::UniqueRenderPass m_renderPassImgui;
         Sampler m_fontSampler;
         vk::UniqueDescriptorSetLayout m_descriptorSetLayoutImgui;
         vk::UniquePipelineLayout m_pipelineLayoutImgui;
         vk::UniquePipeline m_graphicsPipelineImgui;
         std::vector<vk::UniqueFramebuffer> m_swapChainFramebuffers;
-        vk::UniqueDeviceMemory m_vertexBufferMemoryImgui;
-        vk::UniqueBuffer m_vertexBufferImgui;
-        vk::UniqueDeviceMemory m_indexBufferMemoryImgui;
-        vk::UniqueBuffer m_indexBufferImgui;
         vk::UniqueDescriptorPool m_descriptorPoolImgui;
         std::vector<vk::UniqueDescriptorSet> m_descriptorSetsImgui;
-        std::unique_ptr<CommandBuffer> m_commandBufferImguiPtr;
-        vk::UniqueDeviceMemory m_imguiFontMemory;
+        std::vector<FrameResources> m_framesImgui;
+        vw::util::UniqueAllocation m_imguiFontMemory;
         vk::UniqueImage m_imguiFontImage;
         vk::UniqueImageView m_imguiFontImageView;
         size_t m_bufferMemoryAlignmentImgui = 256;
-        size_t m_vertexBufferSize;
-        size_t m_indexBufferSize;
 
         double m_imguiTime = 0.0;
         std::vector<bool> m_imguiMousePressed = { false, false, false };
         float m_imguiMouseWheel = 0.f;
 
         vk::UniqueQueryPool m_imguiQueryPool;
+        bool m_showMemoryWindow = false;
 
         void createDescriptorSetLayout();
         void createRenderPass();
@@ -68,5 +74,6 @@ namespace bmvk
         void uploadFonts();
 
         void imguiRenderDrawLists(ImDrawData * draw_data);
+        void imguiMemoryWindow();
     };
 }
@@ -59,12 +59,10 @@ namespace bmvk
         vk::UniquePipeline m_graphicsPipeline;
         std::vector<vk::UniqueFramebuffer> m_swapChainFramebuffers;
         vk::UniqueBuffer m_vertexBuffer;
-        vk::UniqueDeviceMemory m_vertexBufferMemory;
+        vw::util::UniqueAllocation m_vertexBufferMemory;
         vk::UniqueBuffer m_indexBuffer;
-        vk::UniqueDeviceMemory m_indexBufferMemory;
+        vw::util::UniqueAllocation m_indexBufferMemory;
         std::vector<vk::UniqueCommandBuffer> m_commandBuffers;
-        vk::UniqueSemaphore m_imageAvailableSemaphore;
-        vk::UniqueSemaphore m_renderFinishedSemaphore;
 
         void createRenderPass();
         void createGraphicsPipeline();
@@ -14,32 +14,17 @@ namespace bmvk
 
     Instance::Instance(const std::string& appName, const uint32_t appVersion, const std::string& engineName, const uint32_t engineVersion, const vw::util::Window & window, const bool enableValidationLayers, const DebugReport::ReportLevel reportLevel)
     {
-        vk::ApplicationInfo appInfo{ appName.c_str(), appVersion, engineName.c_str(), engineVersion, VK_API_VERSION_1_0 };
-
-        const auto extensions = getExtensions(enableValidationLayers, window);
-        std::vector<const char*> extensionsAsCstrings{};
-        for (const auto& string : extensions)
-        {
-            extensionsAsCstrings.emplace_back(string.c_str());
-        }
-
-        initializeLayerNames(enableValidationLayers);
-
-        InstanceCreateInfo info{ {}, &appInfo, m_layerNames, extensionsAsCstrings };
-        m_instance = vk::createInstanceUnique(info);
-
-        vkExtInitInstance(static_cast<VkInstance>(*m_instance));
-
-        if (enableValidationLayers)
-        {
-            const auto flags{ reportLevel == DebugReport::ReportLevel::WarningsAndAbove ? vk::DebugReportFlagBitsEXT::eError | vk::DebugReportFlagBitsEXT::eWarning : vk::DebugReportFlagBitsEXT::eError | vk::DebugReportFlagBitsEXT::eWarning | vk::DebugReportFlagBitsEXT::eInformation | vk::DebugReportFlagBitsEXT::eDebug | vk::DebugReportFlagBitsEXT::ePerformanceWarning };
-            m_debugReportPtr = std::make_unique<DebugReport>(*this, flags);
-        }
-        
+        createInstance(appName, appVersion, engineName, engineVersion, window.getRequiredExtensions(), enableValidationLayers, reportLevel);
         m_surface = Surface(std::move(window.createSurface(m_instance)));
         m_physicalDevice = getSuitablePhysicalDevice(reinterpret_cast<const vk::UniqueSurfaceKHR &>(m_surface));
     }
 
+    Instance::Instance(const std::string& appName, const uint32_t appVersion, const std::string& engineName, const uint32_t engineVersion, const bool enableValidationLayers, const DebugReport::ReportLevel reportLevel)
+    {
+        createInstance(appName, appVersion, engineName, engineVersion, {}, enableValidationLayers, reportLevel);
+        m_physicalDevice = getSuitablePhysicalDevice(reinterpret_cast<const vk::UniqueSurfaceKHR &>(m_surface));
+    }
+
     PhysicalDevice Instance::getSuitablePhysicalDevice(const vk::UniqueSurfaceKHR & surface) const
     {
         const auto physicalDevices = m_instance->enumeratePhysicalDevices();
@@ -52,10 +37,19 @@ namespace bmvk
             const auto suitableQueueFamilyIndex = PhysicalDevice::getSuitableQueueFamilyIndex(physicalDevice, surface);
             if (suitableQueueFamilyIndex.has_value())
             {
-                foundSuitablePhysicalDevice = true;
-                chosenPhysicalDevice = physicalDevice;
-                chosenIndex = suitableQueueFamilyIndex.value();
-                break;
+                // Prefer a discrete GPU, but fall back to integrated or software implementations like lavapipe
+                const auto isDiscrete{ physicalDevice.getProperties().deviceType == vk::PhysicalDeviceType::eDiscreteGpu };
+                if (!foundSuitablePhysicalDevice || isDiscrete)
+                {
+                    foundSuitablePhysicalDevice = true;
+                    chosenPhysicalDevice = physicalDevice;
+                    chosenIndex = suitableQueueFamilyIndex.value();
+                }
+
+                if (isDiscrete)
+                {
+                    break;
+                }
             }
         }
 
@@ -72,7 +66,32 @@ namespace bmvk
         return m_instance->createDebugReportCallbackEXTUnique(info);
     }
 
-    std::vector<std::string> Instance::getExtensions(const bool enableValidationLayers, const vw::util::Window & window) const
+    void Instance::createInstance(const std::string & appName, const uint32_t appVersion, const std::string & engineName, const uint32_t engineVersion, const std::vector<std::string> & requiredExtensions, const bool enableValidationLayers, const DebugReport::ReportLevel reportLevel)
+    {
+        vk::ApplicationInfo appInfo{ appName.c_str(), appVersion, engineName.c_str(), engineVersion, VK_API_VERSION_1_0 };
+
+        const auto extensions = getExtensions(enableValidationLayers, requiredExtensions);
+        std::vector<const char*> extensionsAsCstrings{};
+        for (const auto& string : extensions)
+        {
+            extensionsAsCstrings.emplace_back(string.c_str());
+        }
+
+        initializeLayerNames(enableValidationLayers);
+
+        InstanceCreateInfo info{ {}, &appInfo, m_layerNames, extensionsAsCstrings };
+        m_instance = vk::createInstanceUnique(info);
+
+        vkExtInitInstance(static_cast<VkInstance>(*m_instance));
+
+        if (enableValidationLayers)
+        {
+            const auto flags{ reportLevel == DebugReport::ReportLevel::WarningsAndAbove ? vk::DebugReportFlagBitsEXT::eError | vk::DebugReportFlagBitsEXT::eWarning : vk::DebugReportFlagBitsEXT::eError | vk::DebugReportFlagBitsEXT::eWarning | vk::DebugReportFlagBitsEXT::eInformation | vk::DebugReportFlagBitsEXT::eDebug | vk::DebugReportFlagBitsEXT::ePerformanceWarning };
+            m_debugReportPtr = std::make_unique<DebugReport>(*this, flags);
+        }
+    }
+
+    std::vector<std::string> Instance::getExtensions(const bool enableValidationLayers, const std::vector<std::string> & requiredExtensions) const
     {
         const auto availableExtensions{ vk::enumerateInstanceExtensionProperties() };
 
@@ -84,8 +103,7 @@ namespace bmvk
             }
         }
 
-        const auto glfwExtensions = window.getRequiredExtensions();
-        for (const auto & neededExtension : glfwExtensions)
+        for (const auto & neededExtension : requiredExtensions)
         {
             if (std::find_if(availableExtensions.cbegin(), availableExtensions.cend(), [&](const auto & ex) { return ex.extensionName == neededExtension; }) == availableExtensions.cend())
             {
@@ -93,11 +111,7 @@ namespace bmvk
             }
         }
 
-        std::vector<std::string> extensions{};
-        for (const auto string : glfwExtensions)
-        {
-            extensions.emplace_back(string);
-        }
+        std::vector<std::string> extensions{ requiredExtensions };
 
         if (enableValidationLayers)
         {
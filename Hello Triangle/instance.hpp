@@ -21,6 +21,9 @@ namespace bmvk
     {
     public:
         Instance(const std::string & appName, const uint32_t appVersion, const std::string & engineName, const uint32_t engineVersion, const vw::util::Window & window, const bool enableValidationLayers, const DebugReport::ReportLevel reportLevel = DebugReport::ReportLevel::Everything);
+        // Headless, without a surface. The physical device only has to support graphics and compute, its logical device has to
+        // be created without the swapchain extension.
+        Instance(const std::string & appName, const uint32_t appVersion, const std::string & engineName, const uint32_t engineVersion, const bool enableValidationLayers, const DebugReport::ReportLevel reportLevel = DebugReport::ReportLevel::Everything);
         Instance(const Instance &) = delete;
         Instance(Instance && other) = default;
         Instance & operator=(const Instance &) = delete;
@@ -43,7 +46,8 @@ namespace bmvk
         PhysicalDevice m_physicalDevice;
         std::vector<const char *> m_layerNames;
 
-        std::vector<std::string> getExtensions(const bool enableValidationLayers, const vw::util::Window & window) const;
+        void createInstance(const std::string & appName, const uint32_t appVersion, const std::string & engineName, const uint32_t engineVersion, const std::vector<std::string> & requiredExtensions, const bool enableValidationLayers, const DebugReport::ReportLevel reportLevel);
+        std::vector<std::string> getExtensions(const bool enableValidationLayers, const std::vector<std::string> & requiredExtensions) const;
         void initializeLayerNames(const bool enableValidationLayers);
     };
 
@@ -0,0 +1,57 @@
+#include "mappedBuffer.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace bmvk
+{
+    MappedBuffer::MappedBuffer(const vk::UniqueDevice & device, vw::util::MemoryAllocator & allocator, const vk::DeviceSize size, const vk::BufferUsageFlags usage, const vw::util::MemoryUsage memoryUsage)
+      : m_device{ *device },
+        m_buffer{ device->createBufferUnique({ {}, size, usage }) },
+        m_allocation{ allocator.allocateBufferMemory(m_buffer, vk::MemoryPropertyFlagBits::eHostVisible, memoryUsage) },
+        m_size{ size },
+        m_nonCoherentAtomSize{ allocator.getNonCoherentAtomSize() },
+        m_coherent{ static_cast<bool>(allocator.getMemoryProperties().memoryTypes[m_allocation->memoryTypeIndex].propertyFlags & vk::MemoryPropertyFlagBits::eHostCoherent) }
+    {
+    }
+
+    void MappedBuffer::write(const void * data, const vk::DeviceSize size, const vk::DeviceSize offset)
+    {
+        memcpy(markWritten(offset, size), data, size);
+    }
+
+    void MappedBuffer::flush()
+    {
+        if (!m_coherent && m_writtenBegin < m_writtenEnd)
+        {
+            // The allocation starts at an atom and covers whole atoms, so the rounded range never leaves it
+            const auto begin{ m_writtenBegin / m_nonCoherentAtomSize * m_nonCoherentAtomSize };
+            const auto end{ std::min((m_writtenEnd + m_nonCoherentAtomSize - 1) / m_nonCoherentAtomSize * m_nonCoherentAtomSize, m_allocation->size) };
+            m_device.flushMappedMemoryRanges(vk::MappedMemoryRange{ m_allocation->memory, m_allocation->offset + begin, end - begin });
+        }
+
+        m_writtenBegin = 0;
+        m_writtenEnd = 0;
+    }
+
+    void * MappedBuffer::markWritten(const vk::DeviceSize offset, const vk::DeviceSize size)
+    {
+        if (offset + size > m_size)
+        {
+            throw std::invalid_argument("write exceeds the mapped buffer");
+        }
+
+        if (m_writtenBegin == m_writtenEnd)
+        {
+            m_writtenBegin = offset;
+            m_writtenEnd = offset + size;
+        }
+        else
+        {
+            m_writtenBegin = std::min(m_writtenBegin, offset);
+            m_writtenEnd = std::max(m_writtenEnd, offset + size);
+        }
+
+        return static_cast<uint8_t *>(m_allocation->mapped) + offset;
+    }
+}
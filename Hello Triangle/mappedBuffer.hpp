@@ -0,0 +1,83 @@
+#pragma once
+
+#include <type_traits>
+#include <vulkan/vulkan.hpp>
+
+#include <vw/memoryAllocator.hpp>
+
+namespace bmvk
+{
+    // A typed window into a mapped buffer, only valid until the buffer is flushed
+    template <class T>
+    class WriteView
+    {
+    public:
+        WriteView(T * data, const size_t size) : m_data{ data }, m_size{ size } {}
+
+        T & operator[](const size_t index) const noexcept { return m_data[index]; }
+        T * data() const noexcept { return m_data; }
+        size_t size() const noexcept { return m_size; }
+        T * begin() const noexcept { return m_data; }
+        T * end() const noexcept { return m_data + m_size; }
+    private:
+        T * m_data;
+        size_t m_size;
+    };
+
+    // A host visible buffer that stays mapped for its whole lifetime. Writes go through write views or write(), which remember
+    // the range they cover. flush() makes that range visible to the device, rounded to whole nonCoherentAtomSize atoms, and
+    // does nothing for coherent memory. The written ranges are merged into one, so writes should be close together.
+    class MappedBuffer
+    {
+    public:
+        MappedBuffer() {}
+        MappedBuffer(const vk::UniqueDevice & device, vw::util::MemoryAllocator & allocator, const vk::DeviceSize size, const vk::BufferUsageFlags usage, const vw::util::MemoryUsage memoryUsage = vw::util::MemoryUsage::Other);
+        MappedBuffer(const MappedBuffer &) = delete;
+        MappedBuffer(MappedBuffer && other) = default;
+        MappedBuffer & operator=(const MappedBuffer &) = delete;
+        MappedBuffer & operator=(MappedBuffer && other) = default;
+        ~MappedBuffer() {}
+
+        explicit operator const vk::UniqueBuffer &() const noexcept { return m_buffer; }
+        explicit operator bool() const noexcept { return static_cast<bool>(m_buffer); }
+
+        auto getSize() const noexcept { return m_size; }
+        bool isCoherent() const noexcept { return m_coherent; }
+
+        // count elements of T starting offset bytes into the buffer
+        template <class T>
+        WriteView<T> getWriteView(const size_t count, const vk::DeviceSize offset = 0);
+        void write(const void * data, const vk::DeviceSize size, const vk::DeviceSize offset = 0);
+        template <class T>
+        void write(const T & obj, const vk::DeviceSize offset = 0);
+        void flush();
+    private:
+        vk::Device m_device;
+        vk::UniqueBuffer m_buffer;
+        vw::util::UniqueAllocation m_allocation;
+        vk::DeviceSize m_size = 0;
+        vk::DeviceSize m_nonCoherentAtomSize = 1;
+        bool m_coherent = true;
+        vk::DeviceSize m_writtenBegin = 0;
+        vk::DeviceSize m_writtenEnd = 0;
+
+        void * markWritten(const vk::DeviceSize offset, const vk::DeviceSize size);
+    };
+
+    template <class T>
+    WriteView<T> MappedBuffer::getWriteView(const size_t count, const vk::DeviceSize offset)
+    {
+        return { static_cast<T *>(markWritten(offset, count * sizeof(T))), count };
+    }
+
+    template <class T>
+    void MappedBuffer::write(const T & obj, const vk::DeviceSize offset)
+    {
+        write(&obj, sizeof obj, offset);
+    }
+
+    static_assert(std::is_move_constructible_v<MappedBuffer>);
+    static_assert(!std::is_copy_constructible_v<MappedBuffer>);
+    static_assert(std::is_move_assignable_v<MappedBuffer>);
+    static_assert(!std::is_copy_assignable_v<MappedBuffer>);
+}
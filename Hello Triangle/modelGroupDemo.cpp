@@ -21,12 +21,9 @@ namespace bmvk
     template <vw::scene::VertexDescription VD>
     ModelGroupDemo<VD>::ModelGroupDemo(const bool enableValidationLayers, const uint32_t width, const uint32_t height)
         : ImguiBaseDemo{ enableValidationLayers, width, height, "ModelGroup Demo", DebugReport::ReportLevel::WarningsAndAbove },
-        m_imageAvailableSemaphore{ m_device.createSemaphore() },
-        m_renderFinishedSemaphore{ m_device.createSemaphore() },
-        m_renderImguiFinishedSemaphore{ m_device.createSemaphore() },
-        m_modelGroup{ static_cast<vk::PhysicalDevice>(m_instance.getPhysicalDevice()).getProperties(), k_maxObjectInstances }
+        m_modelGroup{ static_cast<vk::PhysicalDevice>(m_instance.getPhysicalDevice()).getProperties(), k_initialObjectInstances }
     {
-        m_modelIDs = m_modelGroup.addInstances(27);
+        m_modelIDs = m_modelGroup.addInstances(k_initialObjectInstances);
 
         setupCamera();
 
@@ -36,6 +33,7 @@ namespace bmvk
         createDepthResources();
         createFramebuffers();
         createModelGroup();
+        m_bufferFactory.getUploadBatcher().submit();
         createUniformBuffer();
         createRotations();
         createDescriptorPool();
@@ -46,6 +44,9 @@ namespace bmvk
     template <vw::scene::VertexDescription VD>
     void ModelGroupDemo<VD>::run()
     {
+        // The uploads have to be acquired by the queue before the first frame uses them
+        m_bufferFactory.waitIdle();
+
         while (!m_window.shouldClose())
         {
             /*
@@ -101,9 +102,6 @@ namespace bmvk
         }
 
         m_commandBuffers.clear();
-        m_depthImageView.reset(nullptr);
-        m_depthImage.reset(nullptr);
-        m_depthImageMemory.reset(nullptr);
         m_pipeline.reset(nullptr);
         m_pipelineLayout.reset(nullptr);
         m_renderPass.reset(nullptr);
@@ -142,7 +140,9 @@ namespace bmvk
         vk::AttachmentDescription depthAttachment{ {}, m_instance.getPhysicalDevice().findDepthFormat(), vk::SampleCountFlagBits::e1, vk::AttachmentLoadOp::eClear, vk::AttachmentStoreOp::eDontCare, vk::AttachmentLoadOp::eDontCare, vk::AttachmentStoreOp::eDontCare, vk::ImageLayout::eUndefined, vk::ImageLayout::eDepthStencilAttachmentOptimal };
         vk::AttachmentReference depthAttachmentRef{ 1, vk::ImageLayout::eDepthStencilAttachmentOptimal };
         vk::SubpassDescription subpass{ {}, vk::PipelineBindPoint::eGraphics, 0, nullptr, 1, &colorAttachmentRef, nullptr, &depthAttachmentRef };
-        vk::SubpassDependency dependency{ VK_SUBPASS_EXTERNAL, 0, vk::PipelineStageFlagBits::eColorAttachmentOutput, vk::PipelineStageFlagBits::eColorAttachmentOutput,{}, vk::AccessFlagBits::eColorAttachmentRead | vk::AccessFlagBits::eColorAttachmentWrite };
+        // The frames in flight share the depth image, so its clear waits for the depth writes of the previous frame
+        const auto stages{ vk::PipelineStageFlagBits::eColorAttachmentOutput | vk::PipelineStageFlagBits::eEarlyFragmentTests | vk::PipelineStageFlagBits::eLateFragmentTests };
+        vk::SubpassDependency dependency{ VK_SUBPASS_EXTERNAL, 0, stages, stages, vk::AccessFlagBits::eDepthStencilAttachmentWrite, vk::AccessFlagBits::eColorAttachmentRead | vk::AccessFlagBits::eColorAttachmentWrite | vk::AccessFlagBits::eDepthStencilAttachmentWrite };
         std::vector<vk::AttachmentDescription> vec{ colorAttachment, depthAttachment };
         RenderPassCreateInfo renderPassInfo{ {}, vec, subpass, dependency };
         m_renderPass = reinterpret_cast<const vk::UniqueDevice &>(m_device)->createRenderPassUnique(renderPassInfo);
@@ -183,7 +183,7 @@ namespace bmvk
         m_swapChainFramebuffers.clear();
         for (auto & uniqueImageView : m_swapchain.getImageViews())
         {
-            std::vector<vk::ImageView> imageViews{ *uniqueImageView, *m_depthImageView };
+            std::vector<vk::ImageView> imageViews{ *uniqueImageView, *m_transientAttachments.getImageView(m_depthAttachment) };
             m_swapChainFramebuffers.emplace_back(m_device.createFramebuffer(m_renderPass, imageViews, m_swapchain.getExtent().width, m_swapchain.getExtent().height, 1));
         }
     }
@@ -231,30 +231,24 @@ namespace bmvk
 
         m_modelGroup.setVertices(vertices);
         m_modelGroup.setIndices(indices);
-        m_modelGroup.createBuffers(reinterpret_cast<const vk::UniqueDevice &>(m_device), static_cast<vk::PhysicalDevice>(m_instance.getPhysicalDevice()), m_commandPool, static_cast<vk::Queue>(m_queue));
+        m_modelGroup.createBuffers(reinterpret_cast<const vk::UniqueDevice &>(m_device), *m_memoryAllocator, m_bufferFactory.getUploadBatcher());
     }
 
     template <vw::scene::VertexDescription VD>
     void ModelGroupDemo<VD>::createDepthResources()
     {
-        const auto depthFormat{ m_instance.getPhysicalDevice().findDepthFormat() };
-        createImage(m_swapchain.getExtent().width, m_swapchain.getExtent().height, depthFormat, vk::ImageTiling::eOptimal, vk::ImageUsageFlagBits::eDepthStencilAttachment, vk::MemoryPropertyFlagBits::eDeviceLocal, m_depthImage, m_depthImageMemory);
-        m_depthImageView = createImageView(m_depthImage, depthFormat, vk::ImageAspectFlagBits::eDepth);
-
-        auto cmdBuffer{ m_device.allocateCommandBuffer(m_commandPool) };
-        cmdBuffer.begin(vk::CommandBufferUsageFlagBits::eOneTimeSubmit);
-        transitionImageLayout(cmdBuffer, m_depthImage, depthFormat, vk::ImageLayout::eUndefined, vk::ImageLayout::eDepthStencilAttachmentOptimal);
-        cmdBuffer.end();
-        m_queue.submit(cmdBuffer);
-        m_queue.waitIdle();
+        // The render pass starts the depth attachment in undefined layout, so it needs no transition
+        m_transientAttachments.clear();
+        m_depthAttachment = m_transientAttachments.addAttachment(m_instance.getPhysicalDevice().findDepthFormat(), m_swapchain.getExtent(), vk::ImageUsageFlagBits::eDepthStencilAttachment, vk::ImageAspectFlagBits::eDepth);
+        m_transientAttachments.build();
     }
 
     template <vw::scene::VertexDescription VD>
     void ModelGroupDemo<VD>::createUniformBuffer()
     {
         const auto bufferSize{ sizeof(UniformBufferObject) };
-        const auto uniformBufferUsageFlags{ vk::BufferUsageFlagBits::eUniformBuffer };
-        const auto uniformBufferMemoryPropertyFlags{ vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent };
+        const auto uniformBufferUsageFlags{ vk::BufferUsageFlagBits::eUniformBuffer | vk::BufferUsageFlagBits::eTransferDst };
+        const auto uniformBufferMemoryPropertyFlags{ vk::MemoryPropertyFlagBits::eDeviceLocal };
         createBuffer(bufferSize, uniformBufferUsageFlags, uniformBufferMemoryPropertyFlags, m_uniformBuffer, m_uniformBufferMemory);
     }
 
@@ -338,7 +332,7 @@ namespace bmvk
         ubo.proj = m_camera.getProjMatrix();
         ubo.proj[1][1] *= -1;
 
-        m_device.copyToMemory(m_uniformBufferMemory, ubo);
+        m_frameScheduler.updateBuffer(m_uniformBuffer, ubo);
     }
 
     template <vw::scene::VertexDescription VD>
@@ -386,33 +380,36 @@ namespace bmvk
 
         m_animationTimer = 0.0f;
 
-        m_modelGroup.flush(reinterpret_cast<const vk::UniqueDevice &>(m_device));
+        // The previous frame may still read the matrices, so they are copied with the next submission. A grown group has moved
+        // its instances to a new buffer, which the descriptor set has to point to.
+        const auto upload{ [this](const vk::UniqueBuffer & buffer, const void * data, const vk::DeviceSize size, const vk::DeviceSize offset) { m_frameScheduler.updateBuffer(buffer, data, size, offset); } };
+        if (m_modelGroup.flush(reinterpret_cast<const vk::UniqueDevice &>(m_device), upload))
+        {
+            m_queue.waitIdle();
+            m_modelGroup.releaseRetiredBuffers();
+            vk::DescriptorBufferInfo dynamicBufferInfo{ m_modelGroup.getDescriptorBufferInfo() };
+            m_device.updateDescriptorSet(WriteDescriptorSet{ m_descriptorSets[0], 1, 0, 1, vk::DescriptorType::eUniformBufferDynamic, nullptr, &dynamicBufferInfo });
+            m_commandBuffers.clear();
+            createCommandBuffers();
+        }
     }
 
     template <vw::scene::VertexDescription VD>
     void ModelGroupDemo<VD>::drawFrame()
     {
-        m_queue.waitIdle();
         timing(false);
 
-        uint32_t imageIndex;
-        try
-        {
-            imageIndex = m_device.acquireNextImage(m_swapchain, m_imageAvailableSemaphore);
-        }
-        catch (const vk::OutOfDateKHRError &)
+        if (!m_frameScheduler.beginFrame(m_device, m_swapchain))
         {
             recreateSwapChain();
             return;
         }
 
-        m_queue.submit(m_commandBuffers[imageIndex], m_imageAvailableSemaphore, m_renderFinishedSemaphore, vk::PipelineStageFlagBits::eColorAttachmentOutput);
-        ImguiBaseDemo<VD>::drawFrame(imageIndex, m_renderFinishedSemaphore, m_renderImguiFinishedSemaphore);
+        const auto & frame{ m_frameScheduler.getFrame() };
+        m_frameScheduler.submit(m_device, m_queue, m_commandBuffers[m_frameScheduler.getImageIndex()], frame.imageAvailableSemaphore, frame.renderFinishedSemaphore, vk::PipelineStageFlagBits::eColorAttachmentOutput);
+        ImguiBaseDemo<VD>::drawFrame();
 
-        auto waitSemaphore{ *m_renderImguiFinishedSemaphore };
-        auto swapchain{ *reinterpret_cast<const vk::UniqueSwapchainKHR &>(m_swapchain) };
-        auto success{ m_queue.present(waitSemaphore, swapchain, imageIndex) };
-        if (!success)
+        if (!m_frameScheduler.endFrame(m_queue, m_swapchain, frame.overlayFinishedSemaphore))
         {
             recreateSwapChain();
         }
@@ -25,6 +25,8 @@ namespace bmvk
         void recreateSwapChain() override;
     private:
         static const uint32_t k_maxObjectInstances = 1000;
+        // The group grows on demand, so it is only sized for the initial cubes
+        static const uint32_t k_initialObjectInstances = 27;
 
         glm::vec3 m_rotations[k_maxObjectInstances];
         glm::vec3 m_rotationSpeeds[k_maxObjectInstances];
@@ -46,19 +48,14 @@ namespace bmvk
         vk::UniquePipeline m_pipeline;
         std::vector<vk::UniqueFramebuffer> m_swapChainFramebuffers;
 
-        vk::UniqueDeviceMemory m_depthImageMemory;
-        vk::UniqueImage m_depthImage;
-        vk::UniqueImageView m_depthImageView;
+        vw::util::TransientAttachmentAllocator::AttachmentId m_depthAttachment = 0;
 
-        vk::UniqueDeviceMemory m_uniformBufferMemory;
+        vw::util::UniqueAllocation m_uniformBufferMemory;
         vk::UniqueBuffer m_uniformBuffer;
 
         vk::UniqueDescriptorPool m_descriptorPool;
         std::vector<vk::UniqueDescriptorSet> m_descriptorSets;
         std::vector<CommandBuffer> m_commandBuffers;
-        vk::UniqueSemaphore m_imageAvailableSemaphore;
-        vk::UniqueSemaphore m_renderFinishedSemaphore;
-        vk::UniqueSemaphore m_renderImguiFinishedSemaphore;
 
         vw::scene::ModelGroup<VD> m_modelGroup;
 
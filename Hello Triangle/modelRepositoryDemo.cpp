@@ -4,6 +4,8 @@
 #include <imgui/imgui.h>
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/matrix_inverse.hpp>
+#include <glm/gtc/quaternion.hpp>
+#include <vw/meshOptimizer.hpp>
 #include <vw/modelLoader.hpp>
 
 #include "shader.hpp"
@@ -17,20 +19,21 @@ namespace bmvk
 {
     const std::string K_VERTEX_SHADER_PATH{ "../shaders/modelRepositoryDemo/vertex.vert.spv" };
     const std::string K_FRAGMENT_SHADER_PATH{ "../shaders/modelRepositoryDemo/fragment.frag.spv" };
+    const std::string K_CULL_SHADER_PATH{ "../shaders/modelRepositoryDemo/cull.comp.spv" };
 
     ModelRepositoryDemo::ModelRepositoryDemo(const bool enableValidationLayers, const uint32_t width, const uint32_t height)
-        : ImguiBaseDemo{ enableValidationLayers, width, height, "ModelRepository Demo", DebugReport::ReportLevel::WarningsAndAbove },
-        m_queryPool{ reinterpret_cast<const vk::UniqueDevice &>(m_device)->createQueryPoolUnique({ {}, vk::QueryType::eTimestamp, 2 }) },
-        m_imageAvailableSemaphore{ m_device.createSemaphore() },
-        m_renderFinishedSemaphore{ m_device.createSemaphore() },
-        m_renderImguiFinishedSemaphore{ m_device.createSemaphore() }
+        : ImguiBaseDemo{ enableValidationLayers, width, height, "ModelRepository Demo", DebugReport::ReportLevel::WarningsAndAbove, k_initialObjectInstances, k_instanceFormat },
+        m_queryPool{ reinterpret_cast<const vk::UniqueDevice &>(m_device)->createQueryPoolUnique({ {}, vk::QueryType::eTimestamp, 2 * k_maxFramesInFlight }) }
     {
         setupCamera();
         initModels();
+        m_bufferFactory.getUploadBatcher().submit();
+        m_cullingModeI = static_cast<int>(m_modelRepository.drawsIndirect() ? CullingMode::Gpu : CullingMode::None);
 
         createDescriptorSetLayout();
         createRenderPass();
         createPipelines();
+        createCullPipeline();
         createDepthResources();
         createFramebuffers();
         createUniformBuffer();
@@ -42,6 +45,9 @@ namespace bmvk
 
     void ModelRepositoryDemo::run()
     {
+        // The uploads have to be acquired by the queue before the first frame uses them
+        m_bufferFactory.waitIdle();
+
         while (!m_window.shouldClose())
         {
             /*
@@ -60,13 +66,23 @@ namespace bmvk
             // Tip: if we don't call ImGui::Begin()/ImGui::End() the widgets appears in a window automatically called "Debug"
             {
                 ImGui::SetNextWindowPos(ImVec2(10, 10));
-                ImGui::SetNextWindowSize(ImVec2(400, 100), ImGuiCond_Once);
+                ImGui::SetNextWindowSize(ImVec2(400, 140), ImGuiCond_Once);
                 ImGui::Begin("Performance");
                 ImGui::Text("Application average %.3f ms/frame (%.1f FPS)", m_avgFrameTime / 1000.0, m_avgFps);
                 ImGui::Text("Rendering average %.3f ms/frame", m_avgRenderFrameTime);
                 ImGui::Text("Imgui Rendering average %.3f ms/frame", m_avgImguiRenderFrameTime);
-                const char* items[] = { "1", "8", "27", "64", "125", "216", "343", "512", "729", "1000" };
+                const char* items[] = { "1", "8", "27", "64", "125", "216", "343", "512", "729", "1000", "8000", "27000", "64000", "125000" };
                 ImGui::Combo("Number of cubes", &m_numCubesI, items, static_cast<int>(sizeof(items) / sizeof(*items)));
+                const char* cullingItems[] = { "None", "CPU", "GPU" };
+                if (m_modelRepository.drawsIndirect() && ImGui::Combo("Frustum culling", &m_cullingModeI, cullingItems, static_cast<int>(sizeof(cullingItems) / sizeof(*cullingItems))))
+                {
+                    updateCulling();
+                }
+
+                if (static_cast<CullingMode>(m_cullingModeI) == CullingMode::Cpu)
+                {
+                    ImGui::Text("CPU culling average %.3f ms, %u of %u visible", m_avgCullTime, m_numVisibleInstances, m_currentNumInstances);
+                }
                 ImGui::End();
             }
 
@@ -98,9 +114,6 @@ namespace bmvk
         }
 
         m_commandBuffers.clear();
-        m_depthImageView.reset(nullptr);
-        m_depthImage.reset(nullptr);
-        m_depthImageMemory.reset(nullptr);
         m_pipeline.reset(nullptr);
         m_pipelineLayout.reset(nullptr);
         m_renderPass.reset(nullptr);
@@ -162,15 +175,24 @@ namespace bmvk
         // down
         createSide(vertices, indices, { 0.f, -1.f, 0.f }, { -1.f, -1.f, -1.f }, { 1.f, -1.f, -1.f }, { 1.f, -1.f, 1.f }, { -1.f, -1.f, 1.f }, 20);
 
-        m_cubeResourceId = m_modelRepository.addResource(std::move(vertices), std::move(indices), reinterpret_cast<const vk::UniqueDevice &>(m_device), reinterpret_cast<const vk::PhysicalDevice &>(m_instance.getPhysicalDevice()), m_commandPool, reinterpret_cast<const vk::Queue &>(m_queue));
-        m_modelIDs = m_modelRepository.createInstances(m_cubeResourceId, m_currentNumInstances);
+        vw::scene::optimizeMesh(vertices, indices);
+        m_cubeResourceId = m_modelRepository.addResourceAsync(std::move(vertices), std::move(indices), reinterpret_cast<const vk::UniqueDevice &>(m_device), *m_memoryAllocator, m_bufferFactory.getUploadBatcher());
+        m_instanceIDs = m_modelRepository.createInstances(m_cubeResourceId, m_currentNumInstances);
     }
 
     void ModelRepositoryDemo::createDescriptorSetLayout()
     {
         vk::DescriptorSetLayoutBinding uboLayoutBinding{ 0, vk::DescriptorType::eUniformBuffer, 1, vk::ShaderStageFlagBits::eVertex };
-        vk::DescriptorSetLayoutBinding dynamicUboLayoutBinding{ 1, vk::DescriptorType::eUniformBufferDynamic, 1, vk::ShaderStageFlagBits::eVertex };
-        m_descriptorSetLayout = m_device.createDescriptorSetLayout({ uboLayoutBinding, dynamicUboLayoutBinding });
+        vk::DescriptorSetLayoutBinding instanceLayoutBinding{ 1, vk::DescriptorType::eStorageBuffer, 1, vk::ShaderStageFlagBits::eVertex };
+        m_descriptorSetLayout = m_device.createDescriptorSetLayout({ uboLayoutBinding, instanceLayoutBinding });
+
+        // Camera, then the culling buffers of the model repository
+        std::vector<vk::DescriptorSetLayoutBinding> cullBindings{ { 0, vk::DescriptorType::eUniformBuffer, 1, vk::ShaderStageFlagBits::eCompute } };
+        for (uint32_t binding = 1; binding <= 6; ++binding)
+        {
+            cullBindings.emplace_back(binding, vk::DescriptorType::eStorageBuffer, 1, vk::ShaderStageFlagBits::eCompute);
+        }
+        m_cullDescriptorSetLayout = m_device.createDescriptorSetLayout(cullBindings);
     }
 
     void ModelRepositoryDemo::createRenderPass()
@@ -180,7 +202,9 @@ namespace bmvk
         vk::AttachmentDescription depthAttachment{ {}, m_instance.getPhysicalDevice().findDepthFormat(), vk::SampleCountFlagBits::e1, vk::AttachmentLoadOp::eClear, vk::AttachmentStoreOp::eDontCare, vk::AttachmentLoadOp::eDontCare, vk::AttachmentStoreOp::eDontCare, vk::ImageLayout::eUndefined, vk::ImageLayout::eDepthStencilAttachmentOptimal };
         vk::AttachmentReference depthAttachmentRef{ 1, vk::ImageLayout::eDepthStencilAttachmentOptimal };
         vk::SubpassDescription subpass{ {}, vk::PipelineBindPoint::eGraphics, 0, nullptr, 1, &colorAttachmentRef, nullptr, &depthAttachmentRef };
-        vk::SubpassDependency dependency{ VK_SUBPASS_EXTERNAL, 0, vk::PipelineStageFlagBits::eColorAttachmentOutput, vk::PipelineStageFlagBits::eColorAttachmentOutput,{}, vk::AccessFlagBits::eColorAttachmentRead | vk::AccessFlagBits::eColorAttachmentWrite };
+        // The frames in flight share the depth image, so its clear waits for the depth writes of the previous frame
+        const auto stages{ vk::PipelineStageFlagBits::eColorAttachmentOutput | vk::PipelineStageFlagBits::eEarlyFragmentTests | vk::PipelineStageFlagBits::eLateFragmentTests };
+        vk::SubpassDependency dependency{ VK_SUBPASS_EXTERNAL, 0, stages, stages, vk::AccessFlagBits::eDepthStencilAttachmentWrite, vk::AccessFlagBits::eColorAttachmentRead | vk::AccessFlagBits::eColorAttachmentWrite | vk::AccessFlagBits::eDepthStencilAttachmentWrite };
         std::vector<vk::AttachmentDescription> vec{ colorAttachment, depthAttachment };
         RenderPassCreateInfo renderPassInfo{ {}, vec, subpass, dependency };
         m_renderPass = reinterpret_cast<const vk::UniqueDevice &>(m_device)->createRenderPassUnique(renderPassInfo);
@@ -190,7 +214,9 @@ namespace bmvk
     {
         const Shader vertShader{ K_VERTEX_SHADER_PATH, m_device };
         const Shader fragShader{ K_FRAGMENT_SHADER_PATH, m_device };
-        const auto vertShaderStageInfo{ vertShader.createPipelineShaderStageCreateInfo(vk::ShaderStageFlagBits::eVertex) };
+        const vk::SpecializationMapEntry formatEntry{ 0, 0, sizeof(vw::util::InstanceFormat) };
+        const vk::SpecializationInfo specializationInfo{ 1, &formatEntry, sizeof(k_instanceFormat), &k_instanceFormat };
+        const auto vertShaderStageInfo{ vertShader.createPipelineShaderStageCreateInfo(vk::ShaderStageFlagBits::eVertex, &specializationInfo) };
         const auto fragShaderStageInfo{ fragShader.createPipelineShaderStageCreateInfo(vk::ShaderStageFlagBits::eFragment) };
         vk::PipelineShaderStageCreateInfo shaderStages[] = { vertShaderStageInfo, fragShaderStageInfo };
 
@@ -214,80 +240,142 @@ namespace bmvk
         m_pipeline = reinterpret_cast<const vk::UniqueDevice &>(m_device)->createGraphicsPipelineUnique(nullptr, colorPipelineInfo);
     }
 
+    void ModelRepositoryDemo::createCullPipeline()
+    {
+        const Shader cullShader{ K_CULL_SHADER_PATH, m_device };
+        const vk::PushConstantRange pushConstantRange{ vk::ShaderStageFlagBits::eCompute, 0, sizeof(uint32_t) };
+        m_cullPipelineLayout = m_device.createPipelineLayout({ *m_cullDescriptorSetLayout }, { pushConstantRange });
+        const vk::SpecializationMapEntry formatEntry{ 0, 0, sizeof(vw::util::InstanceFormat) };
+        const vk::SpecializationInfo specializationInfo{ 1, &formatEntry, sizeof(k_instanceFormat), &k_instanceFormat };
+        m_cullPipeline = m_device.createComputePipeline(cullShader, m_cullPipelineLayout, &specializationInfo);
+    }
+
     void ModelRepositoryDemo::createFramebuffers()
     {
         m_swapChainFramebuffers.clear();
         for (auto & uniqueImageView : m_swapchain.getImageViews())
         {
-            std::vector<vk::ImageView> imageViews{ *uniqueImageView, *m_depthImageView };
+            std::vector<vk::ImageView> imageViews{ *uniqueImageView, *m_transientAttachments.getImageView(m_depthAttachment) };
             m_swapChainFramebuffers.emplace_back(m_device.createFramebuffer(m_renderPass, imageViews, m_swapchain.getExtent().width, m_swapchain.getExtent().height, 1));
         }
     }
 
     void ModelRepositoryDemo::createDepthResources()
     {
-        const auto depthFormat{ m_instance.getPhysicalDevice().findDepthFormat() };
-        createImage(m_swapchain.getExtent().width, m_swapchain.getExtent().height, depthFormat, vk::ImageTiling::eOptimal, vk::ImageUsageFlagBits::eDepthStencilAttachment, vk::MemoryPropertyFlagBits::eDeviceLocal, m_depthImage, m_depthImageMemory);
-        m_depthImageView = createImageView(m_depthImage, depthFormat, vk::ImageAspectFlagBits::eDepth);
-
-        auto cmdBuffer{ m_device.allocateCommandBuffer(m_commandPool) };
-        cmdBuffer.begin(vk::CommandBufferUsageFlagBits::eOneTimeSubmit);
-        transitionImageLayout(cmdBuffer, m_depthImage, depthFormat, vk::ImageLayout::eUndefined, vk::ImageLayout::eDepthStencilAttachmentOptimal);
-        cmdBuffer.end();
-        m_queue.submit(cmdBuffer);
-        m_queue.waitIdle();
+        // The render pass starts the depth attachment in undefined layout, so it needs no transition
+        m_transientAttachments.clear();
+        m_depthAttachment = m_transientAttachments.addAttachment(m_instance.getPhysicalDevice().findDepthFormat(), m_swapchain.getExtent(), vk::ImageUsageFlagBits::eDepthStencilAttachment, vk::ImageAspectFlagBits::eDepth);
+        m_transientAttachments.build();
     }
 
     void ModelRepositoryDemo::createUniformBuffer()
     {
         const auto bufferSize{ sizeof(UniformBufferObject) };
-        const auto uniformBufferUsageFlags{ vk::BufferUsageFlagBits::eUniformBuffer };
-        const auto uniformBufferMemoryPropertyFlags{ vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent };
-        createBuffer(bufferSize, uniformBufferUsageFlags, uniformBufferMemoryPropertyFlags, m_uniformBuffer, m_uniformBufferMemory);
+        const auto uniformBufferUsageFlags{ vk::BufferUsageFlagBits::eUniformBuffer | vk::BufferUsageFlagBits::eTransferDst };
+        const auto uniformBufferMemoryPropertyFlags{ vk::MemoryPropertyFlagBits::eDeviceLocal };
+        m_uniformBuffers.resize(k_maxFramesInFlight);
+        m_uniformBufferMemories.resize(k_maxFramesInFlight);
+        for (uint32_t frame = 0; frame < k_maxFramesInFlight; ++frame)
+        {
+            createBuffer(bufferSize, uniformBufferUsageFlags, uniformBufferMemoryPropertyFlags, m_uniformBuffers[frame], m_uniformBufferMemories[frame]);
+        }
     }
 
     void ModelRepositoryDemo::createRotations()
     {
         std::default_random_engine rndEngine(static_cast<unsigned int>(time(nullptr)));
         std::normal_distribution<float> rndDist(-1.0f, 1.0f);
+        m_rotations.resize(k_maxObjectInstances);
+        m_rotationSpeeds.resize(k_maxObjectInstances);
         for (uint32_t i = 0; i < k_maxObjectInstances; ++i) {
             m_rotations[i] = glm::vec3(rndDist(rndEngine), rndDist(rndEngine), rndDist(rndEngine)) * 2.f * static_cast<float>(M_PI);
             m_rotationSpeeds[i] = glm::vec3(rndDist(rndEngine), rndDist(rndEngine), rndDist(rndEngine));
         }
+
+        m_instanceTransforms.rotationX.resize(k_maxObjectInstances);
+        m_instanceTransforms.rotationY.resize(k_maxObjectInstances);
+        m_instanceTransforms.rotationZ.resize(k_maxObjectInstances);
+        m_instanceTransforms.rotationW.resize(k_maxObjectInstances);
+        updateInstancePositions();
     }
 
     void ModelRepositoryDemo::createDescriptorPool()
     {
-        vk::DescriptorPoolSize poolSize{ vk::DescriptorType::eUniformBuffer, 1 };
-        vk::DescriptorPoolSize poolSize2{ vk::DescriptorType::eUniformBufferDynamic, 1 };
+        // A graphics and a culling set per frame in flight
+        vk::DescriptorPoolSize poolSize{ vk::DescriptorType::eUniformBuffer, 2 * k_maxFramesInFlight };
+        vk::DescriptorPoolSize poolSize2{ vk::DescriptorType::eStorageBuffer, 7 * k_maxFramesInFlight };
         std::vector<vk::DescriptorPoolSize> vec{ poolSize, poolSize2 };
-        m_descriptorPool = m_device.createDescriptorPool(vk::DescriptorPoolCreateFlagBits::eFreeDescriptorSet, 1, vec);
+        m_descriptorPool = m_device.createDescriptorPool(vk::DescriptorPoolCreateFlagBits::eFreeDescriptorSet, 2 * k_maxFramesInFlight, vec);
     }
 
     void ModelRepositoryDemo::createDescriptorSet()
     {
-        vk::DescriptorSetLayout layouts[] = { *m_descriptorSetLayout };
-        vk::DescriptorSetAllocateInfo allocInfo{ *m_descriptorPool, 1, layouts };
+        std::vector<vk::DescriptorSetLayout> layouts;
+        for (uint32_t frame = 0; frame < k_maxFramesInFlight; ++frame)
+        {
+            layouts.emplace_back(*m_descriptorSetLayout);
+            layouts.emplace_back(*m_cullDescriptorSetLayout);
+        }
+        vk::DescriptorSetAllocateInfo allocInfo{ *m_descriptorPool, static_cast<uint32_t>(layouts.size()), layouts.data() };
         m_descriptorSets = reinterpret_cast<const vk::UniqueDevice &>(m_device)->allocateDescriptorSetsUnique(allocInfo);
 
-        vk::DescriptorBufferInfo bufferInfo{ *m_uniformBuffer, 0, sizeof(UniformBufferObject) };
-        WriteDescriptorSet descriptorWrite{ m_descriptorSets[0], 0, 0, 1, vk::DescriptorType::eUniformBuffer, nullptr, &bufferInfo };
-        const auto info{ m_modelRepository.getDescriptorBufferInfo() };
-        std::vector<vk::WriteDescriptorSet> vec{ descriptorWrite, m_modelRepository.getWriteDescriptorSet(m_descriptorSets[0], 1, info) };
+        // Each frame in flight reads its own copy of the instance data
+        for (uint32_t frame = 0; frame < k_maxFramesInFlight; ++frame)
+        {
+            writeDescriptorSets(frame);
+        }
+    }
+
+    void ModelRepositoryDemo::writeDescriptorSets(const uint32_t frame)
+    {
+        // With culling, the vertex shader reads the compacted visible instances instead of all instances
+        vk::DescriptorBufferInfo bufferInfo{ *m_uniformBuffers[frame], 0, sizeof(UniformBufferObject) };
+        const auto info{ static_cast<CullingMode>(m_cullingModeI) == CullingMode::Gpu ? m_modelRepository.getVisibleInstanceDescriptorBufferInfo(frame) : m_modelRepository.getDescriptorBufferInfo(frame) };
+        const auto cullInfos{ m_modelRepository.getCullingDescriptorBufferInfos(frame) };
+
+        std::vector<vk::WriteDescriptorSet> vec;
+        const auto & descriptorSet{ m_descriptorSets[2 * frame] };
+        const auto & cullDescriptorSet{ m_descriptorSets[2 * frame + 1] };
+        vec.emplace_back(WriteDescriptorSet{ descriptorSet, 0, 0, 1, vk::DescriptorType::eUniformBuffer, nullptr, &bufferInfo });
+        vec.emplace_back(m_modelRepository.getWriteDescriptorSet(descriptorSet, 1, info));
+
+        vec.emplace_back(WriteDescriptorSet{ cullDescriptorSet, 0, 0, 1, vk::DescriptorType::eUniformBuffer, nullptr, &bufferInfo });
+        for (size_t i = 0; i < cullInfos.size(); ++i)
+        {
+            vec.emplace_back(WriteDescriptorSet{ cullDescriptorSet, static_cast<uint32_t>(i + 1), 0, 1, vk::DescriptorType::eStorageBuffer, nullptr, &cullInfos[i] });
+        }
+
         m_device.updateDescriptorSets(vec);
     }
 
     void ModelRepositoryDemo::createCommandBuffers()
     {
-        m_commandBuffers = m_device.allocateCommandBuffers(m_commandPool, static_cast<uint32_t>(m_swapChainFramebuffers.size()));
-        for (size_t i = 0; i < m_commandBuffers.size(); ++i)
+        // One command buffer per frame in flight and swapchain image
+        const auto numImages{ m_swapChainFramebuffers.size() };
+        m_commandBuffers = m_device.allocateCommandBuffers(m_commandPool, static_cast<uint32_t>(k_maxFramesInFlight * numImages));
+        for (uint32_t frame = 0; frame < k_maxFramesInFlight; ++frame)
         {
-            const auto & cmdBuffer{ m_commandBuffers[i] };
+            recordCommandBuffers(frame);
+        }
+    }
+
+    void ModelRepositoryDemo::recordCommandBuffers(const uint32_t frame)
+    {
+        const auto numImages{ m_swapChainFramebuffers.size() };
+        for (size_t i = 0; i < numImages; ++i)
+        {
+            const auto & cmdBuffer{ m_commandBuffers[frame * numImages + i] };
             cmdBuffer.begin(vk::CommandBufferUsageFlagBits::eSimultaneousUse);
 
             const auto & cb_vk{ reinterpret_cast<const vk::UniqueCommandBuffer &>(cmdBuffer) };
-            cb_vk->resetQueryPool(*m_queryPool, 0, 2);
-            cb_vk->writeTimestamp(vk::PipelineStageFlagBits::eBottomOfPipe, *m_queryPool, 0);
+            cb_vk->resetQueryPool(*m_queryPool, 2 * frame, 2);
+            cb_vk->writeTimestamp(vk::PipelineStageFlagBits::eBottomOfPipe, *m_queryPool, 2 * frame);
+
+            if (static_cast<CullingMode>(m_cullingModeI) == CullingMode::Gpu)
+            {
+                cmdBuffer.bindPipeline(m_cullPipeline, vk::PipelineBindPoint::eCompute);
+                m_modelRepository.cull(cb_vk, m_cullPipelineLayout, m_descriptorSets[2 * frame + 1], frame);
+            }
 
             std::vector<vk::ClearValue> clearValues{ vk::ClearColorValue{ std::array<float, 4>{ 0.f, 0.f, 0.f, 1.f } }, vk::ClearDepthStencilValue{ 1.f, 0 } };
             cmdBuffer.beginRenderPass(m_renderPass, m_swapChainFramebuffers[i], { { 0, 0 }, m_swapchain.getExtent() }, clearValues);
@@ -295,10 +383,17 @@ namespace bmvk
             vk::Viewport vp{ 0.f, 0.f, static_cast<float>(extent.width), static_cast<float>(extent.height), 0.f, 1.f };
             cmdBuffer.setViewport(vp);
             cmdBuffer.bindPipeline(m_pipeline);
-            m_modelRepository.draw(cb_vk, m_pipelineLayout, m_descriptorSets[0]);
+            if (static_cast<CullingMode>(m_cullingModeI) == CullingMode::Gpu)
+            {
+                m_modelRepository.drawCulled(cb_vk, m_pipelineLayout, m_descriptorSets[2 * frame], frame);
+            }
+            else
+            {
+                m_modelRepository.draw(cb_vk, m_pipelineLayout, m_descriptorSets[2 * frame], frame);
+            }
             cmdBuffer.endRenderPass();
 
-            cb_vk->writeTimestamp(vk::PipelineStageFlagBits::eBottomOfPipe, *m_queryPool, 1);
+            cb_vk->writeTimestamp(vk::PipelineStageFlagBits::eBottomOfPipe, *m_queryPool, 2 * frame + 1);
 
             cmdBuffer.end();
         }
@@ -306,18 +401,73 @@ namespace bmvk
 
     void ModelRepositoryDemo::updateNumObjects()
     {
-        const auto currentNum = std::min(static_cast<int>(k_maxObjectInstances), (m_numCubesI + 1) * (m_numCubesI + 1) * (m_numCubesI + 1));
+        const int dims[] = { 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 20, 30, 40, 50 };
+        const auto dim{ dims[m_numCubesI] };
+        const auto currentNum = std::min(static_cast<int>(k_maxObjectInstances), dim * dim * dim);
         if (currentNum != m_currentNumInstances)
         {
             m_currentNumInstances = currentNum;
-            m_modelRepository.destroyInstances(m_modelIDs);
-            m_modelIDs = m_modelRepository.createInstances(m_cubeResourceId, m_currentNumInstances);
-            m_queue.waitIdle();
-            m_commandBuffers.clear();
-            createCommandBuffers();
+            m_modelRepository.destroyInstances(m_instanceIDs);
+            m_instanceIDs = m_modelRepository.createInstances(m_cubeResourceId, m_currentNumInstances);
+            updateInstancePositions();
+
+            // The instance counts live in the indirect buffers, so the recorded command buffers can be kept
+            if (!m_modelRepository.drawsIndirect())
+            {
+                m_queue.waitIdle();
+                m_commandBuffers.clear();
+                createCommandBuffers();
+            }
+        }
+    }
+
+    void ModelRepositoryDemo::updateInstancePositions()
+    {
+        // Cubes are placed on a grid centered at the origin
+        const auto dim = static_cast<uint32_t>(std::round(std::cbrt(m_currentNumInstances)));
+        const glm::vec3 offset(5.0f);
+
+        m_instanceTransforms.translationX.resize(m_currentNumInstances);
+        m_instanceTransforms.translationY.resize(m_currentNumInstances);
+        m_instanceTransforms.translationZ.resize(m_currentNumInstances);
+        for (uint32_t x = 0; x < dim; ++x)
+        {
+            for (uint32_t y = 0; y < dim; ++y)
+            {
+                for (uint32_t z = 0; z < dim; ++z)
+                {
+                    uint32_t index = x * dim * dim + y * dim + z;
+                    if (index >= m_instanceIDs.size())
+                    {
+                        throw std::runtime_error("index does not match model id");
+                    }
+
+                    m_instanceTransforms.translationX[index] = -((dim * offset.x) / 2.0f) + offset.x / 2.0f + x * offset.x;
+                    m_instanceTransforms.translationY[index] = -((dim * offset.y) / 2.0f) + offset.y / 2.0f + y * offset.y;
+                    m_instanceTransforms.translationZ[index] = -((dim * offset.z) / 2.0f) + offset.z / 2.0f + z * offset.z;
+                }
+            }
         }
     }
 
+    void ModelRepositoryDemo::updateCulling()
+    {
+        m_queue.waitIdle();
+
+        if (static_cast<CullingMode>(m_cullingModeI) != CullingMode::Cpu)
+        {
+            m_modelRepository.resetCulling();
+        }
+
+        for (uint32_t frame = 0; frame < k_maxFramesInFlight; ++frame)
+        {
+            const auto info{ static_cast<CullingMode>(m_cullingModeI) == CullingMode::Gpu ? m_modelRepository.getVisibleInstanceDescriptorBufferInfo(frame) : m_modelRepository.getDescriptorBufferInfo(frame) };
+            m_device.updateDescriptorSet(m_modelRepository.getWriteDescriptorSet(m_descriptorSets[2 * frame], 1, info));
+        }
+        m_commandBuffers.clear();
+        createCommandBuffers();
+    }
+
     void ModelRepositoryDemo::updateUniformBuffer()
     {
         UniformBufferObject ubo;
@@ -327,7 +477,8 @@ namespace bmvk
         ubo.proj = m_camera.getProjMatrix();
         ubo.proj[1][1] *= -1;
 
-        m_device.copyToMemory(m_uniformBufferMemory, ubo);
+        // Written for the frame that is drawn next
+        m_frameScheduler.updateFrameLocalBuffer(m_uniformBuffers[m_frameScheduler.getFrameIndex()], ubo, vk::PipelineStageFlagBits::eVertexShader | vk::PipelineStageFlagBits::eComputeShader);
     }
 
     void ModelRepositoryDemo::updateDynamicUniformBuffer()
@@ -339,59 +490,45 @@ namespace bmvk
             return;
         }
 
-        // Dynamic ubo with per-object model matrices indexed by offsets in the command buffer
-        const auto dim = static_cast<uint32_t>(pow(m_currentNumInstances, 1.0f / 3.0f));
-        const glm::vec3 offset(5.0f);
-
-        for (uint32_t x = 0; x < dim; ++x)
+        // Update rotations, the model matrices are composed by the model repository in one batch
+        const auto axisX{ glm::normalize(glm::vec3(1.0f, 1.0f, 0.0f)) };
+        for (uint32_t i = 0; i < m_currentNumInstances; ++i)
         {
-            for (uint32_t y = 0; y < dim; ++y)
-            {
-                for (uint32_t z = 0; z < dim; ++z)
-                {
-                    uint32_t index = x * dim * dim + y * dim + z;
-                    if (index >= m_modelIDs.size())
-                    {
-                        throw std::runtime_error("index does not match model id");
-                    }
-
-                    // Aligned offset
-                    //glm::mat4 * modelMat = reinterpret_cast<glm::mat4 *>((reinterpret_cast<uint64_t>(m_dynamicUniformBufferObject.model) + (index * m_dynamicAlignment)));
-
-                    // Update rotations
-                    m_rotations[index] += m_animationTimer * m_rotationSpeeds[index];
-
-                    // Update matrices
-                    glm::vec3 pos = glm::vec3(-((dim * offset.x) / 2.0f) + offset.x / 2.0f + x * offset.x, -((dim * offset.y) / 2.0f) + offset.y / 2.0f + y * offset.y, -((dim * offset.z) / 2.0f) + offset.z / 2.0f + z * offset.z);
-                    auto modelMat = glm::translate(glm::mat4(1.0f), pos);
-                    modelMat = glm::rotate(modelMat, m_rotations[index].x, glm::vec3(1.0f, 1.0f, 0.0f));
-                    modelMat = glm::rotate(modelMat, m_rotations[index].y, glm::vec3(0.0f, 1.0f, 0.0f));
-                    modelMat = glm::rotate(modelMat, m_rotations[index].z, glm::vec3(0.0f, 0.0f, 1.0f));
-                    m_modelRepository.setModelMatrix(m_modelIDs[index], modelMat);
-                }
-            }
+            m_rotations[i] += m_animationTimer * m_rotationSpeeds[i];
+            const auto rotation{ glm::angleAxis(m_rotations[i].x, axisX) * glm::angleAxis(m_rotations[i].y, glm::vec3(0.0f, 1.0f, 0.0f)) * glm::angleAxis(m_rotations[i].z, glm::vec3(0.0f, 0.0f, 1.0f)) };
+            m_instanceTransforms.rotationX[i] = rotation.x;
+            m_instanceTransforms.rotationY[i] = rotation.y;
+            m_instanceTransforms.rotationZ[i] = rotation.z;
+            m_instanceTransforms.rotationW[i] = rotation.w;
         }
 
+        vw::util::TransformArrays transforms;
+        transforms.translationX = m_instanceTransforms.translationX.data();
+        transforms.translationY = m_instanceTransforms.translationY.data();
+        transforms.translationZ = m_instanceTransforms.translationZ.data();
+        transforms.rotationX = m_instanceTransforms.rotationX.data();
+        transforms.rotationY = m_instanceTransforms.rotationY.data();
+        transforms.rotationZ = m_instanceTransforms.rotationZ.data();
+        transforms.rotationW = m_instanceTransforms.rotationW.data();
+        m_modelRepository.setTransforms(m_instanceIDs, transforms);
+
         m_animationTimer = 0.0f;
 
-        m_modelRepository.flushDynamicBuffer(reinterpret_cast<const vk::UniqueDevice &>(m_device));
+        if (static_cast<CullingMode>(m_cullingModeI) == CullingMode::Cpu)
+        {
+            const auto start{ std::chrono::steady_clock::now() };
+            m_numVisibleInstances = m_modelRepository.cull(m_camera.getFrustumPlanes());
+            m_lastCullTimes.emplace_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+        }
     }
 
     void ModelRepositoryDemo::drawFrame()
     {
-        m_queue.waitIdle();
-
-        if (!m_firstRender)
-        {
-            auto data = new uint64_t[2];
-            reinterpret_cast<const vk::UniqueDevice &>(m_device)->getQueryPoolResults(*m_queryPool, 0, 2, sizeof(uint64_t) * 2, data, 0, vk::QueryResultFlagBits::e64);
-            auto diff = (data[1] - data[0]) * m_nanosecondsPerTimestampIncrement / 1e6f;
-            m_lastFrameTimes.emplace_back(diff);
-            delete[] data;
-        }
-        
-        timing(false, [&m_avgRenderFrameTime = m_avgRenderFrameTime, &m_lastFrameTimes = m_lastFrameTimes, &m_avgImguiRenderFrameTime = m_avgImguiRenderFrameTime, &m_lastImguiFrameTimes = m_lastImguiFrameTimes]()
+        timing(false, [&m_avgRenderFrameTime = m_avgRenderFrameTime, &m_lastFrameTimes = m_lastFrameTimes, &m_avgImguiRenderFrameTime = m_avgImguiRenderFrameTime, &m_lastImguiFrameTimes = m_lastImguiFrameTimes, &m_avgCullTime = m_avgCullTime, &m_lastCullTimes = m_lastCullTimes]()
         {
+            m_avgCullTime = std::accumulate(m_lastCullTimes.begin(), m_lastCullTimes.end(), 0.0) / static_cast<double>(std::max(m_lastCullTimes.size(), size_t{ 1 }));
+            m_lastCullTimes.clear();
+
             m_avgRenderFrameTime = std::accumulate(m_lastFrameTimes.begin(), m_lastFrameTimes.end(), 0.0) / static_cast<double>(std::max(m_lastFrameTimes.size(), size_t{ 1 }));
             m_lastFrameTimes.clear();
 
@@ -399,31 +536,39 @@ namespace bmvk
             m_lastImguiFrameTimes.clear();
         });
 
-        uint32_t imageIndex;
-        try
-        {
-            imageIndex = m_device.acquireNextImage(m_swapchain, m_imageAvailableSemaphore);
-        }
-        catch (const vk::OutOfDateKHRError &)
+        if (!m_frameScheduler.beginFrame(m_device, m_swapchain))
         {
             recreateSwapChain();
             return;
         }
 
-        m_queue.submit(m_commandBuffers[imageIndex], m_imageAvailableSemaphore, m_renderFinishedSemaphore, vk::PipelineStageFlagBits::eColorAttachmentOutput);
-        ImguiBaseDemo::drawFrame(imageIndex, m_renderFinishedSemaphore, m_renderImguiFinishedSemaphore);
+        const auto frameIndex{ m_frameScheduler.getFrameIndex() };
+        if (m_frameScheduler.hasFrameCompleted())
+        {
+            uint64_t data[2];
+            reinterpret_cast<const vk::UniqueDevice &>(m_device)->getQueryPoolResults(*m_queryPool, 2 * frameIndex, 2, sizeof(uint64_t) * 2, data, sizeof(uint64_t), vk::QueryResultFlagBits::e64);
+            auto diff = (data[1] - data[0]) * m_nanosecondsPerTimestampIncrement / 1e6f;
+            m_lastFrameTimes.emplace_back(diff);
+        }
 
-        auto waitSemaphore{ *m_renderImguiFinishedSemaphore };
-        auto swapchain{ *reinterpret_cast<const vk::UniqueSwapchainKHR &>(m_swapchain) };
-        auto success{ m_queue.present(waitSemaphore, swapchain, imageIndex) };
-        if (!success)
+        // Every frame uploads the changes its copy of the instance data has missed
+        const auto & frame{ m_frameScheduler.getFrame() };
+        if (m_modelRepository.flushDynamicBuffer(reinterpret_cast<const vk::UniqueDevice &>(m_device), frameIndex))
         {
-            recreateSwapChain();
+            // This frame got new buffers. Its previous submission has completed, so its descriptor sets and command buffers can
+            // be replaced without waiting, the other frames follow with their own flushes.
+            writeDescriptorSets(frameIndex);
+            const auto numImages{ m_swapChainFramebuffers.size() };
+            auto commandBuffers{ m_device.allocateCommandBuffers(m_commandPool, static_cast<uint32_t>(numImages)) };
+            std::move(commandBuffers.begin(), commandBuffers.end(), m_commandBuffers.begin() + frameIndex * numImages);
+            recordCommandBuffers(frameIndex);
         }
+        m_frameScheduler.submit(m_device, m_queue, m_commandBuffers[frameIndex * m_swapChainFramebuffers.size() + m_frameScheduler.getImageIndex()], frame.imageAvailableSemaphore, frame.renderFinishedSemaphore, vk::PipelineStageFlagBits::eColorAttachmentOutput);
+        ImguiBaseDemo::drawFrame();
 
-        if (m_firstRender)
+        if (!m_frameScheduler.endFrame(m_queue, m_swapchain, frame.overlayFinishedSemaphore))
         {
-            m_firstRender = !m_firstRender;
+            recreateSwapChain();
         }
     }
 }
@@ -23,15 +23,42 @@ namespace bmvk
         void run() override;
         void recreateSwapChain() override;
     private:
-        static const uint32_t k_maxObjectInstances = 1000;
+        static const uint32_t k_maxObjectInstances = 125000;
+        // The repository grows on demand, so it is only sized for the typical scene
+        static const uint32_t k_initialObjectInstances = 1000;
+        // The cubes are only translated and rotated, so position, rotation and scale hold them in half the space of a matrix
+        static constexpr vw::util::InstanceFormat k_instanceFormat = vw::util::InstanceFormat::PositionRotationScale;
+
+        enum class CullingMode
+        {
+            None,
+            Cpu,
+            Gpu
+        };
+
+        std::vector<glm::vec3> m_rotations;
+        std::vector<glm::vec3> m_rotationSpeeds;
 
-        glm::vec3 m_rotations[k_maxObjectInstances];
-        glm::vec3 m_rotationSpeeds[k_maxObjectInstances];
+        // Instance transforms as structure-of-arrays, passed to the model repository in one batch
+        struct InstanceTransforms
+        {
+            std::vector<float> translationX;
+            std::vector<float> translationY;
+            std::vector<float> translationZ;
+            std::vector<float> rotationX;
+            std::vector<float> rotationY;
+            std::vector<float> rotationZ;
+            std::vector<float> rotationW;
+        } m_instanceTransforms;
 
-        std::vector<vw::scene::ModelID> m_modelIDs;
+        std::vector<vw::scene::InstanceID> m_instanceIDs;
 
         int m_numCubesI = 2;
         uint32_t m_currentNumInstances = 8;
+        int m_cullingModeI = static_cast<int>(CullingMode::None);
+        uint32_t m_numVisibleInstances = 0;
+        std::vector<double> m_lastCullTimes;
+        double m_avgCullTime = 0.0;
 
         struct UniformBufferObject {
             glm::mat4 view;
@@ -48,21 +75,20 @@ namespace bmvk
         vk::UniqueDescriptorSetLayout m_descriptorSetLayout;
         vk::UniquePipelineLayout m_pipelineLayout;
         vk::UniquePipeline m_pipeline;
+        vk::UniqueDescriptorSetLayout m_cullDescriptorSetLayout;
+        vk::UniquePipelineLayout m_cullPipelineLayout;
+        vk::UniquePipeline m_cullPipeline;
         std::vector<vk::UniqueFramebuffer> m_swapChainFramebuffers;
 
-        vk::UniqueDeviceMemory m_depthImageMemory;
-        vk::UniqueImage m_depthImage;
-        vk::UniqueImageView m_depthImageView;
+        vw::util::TransientAttachmentAllocator::AttachmentId m_depthAttachment = 0;
 
-        vk::UniqueDeviceMemory m_uniformBufferMemory;
-        vk::UniqueBuffer m_uniformBuffer;
+        // One uniform buffer per frame in flight, so updating it does not wait for the other frames
+        std::vector<vw::util::UniqueAllocation> m_uniformBufferMemories;
+        std::vector<vk::UniqueBuffer> m_uniformBuffers;
 
         vk::UniqueDescriptorPool m_descriptorPool;
         std::vector<vk::UniqueDescriptorSet> m_descriptorSets;
         std::vector<CommandBuffer> m_commandBuffers;
-        vk::UniqueSemaphore m_imageAvailableSemaphore;
-        vk::UniqueSemaphore m_renderFinishedSemaphore;
-        vk::UniqueSemaphore m_renderImguiFinishedSemaphore;
 
         vw::scene::ModelResourceID m_cubeResourceId;
 
@@ -72,6 +98,7 @@ namespace bmvk
         void createDescriptorSetLayout();
         void createRenderPass();
         void createPipelines();
+        void createCullPipeline();
         void createDepthResources();
         void createFramebuffers();
         
@@ -79,9 +106,13 @@ namespace bmvk
         void createRotations();
         void createDescriptorPool();
         void createDescriptorSet();
+        void writeDescriptorSets(const uint32_t frame);
         void createCommandBuffers();
+        void recordCommandBuffers(const uint32_t frame);
 
         void updateNumObjects();
+        void updateInstancePositions();
+        void updateCulling();
         void updateUniformBuffer();
         void updateDynamicUniformBuffer();
 
@@ -0,0 +1,40 @@
+#include "overdrawBenchmark.hpp"
+
+#include <iostream>
+
+#include <vw/meshOptimizer.hpp>
+#include <vw/modelLoader.hpp>
+
+namespace bmvk
+{
+    namespace
+    {
+        constexpr auto k_vertexDescription{ vw::scene::VertexDescription::PositionNormalColor };
+
+        void printStatistics(const char * name, const std::vector<vw::scene::Vertex<k_vertexDescription>> & vertices, const std::vector<uint32_t> & indices, const uint32_t numViews)
+        {
+            const auto cache{ vw::scene::analyzeVertexCache(indices, vertices.size()) };
+            const auto overdraw{ vw::scene::estimateOverdraw(vertices, indices, numViews) };
+            std::cout << "  " << name << ": ACMR " << cache.acmr << ", ATVR " << cache.atvr << ", overdraw " << overdraw.overdraw << std::endl;
+        }
+    }
+
+    void runOverdrawBenchmark(const std::vector<std::string> & files, const uint32_t numViews)
+    {
+        for (const auto & file : files)
+        {
+            // Without the mesh cache, the model keeps its vectors
+            vw::scene::ModelLoader<k_vertexDescription> ml{ false };
+            auto model{ ml.loadModel(file, vw::scene::ModelLoader<k_vertexDescription>::NormalCreation::AssimpSmoothNormals) };
+            const auto & vertices{ model.getVertices() };
+            auto indices{ model.getIndices() };
+
+            std::cout << file << ": " << indices.size() / 3 << " triangles, " << numViews << " views" << std::endl;
+            printStatistics("imported", vertices, indices, numViews);
+            vw::scene::optimizeVertexCache(indices, vertices.size());
+            printStatistics("vertex cache", vertices, indices, numViews);
+            vw::scene::optimizeOverdraw(vertices, indices);
+            printStatistics("vertex cache and overdraw", vertices, indices, numViews);
+        }
+    }
+}
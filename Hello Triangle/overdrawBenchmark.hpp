@@ -0,0 +1,11 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+namespace bmvk
+{
+    // Prints the ACMR and the overdraw estimated from numViews directions of every model, as imported, optimized for the
+    // vertex cache and additionally optimized for overdraw
+    void runOverdrawBenchmark(const std::vector<std::string> & files, const uint32_t numViews);
+}
@@ -8,20 +8,33 @@ namespace bmvk
 
     PhysicalDevice::PhysicalDevice(const vk::PhysicalDevice & physicalDevice, const uint32_t queueFamilyIndex)
         : m_physicalDevice{ physicalDevice },
-          m_queueFamilyIndex{ queueFamilyIndex }
+          m_queueFamilyIndex{ queueFamilyIndex },
+          m_transferQueueFamilyIndex{ getTransferOnlyQueueFamilyIndex(physicalDevice).value_or(queueFamilyIndex) }
     {
     }
 
-    Device PhysicalDevice::createLogicalDevice(const std::vector<const char*> & layerNames) const
+    Device PhysicalDevice::createLogicalDevice(const std::vector<const char*> & layerNames, const bool enableSwapchain) const
     {
         auto queuePriority = 1.0f;
         DeviceQueueCreateInfo queueCreateInfo{ {}, getQueueFamilyIndex(), static_cast<uint32_t>(1), vk::ArrayProxy<float>(queuePriority) };
-        vk::DeviceQueueCreateInfo vk_queueCreateInfo{ queueCreateInfo };
+        std::vector<vk::DeviceQueueCreateInfo> vk_queueCreateInfos{ queueCreateInfo };
+        if (m_transferQueueFamilyIndex != m_queueFamilyIndex)
+        {
+            DeviceQueueCreateInfo transferQueueCreateInfo{ {}, m_transferQueueFamilyIndex, static_cast<uint32_t>(1), vk::ArrayProxy<float>(queuePriority) };
+            vk_queueCreateInfos.emplace_back(transferQueueCreateInfo);
+        }
         vk::PhysicalDeviceFeatures deviceFeatures;
         deviceFeatures.setSamplerAnisotropy(true);
-        std::vector<const char *> extensionNames{ k_swapchainExtensionName };
-        DeviceCreateInfo info( {}, vk_queueCreateInfo, layerNames, extensionNames, deviceFeatures );
-        return Device(std::move(m_physicalDevice.createDeviceUnique(info)), m_queueFamilyIndex);
+        const auto supportedFeatures{ m_physicalDevice.getFeatures() };
+        deviceFeatures.setDrawIndirectFirstInstance(supportedFeatures.drawIndirectFirstInstance);
+        deviceFeatures.setMultiDrawIndirect(supportedFeatures.multiDrawIndirect);
+        std::vector<const char *> extensionNames{};
+        if (enableSwapchain)
+        {
+            extensionNames.emplace_back(k_swapchainExtensionName);
+        }
+        DeviceCreateInfo info( {}, vk_queueCreateInfos, layerNames, extensionNames, deviceFeatures );
+        return Device(std::move(m_physicalDevice.createDeviceUnique(info)), m_queueFamilyIndex, m_transferQueueFamilyIndex);
     }
 
     uint32_t PhysicalDevice::findMemoryType(uint32_t typeFilter, vk::MemoryPropertyFlags properties) const
@@ -65,13 +78,12 @@ namespace bmvk
     std::optional<int> PhysicalDevice::getSuitableQueueFamilyIndex(const vk::PhysicalDevice & device, const vk::UniqueSurfaceKHR & surface)
     {
         const auto features = device.getFeatures();
-        const auto properties = device.getProperties();
         const auto queueFamilyProperties = device.getQueueFamilyProperties();
 
         auto index = 0;
         auto foundQueue = false;
         for (const auto& queueFamilyProperty : queueFamilyProperties) {
-            if (queueFamilyProperty.queueCount > 0 && queueFamilyProperty.queueFlags & vk::QueueFlagBits::eGraphics)
+            if (queueFamilyProperty.queueCount > 0 && queueFamilyProperty.queueFlags & vk::QueueFlagBits::eGraphics && queueFamilyProperty.queueFlags & vk::QueueFlagBits::eCompute)
             {
                 foundQueue = true;
                 break;
@@ -80,14 +92,35 @@ namespace bmvk
             ++index;
         }
 
+        if (!surface)
+        {
+            return foundQueue ? index : std::optional<int>{};
+        }
+
         const auto hasPresentationSupport{ device.getSurfaceSupportKHR(index, *surface) };
         const auto hasRequiredExtensions{ checkDeviceExtensionSupport(device) };
         const auto hasSwapChainSupport{ checkSwapChainSupport(device, surface) };
         const auto hasAnisotropySupport{ features.samplerAnisotropy };
-        const auto isSuitable{ properties.deviceType == vk::PhysicalDeviceType::eDiscreteGpu && foundQueue && hasPresentationSupport && hasRequiredExtensions && hasSwapChainSupport && hasAnisotropySupport };
+        const auto isSuitable{ foundQueue && hasPresentationSupport && hasRequiredExtensions && hasSwapChainSupport && hasAnisotropySupport };
         return isSuitable ? index : std::optional<int>{};
     }
 
+    std::optional<uint32_t> PhysicalDevice::getTransferOnlyQueueFamilyIndex(const vk::PhysicalDevice & device)
+    {
+        // Transfer-only families usually map to the DMA engines, which copy alongside the graphics work
+        const auto queueFamilyProperties = device.getQueueFamilyProperties();
+        for (uint32_t index = 0; index < queueFamilyProperties.size(); ++index)
+        {
+            const auto & queueFamilyProperty = queueFamilyProperties[index];
+            if (queueFamilyProperty.queueCount > 0 && queueFamilyProperty.queueFlags & vk::QueueFlagBits::eTransfer && !(queueFamilyProperty.queueFlags & (vk::QueueFlagBits::eGraphics | vk::QueueFlagBits::eCompute)))
+            {
+                return index;
+            }
+        }
+
+        return {};
+    }
+
     bool PhysicalDevice::checkDeviceExtensionSupport(const vk::PhysicalDevice & device)
     {
         const auto availableExtensions = device.enumerateDeviceExtensionProperties();
@@ -19,18 +19,22 @@ namespace bmvk
         explicit operator const vk::PhysicalDevice &() const noexcept { return m_physicalDevice; }
 
         auto getQueueFamilyIndex() const { return m_queueFamilyIndex; }
+        // Equals the graphics queue family index if the device has no transfer-only family
+        auto getTransferQueueFamilyIndex() const { return m_transferQueueFamilyIndex; }
 
         vk::SurfaceCapabilitiesKHR getSurfaceCapabilities(const vk::UniqueSurfaceKHR & surface) const { return m_physicalDevice.getSurfaceCapabilitiesKHR(*surface); }
         std::vector<vk::SurfaceFormatKHR> getSurfaceFormats(const vk::UniqueSurfaceKHR & surface) const { return m_physicalDevice.getSurfaceFormatsKHR(*surface); }
         std::vector<vk::PresentModeKHR> getPresentModes(const vk::UniqueSurfaceKHR & surface) const { return m_physicalDevice.getSurfacePresentModesKHR(*surface); }
         vk::PhysicalDeviceProperties getProperties() const { return m_physicalDevice.getProperties(); }
 
-        Device createLogicalDevice(const std::vector<const char*> & layerNames) const;
+        Device createLogicalDevice(const std::vector<const char*> & layerNames, const bool enableSwapchain = true) const;
         uint32_t findMemoryType(uint32_t typeFilter, vk::MemoryPropertyFlags properties) const;
         vk::Format findSupportedFormat(const std::vector<vk::Format> & candidates, vk::ImageTiling tiling, vk::FormatFeatureFlags features) const;
         vk::Format findDepthFormat() const;
 
+        // Without a surface only a graphics and compute queue family is required
         static std::optional<int> getSuitableQueueFamilyIndex(const vk::PhysicalDevice & device, const vk::UniqueSurfaceKHR & surface);
+        static std::optional<uint32_t> getTransferOnlyQueueFamilyIndex(const vk::PhysicalDevice & device);
 
         static vk::SurfaceFormatKHR chooseSwapSurfaceFormat(const std::vector<vk::SurfaceFormatKHR> & availableFormats);
         static vk::PresentModeKHR chooseSwapPresentMode(const std::vector<vk::PresentModeKHR> & availablePresentModes);
@@ -39,6 +43,7 @@ namespace bmvk
     private:
         vk::PhysicalDevice m_physicalDevice;
         uint32_t m_queueFamilyIndex;
+        uint32_t m_transferQueueFamilyIndex;
 
         friend class Instance;
         PhysicalDevice() {}
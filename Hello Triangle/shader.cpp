@@ -12,9 +12,9 @@ namespace bmvk
     {
     }
 
-    vk::PipelineShaderStageCreateInfo Shader::createPipelineShaderStageCreateInfo(vk::ShaderStageFlagBits flagBits) const
+    vk::PipelineShaderStageCreateInfo Shader::createPipelineShaderStageCreateInfo(vk::ShaderStageFlagBits flagBits, const vk::SpecializationInfo * specializationInfo) const
     {
-        return { {}, flagBits, *m_module, "main" };
+        return { {}, flagBits, *m_module, "main", specializationInfo };
     }
 
     std::vector<char> Shader::readFile(const std::experimental::filesystem::path & path)
@@ -21,7 +21,8 @@ namespace bmvk
 
         explicit operator const vk::UniqueShaderModule &() const noexcept { return m_module; }
 
-        vk::PipelineShaderStageCreateInfo createPipelineShaderStageCreateInfo(vk::ShaderStageFlagBits flagBits) const;
+        // The specialization info has to outlive the pipeline creation
+        vk::PipelineShaderStageCreateInfo createPipelineShaderStageCreateInfo(vk::ShaderStageFlagBits flagBits, const vk::SpecializationInfo * specializationInfo = nullptr) const;
     private:
         std::vector<char> m_code;
         vk::UniqueShaderModule m_module;
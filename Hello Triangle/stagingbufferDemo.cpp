@@ -8,9 +8,7 @@ namespace bmvk
     template <vw::scene::VertexDescription VD>
     StagingbufferDemo<VD>::StagingbufferDemo(const bool enableValidationLayers, const uint32_t width, const uint32_t height)
       : Demo{ enableValidationLayers, width, height, "Stagingbuffer Demo", DebugReport::ReportLevel::WarningsAndAbove },
-        m_swapchain{ m_instance.getPhysicalDevice(), m_instance.getSurface(), m_window.getSize(), m_device },
-        m_imageAvailableSemaphore{ m_device.createSemaphore() },
-        m_renderFinishedSemaphore{ m_device.createSemaphore() }
+        m_swapchain{ m_instance.getPhysicalDevice(), m_instance.getSurface(), m_window.getSize(), m_device }
     {
         m_window.addWindowSizeFunc([this](int width, int height)
         {
@@ -46,6 +44,7 @@ namespace bmvk
         }
 
         m_device.waitIdle();
+        m_frameScheduler.resetImages();
 
         for (auto & fb : m_swapChainFramebuffers)
         {
@@ -125,12 +124,10 @@ namespace bmvk
         const auto stagingBufferUsageFlags{ vk::BufferUsageFlagBits::eTransferSrc };
         const auto stagingBufferMemoryPropertyFlags{ vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent };
         vk::UniqueBuffer stagingBuffer;
-        vk::UniqueDeviceMemory stagingBufferMemory;
+        vw::util::UniqueAllocation stagingBufferMemory;
         createBuffer(bufferSize, stagingBufferUsageFlags, stagingBufferMemoryPropertyFlags, stagingBuffer, stagingBufferMemory);
 
-        auto data{ reinterpret_cast<const vk::UniqueDevice &>(m_device)->mapMemory(*stagingBufferMemory, 0, bufferSize) };
-        memcpy(data, vertices.data(), static_cast<size_t>(bufferSize));
-        reinterpret_cast<const vk::UniqueDevice &>(m_device)->unmapMemory(*stagingBufferMemory);
+        memcpy(stagingBufferMemory->mapped, vertices.data(), static_cast<size_t>(bufferSize));
         
         const auto vertexBufferUsageFlags{ vk::BufferUsageFlagBits::eTransferDst | vk::BufferUsageFlagBits::eVertexBuffer };
         const auto vertexBufferMemoryPropertyFlags{ vk::MemoryPropertyFlagBits::eDeviceLocal };
@@ -163,41 +160,23 @@ namespace bmvk
     template <vw::scene::VertexDescription VD>
     void StagingbufferDemo<VD>::drawFrame()
     {
-        m_queue.waitIdle();
         timing();
 
-        uint32_t imageIndex;
-        try
-        {
-            imageIndex = m_device.acquireNextImage(m_swapchain, m_imageAvailableSemaphore);
-        }
-        catch (const vk::OutOfDateKHRError &)
+        if (!m_frameScheduler.beginFrame(m_device, m_swapchain))
         {
             recreateSwapChain();
             return;
         }
 
-        vk::Semaphore waitSemaphores[]{ *m_imageAvailableSemaphore };
+        const auto & frame{ m_frameScheduler.getFrame() };
+        vk::Semaphore waitSemaphores[]{ *frame.imageAvailableSemaphore };
         vk::PipelineStageFlags waitStages[]{ vk::PipelineStageFlagBits::eColorAttachmentOutput };
-        auto usedCommandBuffer = *m_commandBuffers[imageIndex];
-        vk::Semaphore signalSemaphores[]{ *m_renderFinishedSemaphore };
+        auto usedCommandBuffer = *m_commandBuffers[m_frameScheduler.getImageIndex()];
+        vk::Semaphore signalSemaphores[]{ *frame.renderFinishedSemaphore };
         vk::SubmitInfo submitInfo{ 1, waitSemaphores, waitStages, 1, &usedCommandBuffer, 1, signalSemaphores };
-        static_cast<vk::Queue>(m_queue).submit(submitInfo, nullptr);
-        vk::SwapchainKHR swapchains[]{ *reinterpret_cast<const vk::UniqueSwapchainKHR &>(m_swapchain) };
-        vk::PresentInfoKHR presentInfo{ 1, signalSemaphores, 1, swapchains, &imageIndex };
-        vk::Result result;
-        auto notOutOfDate{ false };
-        try
-        {
-            result = static_cast<vk::Queue>(m_queue).presentKHR(presentInfo);
-            notOutOfDate = true;
-        }
-        catch (const vk::OutOfDateKHRError &)
-        {
-            recreateSwapChain();
-        }
+        static_cast<vk::Queue>(m_queue).submit(submitInfo, m_frameScheduler.getFence());
 
-        if (notOutOfDate && result == vk::Result::eSuboptimalKHR)
+        if (!m_frameScheduler.endFrame(m_queue, m_swapchain, frame.renderFinishedSemaphore))
         {
             recreateSwapChain();
         }
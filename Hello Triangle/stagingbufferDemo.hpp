@@ -53,10 +53,8 @@ namespace bmvk
         vk::UniquePipeline m_graphicsPipeline;
         std::vector<vk::UniqueFramebuffer> m_swapChainFramebuffers;
         vk::UniqueBuffer m_vertexBuffer;
-        vk::UniqueDeviceMemory m_vertexBufferMemory;
+        vw::util::UniqueAllocation m_vertexBufferMemory;
         std::vector<vk::UniqueCommandBuffer> m_commandBuffers;
-        vk::UniqueSemaphore m_imageAvailableSemaphore;
-        vk::UniqueSemaphore m_renderFinishedSemaphore;
 
         void createRenderPass();
         void createGraphicsPipeline();
@@ -65,21 +65,18 @@ namespace bmvk
         vk::UniquePipeline m_graphicsPipeline;
         std::vector<vk::UniqueFramebuffer> m_swapChainFramebuffers;
         vk::UniqueImage m_textureImage;
-        vk::UniqueDeviceMemory m_textureImageMemory;
+        vw::util::UniqueAllocation m_textureImageMemory;
         vk::UniqueImageView m_textureImageView;
         Sampler m_textureSampler;
         vk::UniqueBuffer m_vertexBuffer;
-        vk::UniqueDeviceMemory m_vertexBufferMemory;
+        vw::util::UniqueAllocation m_vertexBufferMemory;
         vk::UniqueBuffer m_indexBuffer;
-        vk::UniqueDeviceMemory m_indexBufferMemory;
+        vw::util::UniqueAllocation m_indexBufferMemory;
         vk::UniqueBuffer m_uniformBuffer;
-        vk::UniqueDeviceMemory m_uniformBufferMemory;
+        vw::util::UniqueAllocation m_uniformBufferMemory;
         vk::UniqueDescriptorPool m_descriptorPool;
         std::vector<vk::UniqueDescriptorSet> m_descriptorSets;
         std::vector<CommandBuffer> m_commandBuffers;
-        vk::UniqueSemaphore m_imageAvailableSemaphore;
-        vk::UniqueSemaphore m_renderFinishedSemaphore;
-        vk::UniqueSemaphore m_renderImguiFinishedSemaphore;
 
         void createDescriptorSetLayout();
         void createRenderPass();
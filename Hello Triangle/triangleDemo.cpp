@@ -8,9 +8,7 @@ namespace bmvk
     template <vw::scene::VertexDescription VD>
     TriangleDemo<VD>::TriangleDemo(const bool enableValidationLayers, const uint32_t width, const uint32_t height)
         : Demo<VD>{ enableValidationLayers, width, height, "Triangle Demo", DebugReport::ReportLevel::WarningsAndAbove },
-        m_swapchain{ m_instance.getPhysicalDevice(), m_instance.getSurface(), m_window.getSize(), m_device },
-        m_imageAvailableSemaphore{ m_device.createSemaphore() },
-        m_renderFinishedSemaphore{ m_device.createSemaphore() }
+        m_swapchain{ m_instance.getPhysicalDevice(), m_instance.getSurface(), m_window.getSize(), m_device }
     {
         m_window.addWindowSizeFunc([this](int width, int height)
         {
@@ -45,6 +43,7 @@ namespace bmvk
         }
 
         m_device.waitIdle();
+        m_frameScheduler.resetImages();
 
         for (auto & fb : m_swapChainFramebuffers)
         {
@@ -137,41 +136,23 @@ namespace bmvk
     template <vw::scene::VertexDescription VD>
     void TriangleDemo<VD>::drawFrame()
     {
-        m_queue.waitIdle();
         timing();
 
-        uint32_t imageIndex;
-        try
-        {
-            imageIndex = m_device.acquireNextImage(m_swapchain, m_imageAvailableSemaphore);
-        }
-        catch (const vk::OutOfDateKHRError &)
+        if (!m_frameScheduler.beginFrame(m_device, m_swapchain))
         {
             recreateSwapChain();
             return;
         }
 
-        vk::Semaphore waitSemaphores[]{ *m_imageAvailableSemaphore };
+        const auto & frame{ m_frameScheduler.getFrame() };
+        vk::Semaphore waitSemaphores[]{ *frame.imageAvailableSemaphore };
         vk::PipelineStageFlags waitStages[]{ vk::PipelineStageFlagBits::eColorAttachmentOutput };
-        auto usedCommandBuffer = *m_commandBuffers[imageIndex];
-        vk::Semaphore signalSemaphores[]{ *m_renderFinishedSemaphore };
+        auto usedCommandBuffer = *m_commandBuffers[m_frameScheduler.getImageIndex()];
+        vk::Semaphore signalSemaphores[]{ *frame.renderFinishedSemaphore };
         vk::SubmitInfo submitInfo{ 1, waitSemaphores, waitStages, 1, &usedCommandBuffer, 1, signalSemaphores };
-        static_cast<vk::Queue>(m_queue).submit(submitInfo, nullptr);
-        vk::SwapchainKHR swapchains[]{ *reinterpret_cast<const vk::UniqueSwapchainKHR &>(m_swapchain) };
-        vk::PresentInfoKHR presentInfo{ 1, signalSemaphores, 1, swapchains, &imageIndex };
-        vk::Result result;
-        auto notOutOfDate{ false };
-        try
-        {
-            result = static_cast<vk::Queue>(m_queue).presentKHR(presentInfo);
-            notOutOfDate = true;
-        }
-        catch (const vk::OutOfDateKHRError &)
-        {
-            recreateSwapChain();
-        }
+        static_cast<vk::Queue>(m_queue).submit(submitInfo, m_frameScheduler.getFence());
 
-        if (notOutOfDate && result == vk::Result::eSuboptimalKHR)
+        if (!m_frameScheduler.endFrame(m_queue, m_swapchain, frame.renderFinishedSemaphore))
         {
             recreateSwapChain();
         }
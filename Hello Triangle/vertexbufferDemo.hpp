@@ -55,8 +55,6 @@ namespace bmvk
         vk::UniqueBuffer m_vertexBuffer;
         vk::UniqueDeviceMemory m_vertexBufferMemory;
         std::vector<vk::UniqueCommandBuffer> m_commandBuffers;
-        vk::UniqueSemaphore m_imageAvailableSemaphore;
-        vk::UniqueSemaphore m_renderFinishedSemaphore;
 
         void createRenderPass();
         void createGraphicsPipeline();
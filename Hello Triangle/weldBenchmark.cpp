@@ -0,0 +1,104 @@
+#include "weldBenchmark.hpp"
+
+#include <assimp/Importer.hpp>
+#include <assimp/postprocess.h>
+#include <assimp/scene.h>
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <stdexcept>
+#include <unordered_map>
+
+#include <vw/vertexWelder.hpp>
+
+namespace bmvk
+{
+    namespace
+    {
+        using BenchmarkVertex = vw::scene::Vertex<vw::scene::VertexDescription::PositionNormalColorTexture>;
+
+        std::vector<BenchmarkVertex> loadCorners(const std::string & file)
+        {
+            Assimp::Importer importer;
+            const auto * scene = importer.ReadFile(file, aiProcess_Triangulate | aiProcess_GenSmoothNormals);
+            if (!scene)
+            {
+                throw std::runtime_error(importer.GetErrorString());
+            }
+
+            std::vector<BenchmarkVertex> corners;
+            for (uint32_t i = 0; i < scene->mNumMeshes; ++i)
+            {
+                const auto mesh = scene->mMeshes[i];
+                for (uint32_t j = 0; j < mesh->mNumFaces; ++j)
+                {
+                    const auto & face = mesh->mFaces[j];
+                    for (uint32_t k = 0; k < face.mNumIndices; ++k)
+                    {
+                        const auto v = mesh->mVertices[face.mIndices[k]];
+                        const auto n = mesh->mNormals[face.mIndices[k]];
+                        corners.push_back({ { v.x, v.y, v.z }, { n.x, n.y, n.z }, { 1.f, 0.f, 0.f }, { 0.f, 1.f } });
+                    }
+                }
+            }
+
+            return corners;
+        }
+
+        template<typename F>
+        double measureBest(const uint32_t runs, std::vector<uint32_t> & indices, size_t & numVertices, const F & weld)
+        {
+            auto best{ std::chrono::steady_clock::duration::max() };
+            for (uint32_t i = 0; i < runs; ++i)
+            {
+                indices.clear();
+                const auto start{ std::chrono::steady_clock::now() };
+                numVertices = weld(indices);
+                best = std::min(best, std::chrono::steady_clock::now() - start);
+            }
+
+            return std::chrono::duration<double, std::milli>(best).count();
+        }
+    }
+
+    void runWeldBenchmark(const std::vector<std::string> & files, const uint32_t runs)
+    {
+        for (const auto & file : files)
+        {
+            const auto corners{ loadCorners(file) };
+
+            std::vector<uint32_t> mapIndices;
+            size_t mapVertices;
+            const auto mapTime{ measureBest(runs, mapIndices, mapVertices, [&corners](std::vector<uint32_t> & indices)
+            {
+                std::unordered_map<BenchmarkVertex, uint32_t> uniqueVertices = {};
+                for (const auto & corner : corners)
+                {
+                    indices.push_back(uniqueVertices.try_emplace(corner, static_cast<uint32_t>(uniqueVertices.size())).first->second);
+                }
+                return uniqueVertices.size();
+            }) };
+
+            std::vector<uint32_t> welderIndices;
+            size_t welderVertices;
+            const auto welderTime{ measureBest(runs, welderIndices, welderVertices, [&corners](std::vector<uint32_t> & indices)
+            {
+                vw::scene::VertexWelder<vw::scene::VertexDescription::PositionNormalColorTexture> welder;
+                for (const auto & corner : corners)
+                {
+                    indices.push_back(welder.weld(corner));
+                }
+                return welder.size();
+            }) };
+
+            if (mapVertices != welderVertices || mapIndices != welderIndices)
+            {
+                throw std::runtime_error("welding results differ for " + file);
+            }
+
+            std::cout << file << ": " << corners.size() << " corners, " << welderVertices << " vertices" << std::endl;
+            std::cout << "  std::unordered_map " << mapTime << " ms, VertexWelder " << welderTime << " ms, " << mapTime / welderTime << "x" << std::endl;
+        }
+    }
+}
@@ -0,0 +1,11 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+namespace bmvk
+{
+    // Deduplicates the face corners of every model with std::unordered_map and with vw::scene::VertexWelder, like
+    // vw::scene::ModelLoader does, and prints the best time of each out of the given number of runs
+    void runWeldBenchmark(const std::vector<std::string> & files, const uint32_t runs);
+}
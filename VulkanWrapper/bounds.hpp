@@ -0,0 +1,44 @@
+#pragma once
+
+#include "vertex.hpp"
+
+#include <algorithm>
+#include <vector>
+
+namespace vw::scene
+{
+    // Bounding sphere around the vertex positions, center in xyz and radius in w
+    template<VertexDescription VD>
+    glm::vec4 computeBoundingSphere(const std::vector<Vertex<VD>> & vertices)
+    {
+        if constexpr (VD == VertexDescription::NotUsed)
+        {
+            return glm::vec4{ 0.f };
+        }
+        else
+        {
+            if (vertices.empty())
+            {
+                return glm::vec4{ 0.f };
+            }
+
+            // Center of the bounding box, radius to the farthest vertex
+            auto min{ vertices[0].pos };
+            auto max{ vertices[0].pos };
+            for (const auto & vertex : vertices)
+            {
+                min = glm::min(min, vertex.pos);
+                max = glm::max(max, vertex.pos);
+            }
+
+            const auto center{ (min + max) * 0.5f };
+            auto radius{ 0.f };
+            for (const auto & vertex : vertices)
+            {
+                radius = std::max(radius, glm::distance(center, vertex.pos));
+            }
+
+            return glm::vec4{ center, radius };
+        }
+    }
+}
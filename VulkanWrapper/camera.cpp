@@ -17,7 +17,8 @@ namespace vw::util
         m_far{ std::numeric_limits<float>::infinity() },
         m_projMat{ glm::infinitePerspective(m_fov, m_ratio, m_near) },
         m_modified{ true },
-        m_modifiedProj{ false }
+        m_modifiedProj{ false },
+        m_modifiedFrustum{ true }
     {
     }
 
@@ -31,7 +32,8 @@ namespace vw::util
         m_near{ near },
         m_far{ far },
         m_modified{ true },
-        m_modifiedProj{ false }
+        m_modifiedProj{ false },
+        m_modifiedFrustum{ true }
     {
         if (std::abs(dir.length()) <= 0.f)
         {
@@ -80,6 +82,7 @@ namespace vw::util
             m_viewMat[3] = (m[0] * v[0]) + (m[1] * v[1]) + (m[2] * v[2]) + m[3];
 
             m_modified = false;
+            m_modifiedFrustum = true;
         }
 
         return m_viewMat;
@@ -99,11 +102,40 @@ namespace vw::util
             }
 
             m_modifiedProj = false;
+            m_modifiedFrustum = true;
         }
 
         return m_projMat;
     }
 
+    const std::array<glm::vec4, 6> & Camera::getFrustumPlanes() const
+    {
+        // Updating the matrices flags the planes as modified
+        const auto & proj{ getProjMatrix() };
+        const auto & view{ getViewMatrix() };
+        if (m_modifiedFrustum)
+        {
+            // Gribb/Hartmann extraction from the rows of proj * view
+            const auto m{ glm::transpose(proj * view) };
+
+            // The near plane is taken at z = -w, which is conservative for a [0, 1] depth range as well
+            m_frustumPlanes = { m[3] + m[0], m[3] - m[0], m[3] + m[1], m[3] - m[1], m[3] + m[2], m[3] - m[2] };
+            for (auto & plane : m_frustumPlanes)
+            {
+                // An infinite far plane degenerates to a zero normal with a positive distance, which never culls
+                const auto length{ glm::length(glm::vec3(plane)) };
+                if (length > 0.f)
+                {
+                    plane /= length;
+                }
+            }
+
+            m_modifiedFrustum = false;
+        }
+
+        return m_frustumPlanes;
+    }
+
     void Camera::setFov(const float val) noexcept
     {
         m_fov = val;
@@ -2,6 +2,7 @@
 
 #include <glm/gtc/quaternion.hpp>
 
+#include <array>
 #include <limits>
 #include <type_traits>
 
@@ -20,6 +21,8 @@ namespace vw::util
 
         const glm::mat4 & getViewMatrix() const;
         const glm::mat4 & getProjMatrix() const;
+        // Left, right, bottom, top, near, far as (normal, distance) with the normal pointing inwards
+        const std::array<glm::vec4, 6> & getFrustumPlanes() const;
 
         void setFov(float val) noexcept;
         void setRatio(float val) noexcept;
@@ -45,9 +48,11 @@ namespace vw::util
 
         mutable glm::mat4 m_viewMat;
         mutable glm::mat4 m_projMat;
+        mutable std::array<glm::vec4, 6> m_frustumPlanes;
 
         mutable bool m_modified;
         mutable bool m_modifiedProj;
+        mutable bool m_modifiedFrustum;
     };
 
     static_assert(std::is_nothrow_move_constructible_v<Camera>);
@@ -0,0 +1,66 @@
+#include "culling.hpp"
+
+#include <immintrin.h>
+
+namespace vw::util
+{
+    size_t cullSpheres(const std::array<glm::vec4, 6> & planes, const float * x, const float * y, const float * z, const float * radius, const size_t count, uint8_t * visible)
+    {
+        size_t numVisible = 0;
+
+        // A sphere is outside if its center lies further than its radius behind any plane; NaN and unused entries compare as outside
+#if defined(__AVX__)
+        const auto signMask{ _mm256_set1_ps(-0.f) };
+        for (size_t i = 0; i < count; i += k_cullBatchSize)
+        {
+            const auto cx{ _mm256_load_ps(x + i) };
+            const auto cy{ _mm256_load_ps(y + i) };
+            const auto cz{ _mm256_load_ps(z + i) };
+            const auto negRadius{ _mm256_xor_ps(_mm256_load_ps(radius + i), signMask) };
+
+            auto inside{ _mm256_castsi256_ps(_mm256_set1_epi32(-1)) };
+            for (const auto & plane : planes)
+            {
+                auto distance{ _mm256_add_ps(_mm256_mul_ps(cx, _mm256_set1_ps(plane.x)), _mm256_set1_ps(plane.w)) };
+                distance = _mm256_add_ps(distance, _mm256_mul_ps(cy, _mm256_set1_ps(plane.y)));
+                distance = _mm256_add_ps(distance, _mm256_mul_ps(cz, _mm256_set1_ps(plane.z)));
+                inside = _mm256_and_ps(inside, _mm256_cmp_ps(distance, negRadius, _CMP_GE_OQ));
+            }
+
+            const auto mask{ _mm256_movemask_ps(inside) };
+            for (size_t j = 0; j < k_cullBatchSize; ++j)
+            {
+                visible[i + j] = static_cast<uint8_t>((mask >> j) & 1);
+                numVisible += visible[i + j];
+            }
+        }
+#else
+        const auto signMask{ _mm_set1_ps(-0.f) };
+        for (size_t i = 0; i < count; i += k_cullBatchSize)
+        {
+            const auto cx{ _mm_load_ps(x + i) };
+            const auto cy{ _mm_load_ps(y + i) };
+            const auto cz{ _mm_load_ps(z + i) };
+            const auto negRadius{ _mm_xor_ps(_mm_load_ps(radius + i), signMask) };
+
+            auto inside{ _mm_castsi128_ps(_mm_set1_epi32(-1)) };
+            for (const auto & plane : planes)
+            {
+                auto distance{ _mm_add_ps(_mm_mul_ps(cx, _mm_set1_ps(plane.x)), _mm_set1_ps(plane.w)) };
+                distance = _mm_add_ps(distance, _mm_mul_ps(cy, _mm_set1_ps(plane.y)));
+                distance = _mm_add_ps(distance, _mm_mul_ps(cz, _mm_set1_ps(plane.z)));
+                inside = _mm_and_ps(inside, _mm_cmpge_ps(distance, negRadius));
+            }
+
+            const auto mask{ _mm_movemask_ps(inside) };
+            for (size_t j = 0; j < k_cullBatchSize; ++j)
+            {
+                visible[i + j] = static_cast<uint8_t>((mask >> j) & 1);
+                numVisible += visible[i + j];
+            }
+        }
+#endif
+
+        return numVisible;
+    }
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <limits>
+
+namespace vw::scene
+{
+    // Generational handle into a slot map, packed into 32 bits: the low 24 bits select the slot, the high 8 bits hold the
+    // generation, which tells a live handle from a stale one whose slot has been reused since. Generations wrap around, so a
+    // handle is only told apart from the next 255 reuses of its slot.
+    template<class Tag>
+    class Handle
+    {
+    public:
+        static constexpr uint32_t k_indexBits = 24;
+        // The largest index is left to default constructed handles, so no slot map may hold more slots than this
+        static constexpr uint32_t k_maxIndices = (1u << k_indexBits) - 1;
+        static constexpr uint32_t k_generationMask = (1u << (32 - k_indexBits)) - 1;
+
+        Handle() = default;
+        Handle(const uint32_t index, const uint32_t generation) : m_value{ (generation & k_generationMask) << k_indexBits | index } {}
+
+        auto getIndex() const noexcept { return m_value & k_maxIndices; }
+        auto getGeneration() const noexcept { return m_value >> k_indexBits; }
+
+        bool operator==(const Handle & rhs) const { return m_value == rhs.m_value; }
+        bool operator!=(const Handle & rhs) const { return !(*this == rhs); }
+
+        struct KeyHash
+        {
+            std::size_t operator()(const Handle & k) const
+            {
+                return std::hash<uint32_t>()(k.m_value);
+            }
+        };
+    private:
+        uint32_t m_value = std::numeric_limits<uint32_t>::max();
+    };
+
+    static_assert(sizeof(Handle<struct HandleTag>) == sizeof(uint32_t));
+}
@@ -0,0 +1,50 @@
+#include "instanceFormat.hpp"
+
+#include <glm/gtc/quaternion.hpp>
+
+#include <algorithm>
+
+namespace vw::util
+{
+    void packInstance(const InstanceFormat format, const glm::mat4 & matrix, void * dst)
+    {
+        auto * out{ static_cast<glm::vec4 *>(dst) };
+        switch (format)
+        {
+        case InstanceFormat::Matrix:
+            *static_cast<glm::mat4 *>(dst) = matrix;
+            break;
+        case InstanceFormat::Affine:
+            // The last row of an affine transform is always (0, 0, 0, 1)
+            out[0] = glm::vec4(matrix[0][0], matrix[1][0], matrix[2][0], matrix[3][0]);
+            out[1] = glm::vec4(matrix[0][1], matrix[1][1], matrix[2][1], matrix[3][1]);
+            out[2] = glm::vec4(matrix[0][2], matrix[1][2], matrix[2][2], matrix[3][2]);
+            break;
+        case InstanceFormat::PositionRotationScale:
+        {
+            const glm::vec3 scales{ glm::length(glm::vec3(matrix[0])), glm::length(glm::vec3(matrix[1])), glm::length(glm::vec3(matrix[2])) };
+            const auto scale{ std::max(scales.x, std::max(scales.y, scales.z)) };
+
+            // A degenerate axis has no direction, so the rotation falls back to identity
+            glm::quat rotation;
+            if (scales.x > 0.f && scales.y > 0.f && scales.z > 0.f)
+            {
+                rotation = glm::normalize(glm::quat_cast(glm::mat3(glm::vec3(matrix[0]) / scales.x, glm::vec3(matrix[1]) / scales.y, glm::vec3(matrix[2]) / scales.z)));
+            }
+
+            out[0] = glm::vec4(glm::vec3(matrix[3]), scale);
+            out[1] = glm::vec4(rotation.x, rotation.y, rotation.z, rotation.w);
+            break;
+        }
+        }
+    }
+
+    void packInstances(const InstanceFormat format, const glm::mat4 * matrices, const std::vector<uint32_t> & indices, void * dst)
+    {
+        const auto stride{ getInstanceStride(format) };
+        for (const auto index : indices)
+        {
+            packInstance(format, matrices[index], static_cast<uint8_t *>(dst) + index * stride);
+        }
+    }
+}
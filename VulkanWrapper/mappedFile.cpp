@@ -0,0 +1,95 @@
+#include "mappedFile.hpp"
+
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+
+#include <stdexcept>
+
+namespace vw::util
+{
+    MappedFile::MappedFile(const std::experimental::filesystem::path & path)
+    {
+        m_file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (m_file == INVALID_HANDLE_VALUE)
+        {
+            m_file = nullptr;
+            throw std::runtime_error("failed to open file for mapping");
+        }
+
+        LARGE_INTEGER size;
+        if (!GetFileSizeEx(m_file, &size) || size.QuadPart == 0)
+        {
+            reset();
+            throw std::runtime_error("failed to map empty file");
+        }
+
+        m_mapping = CreateFileMappingW(m_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (m_mapping == nullptr)
+        {
+            reset();
+            throw std::runtime_error("failed to create file mapping");
+        }
+
+        m_data = static_cast<const uint8_t *>(MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0));
+        if (m_data == nullptr)
+        {
+            reset();
+            throw std::runtime_error("failed to map view of file");
+        }
+        m_size = static_cast<size_t>(size.QuadPart);
+    }
+
+    MappedFile::MappedFile(MappedFile && other) noexcept
+        : m_file{ other.m_file },
+          m_mapping{ other.m_mapping },
+          m_data{ other.m_data },
+          m_size{ other.m_size }
+    {
+        other.m_file = nullptr;
+        other.m_mapping = nullptr;
+        other.m_data = nullptr;
+        other.m_size = 0;
+    }
+
+    MappedFile & MappedFile::operator=(MappedFile && other) noexcept
+    {
+        if (this != &other)
+        {
+            reset();
+            m_file = other.m_file;
+            m_mapping = other.m_mapping;
+            m_data = other.m_data;
+            m_size = other.m_size;
+            other.m_file = nullptr;
+            other.m_mapping = nullptr;
+            other.m_data = nullptr;
+            other.m_size = 0;
+        }
+
+        return *this;
+    }
+
+    void MappedFile::reset()
+    {
+        if (m_data != nullptr)
+        {
+            UnmapViewOfFile(m_data);
+            m_data = nullptr;
+        }
+
+        if (m_mapping != nullptr)
+        {
+            CloseHandle(m_mapping);
+            m_mapping = nullptr;
+        }
+
+        if (m_file != nullptr)
+        {
+            CloseHandle(m_file);
+            m_file = nullptr;
+        }
+
+        m_size = 0;
+    }
+}
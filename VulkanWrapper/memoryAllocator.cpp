@@ -0,0 +1,449 @@
+#include "memoryAllocator.hpp"
+
+#include <intrin.h>
+
+#include <algorithm>
+
+namespace vw::util
+{
+    namespace
+    {
+        uint32_t mostSignificantBit(const uint64_t value)
+        {
+            unsigned long index;
+            _BitScanReverse64(&index, value);
+            return static_cast<uint32_t>(index);
+        }
+
+        uint32_t leastSignificantBit(const uint64_t value)
+        {
+            unsigned long index;
+            _BitScanForward64(&index, value);
+            return static_cast<uint32_t>(index);
+        }
+
+        vk::DeviceSize alignUp(const vk::DeviceSize value, const vk::DeviceSize alignment)
+        {
+            return (value + alignment - 1) / alignment * alignment;
+        }
+    }
+
+    UniqueAllocation::UniqueAllocation(UniqueAllocation && other) noexcept
+        : m_allocator{ other.m_allocator },
+          m_allocation{ other.m_allocation }
+    {
+        other.m_allocator = nullptr;
+    }
+
+    UniqueAllocation & UniqueAllocation::operator=(UniqueAllocation && other) noexcept
+    {
+        if (this != &other)
+        {
+            reset();
+            m_allocator = other.m_allocator;
+            m_allocation = other.m_allocation;
+            other.m_allocator = nullptr;
+        }
+
+        return *this;
+    }
+
+    void UniqueAllocation::reset()
+    {
+        if (m_allocator != nullptr)
+        {
+            m_allocator->free(m_allocation);
+            m_allocator = nullptr;
+        }
+
+        m_allocation = {};
+    }
+
+    MemoryAllocator::MemoryAllocator(const vk::UniqueDevice & device, const vk::PhysicalDevice & physicalDevice, const vk::DeviceSize blockSize)
+        : m_device{ *device },
+          m_memoryProperties{ physicalDevice.getMemoryProperties() },
+          m_blockSize{ blockSize }
+    {
+        const auto limits{ physicalDevice.getProperties().limits };
+        m_bufferImageGranularity = std::max(limits.bufferImageGranularity, vk::DeviceSize{ 1 });
+        m_nonCoherentAtomSize = std::max(limits.nonCoherentAtomSize, vk::DeviceSize{ 1 });
+
+        if (m_blockSize < k_smallSize)
+        {
+            throw std::invalid_argument("block size must be at least " + std::to_string(k_smallSize) + " bytes");
+        }
+    }
+
+    UniqueAllocation MemoryAllocator::allocate(const vk::MemoryRequirements & requirements, const vk::MemoryPropertyFlags properties, const bool linear, const MemoryUsage usage)
+    {
+        if (requirements.size == 0)
+        {
+            throw std::invalid_argument("allocation size must not be zero");
+        }
+
+        const auto memoryTypeIndex{ findMemoryType(requirements.memoryTypeBits, properties) };
+        auto alignment{ std::max(requirements.alignment, vk::DeviceSize{ 1 }) };
+        auto size{ requirements.size };
+        if (m_memoryProperties.memoryTypes[memoryTypeIndex].propertyFlags & vk::MemoryPropertyFlagBits::eHostVisible)
+        {
+            alignment = std::max(alignment, m_nonCoherentAtomSize);
+            size = alignUp(size, m_nonCoherentAtomSize);
+        }
+
+        // Without a granularity all resources can share the same blocks
+        const auto blockLinear{ m_bufferImageGranularity > 1 ? linear : true };
+
+        if (size > m_blockSize / 2)
+        {
+            const auto blockIndex{ createBlock(memoryTypeIndex, size, blockLinear, true) };
+            return makeAllocation(blockIndex, 0, size, usage);
+        }
+
+        for (uint32_t i = 0; i < m_blocks.size(); ++i)
+        {
+            auto & block{ m_blocks[i] };
+            if (block && !block->dedicated && block->memoryTypeIndex == memoryTypeIndex && block->linear == blockLinear)
+            {
+                const auto nodeIndex{ allocateRange(*block, size, alignment) };
+                if (nodeIndex != k_null)
+                {
+                    return makeAllocation(i, nodeIndex, size, usage);
+                }
+            }
+        }
+
+        const auto blockIndex{ createBlock(memoryTypeIndex, m_blockSize, blockLinear, false) };
+        const auto nodeIndex{ allocateRange(*m_blocks[blockIndex], size, alignment) };
+        if (nodeIndex == k_null)
+        {
+            throw std::runtime_error("failed to allocate from a new memory block");
+        }
+
+        return makeAllocation(blockIndex, nodeIndex, size, usage);
+    }
+
+    UniqueAllocation MemoryAllocator::allocateBufferMemory(const vk::UniqueBuffer & buffer, const vk::MemoryPropertyFlags properties, const MemoryUsage usage)
+    {
+        auto allocation{ allocate(m_device.getBufferMemoryRequirements(*buffer), properties, true, usage) };
+        m_device.bindBufferMemory(*buffer, allocation->memory, allocation->offset);
+        return allocation;
+    }
+
+    UniqueAllocation MemoryAllocator::allocateImageMemory(const vk::UniqueImage & image, const vk::MemoryPropertyFlags properties, const vk::ImageTiling tiling, const MemoryUsage usage)
+    {
+        auto allocation{ allocate(m_device.getImageMemoryRequirements(*image), properties, tiling == vk::ImageTiling::eLinear, usage) };
+        m_device.bindImageMemory(*image, allocation->memory, allocation->offset);
+        return allocation;
+    }
+
+    void MemoryAllocator::free(const Allocation & allocation)
+    {
+        const auto heapIndex{ m_memoryProperties.memoryTypes[allocation.memoryTypeIndex].heapIndex };
+        m_statistics.total.remove(allocation.size);
+        m_statistics.heaps[heapIndex].remove(allocation.size);
+        m_statistics.types[allocation.memoryTypeIndex].remove(allocation.size);
+        m_statistics.usages[static_cast<size_t>(allocation.usage)].remove(allocation.size);
+
+        auto & block{ m_blocks[allocation.blockIndex] };
+        freeRange(*block, allocation.nodeIndex);
+        --block->allocationCount;
+        if (block->allocationCount > 0)
+        {
+            return;
+        }
+
+        // Empty blocks are released, except for the last shared block of a memory type, so that short lived staging
+        // buffers do not allocate and free device memory every time
+        auto keep{ !block->dedicated };
+        if (keep)
+        {
+            keep = std::none_of(m_blocks.begin(), m_blocks.end(), [&](const auto & other) { return other && other != block && !other->dedicated && other->memoryTypeIndex == block->memoryTypeIndex; });
+        }
+
+        if (!keep)
+        {
+            m_statistics.blocks.remove(block->size);
+            m_statistics.heapBlocks[heapIndex].remove(block->size);
+            block.reset();
+            --m_blockCount;
+        }
+    }
+
+    uint32_t MemoryAllocator::findMemoryType(const uint32_t typeFilter, const vk::MemoryPropertyFlags properties) const
+    {
+        for (uint32_t i = 0; i < m_memoryProperties.memoryTypeCount; ++i)
+        {
+            if (typeFilter & (1 << i) && (m_memoryProperties.memoryTypes[i].propertyFlags & properties) == properties)
+            {
+                return i;
+            }
+        }
+
+        throw std::runtime_error("failed to find suitable memory type!");
+    }
+
+    uint32_t MemoryAllocator::createBlock(const uint32_t memoryTypeIndex, const vk::DeviceSize size, const bool linear, const bool dedicated)
+    {
+        auto block{ std::make_unique<Block>() };
+        block->memory = m_device.allocateMemoryUnique({ size, memoryTypeIndex });
+        block->size = size;
+        block->mapped = nullptr;
+        block->memoryTypeIndex = memoryTypeIndex;
+        block->linear = linear;
+        block->dedicated = dedicated;
+        block->freeHeads.resize(k_firstLevelCount * k_secondLevelCount, k_null);
+
+        if (m_memoryProperties.memoryTypes[memoryTypeIndex].propertyFlags & vk::MemoryPropertyFlagBits::eHostVisible)
+        {
+            block->mapped = static_cast<uint8_t *>(m_device.mapMemory(*block->memory, 0, VK_WHOLE_SIZE, {}));
+        }
+
+        // A dedicated block holds exactly one allocation, which never goes through the free lists
+        const auto nodeIndex{ allocateNode(*block, 0, size) };
+        if (dedicated)
+        {
+            block->nodes[nodeIndex].free = false;
+            block->allocationCount = 1;
+        }
+        else
+        {
+            insertFree(*block, nodeIndex);
+        }
+
+        ++m_blockCount;
+        m_statistics.blocks.add(size);
+        m_statistics.heapBlocks[m_memoryProperties.memoryTypes[memoryTypeIndex].heapIndex].add(size);
+        const auto slot{ std::find(m_blocks.begin(), m_blocks.end(), nullptr) };
+        if (slot != m_blocks.end())
+        {
+            *slot = std::move(block);
+            return static_cast<uint32_t>(slot - m_blocks.begin());
+        }
+
+        m_blocks.emplace_back(std::move(block));
+        return static_cast<uint32_t>(m_blocks.size() - 1);
+    }
+
+    UniqueAllocation MemoryAllocator::makeAllocation(const uint32_t blockIndex, const uint32_t nodeIndex, const vk::DeviceSize size, const MemoryUsage usage)
+    {
+        const auto & block{ *m_blocks[blockIndex] };
+        const auto heapIndex{ m_memoryProperties.memoryTypes[block.memoryTypeIndex].heapIndex };
+        m_statistics.total.add(size);
+        m_statistics.heaps[heapIndex].add(size);
+        m_statistics.types[block.memoryTypeIndex].add(size);
+        m_statistics.usages[static_cast<size_t>(usage)].add(size);
+
+        const auto offset{ block.nodes[nodeIndex].offset };
+        return UniqueAllocation{ *this, { *block.memory, offset, size, block.mapped != nullptr ? block.mapped + offset : nullptr, block.memoryTypeIndex, blockIndex, nodeIndex, usage } };
+    }
+
+    uint32_t MemoryAllocator::allocateNode(Block & block, const vk::DeviceSize offset, const vk::DeviceSize size)
+    {
+        const Node node{ offset, size, k_null, k_null, k_null, k_null, true };
+        if (!block.unusedNodes.empty())
+        {
+            const auto index{ block.unusedNodes.back() };
+            block.unusedNodes.pop_back();
+            block.nodes[index] = node;
+            return index;
+        }
+
+        block.nodes.push_back(node);
+        return static_cast<uint32_t>(block.nodes.size() - 1);
+    }
+
+    uint32_t MemoryAllocator::allocateRange(Block & block, const vk::DeviceSize size, const vk::DeviceSize alignment)
+    {
+        // Rounding the request up to the next size class guarantees that any free range of the class found fits, including
+        // the padding needed for the alignment
+        auto searchSize{ size + alignment - 1 };
+        if (searchSize >= k_smallSize)
+        {
+            searchSize += (vk::DeviceSize{ 1 } << (mostSignificantBit(searchSize) - k_secondLevelLog2)) - 1;
+        }
+        else
+        {
+            searchSize += k_smallSize / k_secondLevelCount - 1;
+        }
+
+        if (searchSize > block.size)
+        {
+            return k_null;
+        }
+
+        uint32_t firstLevel, secondLevel;
+        mapping(searchSize, firstLevel, secondLevel);
+
+        auto secondLevelMap{ block.secondLevelMaps[firstLevel] & (~0u << secondLevel) };
+        if (secondLevelMap == 0)
+        {
+            const auto firstLevelMap{ firstLevel + 1 < 64 ? block.firstLevelMap & (~uint64_t{ 0 } << (firstLevel + 1)) : 0 };
+            if (firstLevelMap == 0)
+            {
+                return k_null;
+            }
+
+            firstLevel = leastSignificantBit(firstLevelMap);
+            secondLevelMap = block.secondLevelMaps[firstLevel];
+        }
+
+        secondLevel = leastSignificantBit(secondLevelMap);
+        const auto nodeIndex{ block.freeHeads[firstLevel * k_secondLevelCount + secondLevel] };
+        removeFree(block, nodeIndex);
+
+        // Return the alignment padding in front and the unused rest behind the allocation to the free lists
+        const auto alignedOffset{ alignUp(block.nodes[nodeIndex].offset, alignment) };
+        const auto padding{ alignedOffset - block.nodes[nodeIndex].offset };
+        if (padding > 0)
+        {
+            const auto paddingIndex{ allocateNode(block, block.nodes[nodeIndex].offset, padding) };
+            auto & paddingNode{ block.nodes[paddingIndex] };
+            auto & node{ block.nodes[nodeIndex] };
+            paddingNode.prevPhysical = node.prevPhysical;
+            paddingNode.nextPhysical = nodeIndex;
+            if (node.prevPhysical != k_null)
+            {
+                block.nodes[node.prevPhysical].nextPhysical = paddingIndex;
+            }
+
+            node.prevPhysical = paddingIndex;
+            node.offset = alignedOffset;
+            node.size -= padding;
+            insertFree(block, paddingIndex);
+        }
+
+        const auto rest{ block.nodes[nodeIndex].size - size };
+        if (rest > 0)
+        {
+            const auto restIndex{ allocateNode(block, alignedOffset + size, rest) };
+            auto & restNode{ block.nodes[restIndex] };
+            auto & node{ block.nodes[nodeIndex] };
+            restNode.prevPhysical = nodeIndex;
+            restNode.nextPhysical = node.nextPhysical;
+            if (node.nextPhysical != k_null)
+            {
+                block.nodes[node.nextPhysical].prevPhysical = restIndex;
+            }
+
+            node.nextPhysical = restIndex;
+            node.size = size;
+            insertFree(block, restIndex);
+        }
+
+        block.nodes[nodeIndex].free = false;
+        ++block.allocationCount;
+        return nodeIndex;
+    }
+
+    void MemoryAllocator::freeRange(Block & block, const uint32_t nodeIndex)
+    {
+        // Merge with the free neighbours, free ranges are never adjacent to each other
+        const auto prevIndex{ block.nodes[nodeIndex].prevPhysical };
+        if (prevIndex != k_null && block.nodes[prevIndex].free)
+        {
+            removeFree(block, prevIndex);
+            auto & node{ block.nodes[nodeIndex] };
+            const auto & prev{ block.nodes[prevIndex] };
+            node.offset = prev.offset;
+            node.size += prev.size;
+            node.prevPhysical = prev.prevPhysical;
+            if (node.prevPhysical != k_null)
+            {
+                block.nodes[node.prevPhysical].nextPhysical = nodeIndex;
+            }
+
+            block.unusedNodes.push_back(prevIndex);
+        }
+
+        const auto nextIndex{ block.nodes[nodeIndex].nextPhysical };
+        if (nextIndex != k_null && block.nodes[nextIndex].free)
+        {
+            removeFree(block, nextIndex);
+            auto & node{ block.nodes[nodeIndex] };
+            const auto & next{ block.nodes[nextIndex] };
+            node.size += next.size;
+            node.nextPhysical = next.nextPhysical;
+            if (node.nextPhysical != k_null)
+            {
+                block.nodes[node.nextPhysical].prevPhysical = nodeIndex;
+            }
+
+            block.unusedNodes.push_back(nextIndex);
+        }
+
+        block.nodes[nodeIndex].free = true;
+        if (!block.dedicated)
+        {
+            insertFree(block, nodeIndex);
+        }
+    }
+
+    void MemoryAllocator::insertFree(Block & block, const uint32_t nodeIndex)
+    {
+        uint32_t firstLevel, secondLevel;
+        mapping(block.nodes[nodeIndex].size, firstLevel, secondLevel);
+
+        auto & head{ block.freeHeads[firstLevel * k_secondLevelCount + secondLevel] };
+        auto & node{ block.nodes[nodeIndex] };
+        node.free = true;
+        node.prevFree = k_null;
+        node.nextFree = head;
+        if (head != k_null)
+        {
+            block.nodes[head].prevFree = nodeIndex;
+        }
+
+        head = nodeIndex;
+        block.secondLevelMaps[firstLevel] |= 1u << secondLevel;
+        block.firstLevelMap |= uint64_t{ 1 } << firstLevel;
+    }
+
+    void MemoryAllocator::removeFree(Block & block, const uint32_t nodeIndex)
+    {
+        uint32_t firstLevel, secondLevel;
+        mapping(block.nodes[nodeIndex].size, firstLevel, secondLevel);
+
+        auto & node{ block.nodes[nodeIndex] };
+        if (node.prevFree != k_null)
+        {
+            block.nodes[node.prevFree].nextFree = node.nextFree;
+        }
+
+        if (node.nextFree != k_null)
+        {
+            block.nodes[node.nextFree].prevFree = node.prevFree;
+        }
+
+        auto & head{ block.freeHeads[firstLevel * k_secondLevelCount + secondLevel] };
+        if (head == nodeIndex)
+        {
+            head = node.nextFree;
+            if (head == k_null)
+            {
+                block.secondLevelMaps[firstLevel] &= ~(1u << secondLevel);
+                if (block.secondLevelMaps[firstLevel] == 0)
+                {
+                    block.firstLevelMap &= ~(uint64_t{ 1 } << firstLevel);
+                }
+            }
+        }
+
+        node.prevFree = k_null;
+        node.nextFree = k_null;
+        node.free = false;
+    }
+
+    void MemoryAllocator::mapping(const vk::DeviceSize size, uint32_t & firstLevel, uint32_t & secondLevel)
+    {
+        if (size < k_smallSize)
+        {
+            firstLevel = 0;
+            secondLevel = static_cast<uint32_t>(size / (k_smallSize / k_secondLevelCount));
+            return;
+        }
+
+        const auto bit{ mostSignificantBit(size) };
+        firstLevel = bit - k_smallSizeLog2 + 1;
+        secondLevel = static_cast<uint32_t>((size >> (bit - k_secondLevelLog2)) ^ (vk::DeviceSize{ 1 } << k_secondLevelLog2));
+    }
+}
@@ -0,0 +1,153 @@
+#pragma once
+
+#include <vulkan/vulkan.hpp>
+
+#include <array>
+#include <limits>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+#include "memoryStatistics.hpp"
+
+namespace vw::util
+{
+    class MemoryAllocator;
+
+    // A range of device memory handed out by the MemoryAllocator. Host visible ranges are mapped as long as their block lives,
+    // so mapped already points at offset and the memory must not be mapped again.
+    struct Allocation
+    {
+        vk::DeviceMemory memory;
+        vk::DeviceSize offset = 0;
+        vk::DeviceSize size = 0;
+        void * mapped = nullptr;
+        uint32_t memoryTypeIndex = 0;
+        uint32_t blockIndex = 0;
+        uint32_t nodeIndex = 0;
+        MemoryUsage usage = MemoryUsage::Other;
+    };
+
+    // Returns its allocation to the allocator on destruction, like the vk::Unique handles do
+    class UniqueAllocation
+    {
+    public:
+        UniqueAllocation() {}
+        UniqueAllocation(MemoryAllocator & allocator, const Allocation & allocation) : m_allocator{ &allocator }, m_allocation{ allocation } {}
+        UniqueAllocation(const UniqueAllocation &) = delete;
+        UniqueAllocation(UniqueAllocation && other) noexcept;
+        UniqueAllocation & operator=(const UniqueAllocation &) = delete;
+        UniqueAllocation & operator=(UniqueAllocation && other) noexcept;
+        ~UniqueAllocation() { reset(); }
+
+        const Allocation & operator*() const noexcept { return m_allocation; }
+        const Allocation * operator->() const noexcept { return &m_allocation; }
+        explicit operator bool() const noexcept { return m_allocator != nullptr; }
+
+        void reset();
+    private:
+        MemoryAllocator * m_allocator = nullptr;
+        Allocation m_allocation;
+    };
+
+    // Allocates large blocks of device memory per memory type and suballocates them with a two-level segregated fit (TLSF)
+    // free list, so finding and freeing a range takes constant time. Requests larger than half a block get a dedicated block.
+    // Linear and optimal resources are kept in separate blocks whenever bufferImageGranularity is larger than one, so they can
+    // never share a granularity page. Host visible allocations are aligned and sized to whole nonCoherentAtomSize atoms, so
+    // their ranges can be flushed without touching neighbouring allocations.
+    // Every allocation and block is accounted in the statistics, which are the place to look for leaks and budget overruns.
+    // The allocator has to outlive all of its allocations and must not be moved, they point back to it.
+    class MemoryAllocator
+    {
+    public:
+        static constexpr vk::DeviceSize k_defaultBlockSize = 64 * 1024 * 1024;
+
+        MemoryAllocator(const vk::UniqueDevice & device, const vk::PhysicalDevice & physicalDevice, const vk::DeviceSize blockSize = k_defaultBlockSize);
+        MemoryAllocator(const MemoryAllocator &) = delete;
+        MemoryAllocator(MemoryAllocator && other) = delete;
+        MemoryAllocator & operator=(const MemoryAllocator &) = delete;
+        MemoryAllocator & operator=(MemoryAllocator && other) = delete;
+        ~MemoryAllocator() {}
+
+        // Linear resources are buffers and linearly tiled images
+        UniqueAllocation allocate(const vk::MemoryRequirements & requirements, const vk::MemoryPropertyFlags properties, const bool linear, const MemoryUsage usage = MemoryUsage::Other);
+        // Allocate memory for the resource and bind it
+        UniqueAllocation allocateBufferMemory(const vk::UniqueBuffer & buffer, const vk::MemoryPropertyFlags properties, const MemoryUsage usage = MemoryUsage::Other);
+        UniqueAllocation allocateImageMemory(const vk::UniqueImage & image, const vk::MemoryPropertyFlags properties, const vk::ImageTiling tiling = vk::ImageTiling::eOptimal, const MemoryUsage usage = MemoryUsage::Other);
+
+        const auto & getMemoryProperties() const noexcept { return m_memoryProperties; }
+        auto getNonCoherentAtomSize() const noexcept { return m_nonCoherentAtomSize; }
+        auto getBlockCount() const noexcept { return m_blockCount; }
+        const auto & getStatistics() const noexcept { return m_statistics; }
+    private:
+        friend class UniqueAllocation;
+
+        static constexpr uint32_t k_null = std::numeric_limits<uint32_t>::max();
+        // Sizes below k_smallSize share the first level, split into steps of k_smallSize / k_secondLevelCount bytes
+        static constexpr uint32_t k_secondLevelLog2 = 4;
+        static constexpr uint32_t k_secondLevelCount = 1 << k_secondLevelLog2;
+        static constexpr uint32_t k_smallSizeLog2 = 8;
+        static constexpr vk::DeviceSize k_smallSize = vk::DeviceSize{ 1 } << k_smallSizeLog2;
+        static constexpr uint32_t k_firstLevelCount = 64 - k_smallSizeLog2 + 1;
+
+        // A physically contiguous range of a block, either allocated or linked into a free list
+        struct Node
+        {
+            vk::DeviceSize offset;
+            vk::DeviceSize size;
+            uint32_t prevPhysical;
+            uint32_t nextPhysical;
+            uint32_t prevFree;
+            uint32_t nextFree;
+            bool free;
+        };
+
+        struct Block
+        {
+            vk::UniqueDeviceMemory memory;
+            vk::DeviceSize size;
+            uint8_t * mapped;
+            uint32_t memoryTypeIndex;
+            bool linear;
+            bool dedicated;
+            uint32_t allocationCount = 0;
+
+            uint64_t firstLevelMap = 0;
+            std::array<uint32_t, k_firstLevelCount> secondLevelMaps{};
+            std::vector<uint32_t> freeHeads;
+            std::vector<Node> nodes;
+            std::vector<uint32_t> unusedNodes;
+        };
+
+        vk::Device m_device;
+        vk::PhysicalDeviceMemoryProperties m_memoryProperties;
+        vk::DeviceSize m_blockSize;
+        vk::DeviceSize m_bufferImageGranularity;
+        vk::DeviceSize m_nonCoherentAtomSize;
+        std::vector<std::unique_ptr<Block>> m_blocks;
+        uint32_t m_blockCount = 0;
+        MemoryStatistics m_statistics;
+
+        void free(const Allocation & allocation);
+        uint32_t findMemoryType(const uint32_t typeFilter, const vk::MemoryPropertyFlags properties) const;
+        uint32_t createBlock(const uint32_t memoryTypeIndex, const vk::DeviceSize size, const bool linear, const bool dedicated);
+        UniqueAllocation makeAllocation(const uint32_t blockIndex, const uint32_t nodeIndex, const vk::DeviceSize size, const MemoryUsage usage);
+
+        static uint32_t allocateNode(Block & block, const vk::DeviceSize offset, const vk::DeviceSize size);
+        static uint32_t allocateRange(Block & block, const vk::DeviceSize size, const vk::DeviceSize alignment);
+        static void freeRange(Block & block, const uint32_t nodeIndex);
+        static void insertFree(Block & block, const uint32_t nodeIndex);
+        static void removeFree(Block & block, const uint32_t nodeIndex);
+        static void mapping(const vk::DeviceSize size, uint32_t & firstLevel, uint32_t & secondLevel);
+    };
+
+    static_assert(std::is_move_constructible_v<UniqueAllocation>);
+    static_assert(!std::is_copy_constructible_v<UniqueAllocation>);
+    static_assert(std::is_move_assignable_v<UniqueAllocation>);
+    static_assert(!std::is_copy_assignable_v<UniqueAllocation>);
+
+    static_assert(!std::is_move_constructible_v<MemoryAllocator>);
+    static_assert(!std::is_copy_constructible_v<MemoryAllocator>);
+    static_assert(!std::is_move_assignable_v<MemoryAllocator>);
+    static_assert(!std::is_copy_assignable_v<MemoryAllocator>);
+}
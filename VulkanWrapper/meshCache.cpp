@@ -0,0 +1,176 @@
+#include "meshCache.hpp"
+
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <system_error>
+
+namespace vw::scene
+{
+    namespace
+    {
+        namespace fs = std::experimental::filesystem;
+
+        constexpr uint32_t k_magic = 0x434d5756; // "VWMC"
+
+        struct Header
+        {
+            uint32_t magic;
+            uint32_t version;
+            uint32_t vertexDescription;
+            uint32_t vertexSize;
+            uint32_t importFlags;
+            uint32_t loaderFlags;
+            int64_t sourceTime;
+            uint64_t sourceSize;
+            uint64_t numVertices;
+            uint64_t numIndices;
+            glm::vec4 boundingSphere;
+        };
+
+        // The vertices follow right after the header, which keeps them 4 byte aligned
+        static_assert(sizeof(Header) == 72);
+
+        template<VertexDescription VD>
+        bool createHeader(const fs::path & source, const uint32_t importFlags, const uint32_t loaderFlags, Header & header)
+        {
+            std::error_code error;
+            const auto sourceTime{ fs::last_write_time(source, error) };
+            if (error)
+            {
+                return false;
+            }
+
+            const auto sourceSize{ fs::file_size(source, error) };
+            if (error)
+            {
+                return false;
+            }
+
+            header = {};
+            header.magic = k_magic;
+            header.version = k_meshCacheVersion;
+            header.vertexDescription = static_cast<uint32_t>(VD);
+            header.vertexSize = sizeof(Vertex<VD>);
+            header.importFlags = importFlags;
+            header.loaderFlags = loaderFlags;
+            header.sourceTime = static_cast<int64_t>(sourceTime.time_since_epoch().count());
+            header.sourceSize = static_cast<uint64_t>(sourceSize);
+            return true;
+        }
+    }
+
+    template<VertexDescription VD>
+    fs::path getMeshCachePath(const fs::path & source, const uint32_t importFlags, const uint32_t loaderFlags)
+    {
+        auto path{ source };
+        path += "." + std::to_string(static_cast<uint32_t>(VD)) + "-" + std::to_string(importFlags) + "-" + std::to_string(loaderFlags) + ".vwmesh";
+        return path;
+    }
+
+    template<VertexDescription VD>
+    bool loadMeshCache(const fs::path & source, const uint32_t importFlags, const uint32_t loaderFlags, Model<VD> & model)
+    {
+        Header expected;
+        if (!createHeader<VD>(source, importFlags, loaderFlags, expected))
+        {
+            return false;
+        }
+
+        const auto path{ getMeshCachePath<VD>(source, importFlags, loaderFlags) };
+        std::error_code error;
+        if (!fs::exists(path, error))
+        {
+            return false;
+        }
+
+        util::MappedFile file;
+        try
+        {
+            file = util::MappedFile{ path };
+        }
+        catch (const std::runtime_error &)
+        {
+            return false;
+        }
+
+        // Everything but the counts and the bounds has to match, and the arrays have to fill the rest of the file exactly
+        if (file.size() < sizeof(Header))
+        {
+            return false;
+        }
+
+        Header header;
+        memcpy(&header, file.data(), sizeof(Header));
+        if (header.magic != expected.magic || header.version != expected.version || header.vertexDescription != expected.vertexDescription || header.vertexSize != expected.vertexSize
+            || header.importFlags != expected.importFlags || header.loaderFlags != expected.loaderFlags || header.sourceTime != expected.sourceTime || header.sourceSize != expected.sourceSize)
+        {
+            return false;
+        }
+
+        const auto vertexBytes{ header.numVertices * sizeof(Vertex<VD>) };
+        const auto indexBytes{ header.numIndices * sizeof(uint32_t) };
+        if (header.numVertices > file.size() || header.numIndices > file.size() || file.size() != sizeof(Header) + vertexBytes + indexBytes)
+        {
+            return false;
+        }
+
+        const auto * vertices{ reinterpret_cast<const Vertex<VD> *>(file.data() + sizeof(Header)) };
+        const auto * indices{ reinterpret_cast<const uint32_t *>(file.data() + sizeof(Header) + vertexBytes) };
+        model.setMappedGeometry(std::move(file), vertices, static_cast<size_t>(header.numVertices), indices, static_cast<size_t>(header.numIndices));
+        model.setBoundingSphere(header.boundingSphere);
+        return true;
+    }
+
+    template<VertexDescription VD>
+    bool storeMeshCache(const fs::path & source, const uint32_t importFlags, const uint32_t loaderFlags, const Model<VD> & model)
+    {
+        Header header;
+        if (!createHeader<VD>(source, importFlags, loaderFlags, header))
+        {
+            return false;
+        }
+
+        const auto & vertices{ model.getVertices() };
+        const auto & indices{ model.getIndices() };
+        header.numVertices = vertices.size();
+        header.numIndices = indices.size();
+        header.boundingSphere = model.getBoundingSphere();
+
+        // Written to a temporary file first, so a cache is either complete or not there at all
+        const auto path{ getMeshCachePath<VD>(source, importFlags, loaderFlags) };
+        auto tempPath{ path };
+        tempPath += ".tmp";
+        {
+            std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+            file.write(reinterpret_cast<const char *>(&header), sizeof(Header));
+            file.write(reinterpret_cast<const char *>(vertices.data()), vertices.size() * sizeof(Vertex<VD>));
+            file.write(reinterpret_cast<const char *>(indices.data()), indices.size() * sizeof(uint32_t));
+            file.close();
+            if (!file)
+            {
+                std::error_code error;
+                fs::remove(tempPath, error);
+                return false;
+            }
+        }
+
+        std::error_code error;
+        fs::remove(path, error);
+        fs::rename(tempPath, path, error);
+        if (error)
+        {
+            fs::remove(tempPath, error);
+            return false;
+        }
+
+        return true;
+    }
+
+    template fs::path getMeshCachePath<VertexDescription::PositionNormalColorTexture>(const fs::path & source, const uint32_t importFlags, const uint32_t loaderFlags);
+    template fs::path getMeshCachePath<VertexDescription::PositionNormalColor>(const fs::path & source, const uint32_t importFlags, const uint32_t loaderFlags);
+    template bool loadMeshCache(const fs::path & source, const uint32_t importFlags, const uint32_t loaderFlags, Model<VertexDescription::PositionNormalColorTexture> & model);
+    template bool loadMeshCache(const fs::path & source, const uint32_t importFlags, const uint32_t loaderFlags, Model<VertexDescription::PositionNormalColor> & model);
+    template bool storeMeshCache(const fs::path & source, const uint32_t importFlags, const uint32_t loaderFlags, const Model<VertexDescription::PositionNormalColorTexture> & model);
+    template bool storeMeshCache(const fs::path & source, const uint32_t importFlags, const uint32_t loaderFlags, const Model<VertexDescription::PositionNormalColor> & model);
+}
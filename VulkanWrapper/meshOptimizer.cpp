@@ -0,0 +1,459 @@
+#include "meshOptimizer.hpp"
+
+#include <glm/gtc/constants.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numeric>
+#include <stdexcept>
+
+namespace vw::scene
+{
+    namespace
+    {
+        void validateTriangleList(const std::vector<uint32_t> & indices, const size_t numVertices)
+        {
+            if (indices.size() % 3 != 0)
+            {
+                throw std::invalid_argument("indices are no triangle list");
+            }
+
+            for (const auto index : indices)
+            {
+                if (index >= numVertices)
+                {
+                    throw std::invalid_argument("index too big");
+                }
+            }
+        }
+
+        const glm::vec3 & getPosition(const glm::vec3 * positions, const size_t positionStride, const uint32_t index)
+        {
+            return *reinterpret_cast<const glm::vec3 *>(reinterpret_cast<const uint8_t *>(positions) + index * positionStride);
+        }
+
+        // A FIFO cache holds the vertices of the last cacheSize misses, hits do not refresh a vertex
+        class FifoCache
+        {
+        public:
+            FifoCache(const size_t numVertices, const uint32_t cacheSize) : m_size{ cacheSize }, m_time{ cacheSize }, m_missedAt(numVertices, 0) {}
+
+            // Returns whether the vertex had to be transformed
+            bool access(const uint32_t index)
+            {
+                if (m_time - m_missedAt[index] < m_size)
+                {
+                    return false;
+                }
+
+                m_missedAt[index] = m_time++;
+                return true;
+            }
+
+            uint32_t accessTriangle(const uint32_t * triangle)
+            {
+                return static_cast<uint32_t>(access(triangle[0])) + access(triangle[1]) + access(triangle[2]);
+            }
+
+            void clear() noexcept { m_time += m_size; }
+        private:
+            uint64_t m_size;
+            uint64_t m_time;
+            std::vector<uint64_t> m_missedAt;
+        };
+
+        // Twice the signed area of the triangle abp, positive when it is counter-clockwise
+        float edgeFunction(const glm::vec3 & a, const glm::vec3 & b, const float x, const float y)
+        {
+            return (b.x - a.x) * (y - a.y) - (b.y - a.y) * (x - a.x);
+        }
+
+        // Pixel centers exactly on an edge belong to the triangle only for its top and left edges, so a pixel on the edge
+        // shared by two triangles is shaded once
+        bool isTopLeft(const glm::vec3 & a, const glm::vec3 & b)
+        {
+            return (a.y == b.y && b.x < a.x) || b.y < a.y;
+        }
+    }
+
+    VertexCacheStatistics analyzeVertexCache(const std::vector<uint32_t> & indices, const size_t numVertices, const uint32_t cacheSize)
+    {
+        validateTriangleList(indices, numVertices);
+        if (indices.empty())
+        {
+            return {};
+        }
+
+        FifoCache cache{ numVertices, cacheSize };
+        uint64_t misses = 0;
+        std::vector<bool> used(numVertices, false);
+        size_t numUsed = 0;
+        for (const auto index : indices)
+        {
+            misses += cache.access(index);
+
+            if (!used[index])
+            {
+                used[index] = true;
+                ++numUsed;
+            }
+        }
+
+        const auto transformed{ static_cast<float>(misses) };
+        return { transformed / (indices.size() / 3), transformed / numUsed };
+    }
+
+    void optimizeVertexCache(std::vector<uint32_t> & indices, const size_t numVertices, const uint32_t cacheSize)
+    {
+        validateTriangleList(indices, numVertices);
+        const auto numTriangles{ indices.size() / 3 };
+
+        // The triangles around each vertex, vertex v's are adjacency[offsets[v]] up to adjacency[offsets[v + 1]]
+        std::vector<uint32_t> offsets(numVertices + 1, 0);
+        for (const auto index : indices)
+        {
+            ++offsets[index + 1];
+        }
+        std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+
+        std::vector<uint32_t> adjacency(indices.size());
+        std::vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+        for (uint32_t t = 0; t < numTriangles; ++t)
+        {
+            for (uint32_t k = 0; k < 3; ++k)
+            {
+                adjacency[fill[indices[3 * t + k]]++] = t;
+            }
+        }
+
+        // The number of triangles around each vertex that are still to be emitted
+        std::vector<uint32_t> live(numVertices);
+        for (size_t v = 0; v < numVertices; ++v)
+        {
+            live[v] = offsets[v + 1] - offsets[v];
+        }
+
+        // A vertex is in the cache while fewer than cacheSize vertices have been added after it
+        std::vector<uint64_t> cacheTime(numVertices, 0);
+        auto time{ static_cast<uint64_t>(cacheSize) + 1 };
+        std::vector<bool> emitted(numTriangles, false);
+        std::vector<uint32_t> deadEnd;
+        std::vector<uint32_t> candidates;
+        size_t cursor = 0;
+
+        // Without a candidate, continue at the most recently used vertex with triangles left, or else at the next one in order
+        const auto skipDeadEnd = [&]()
+        {
+            while (!deadEnd.empty())
+            {
+                const auto v{ deadEnd.back() };
+                deadEnd.pop_back();
+                if (live[v] > 0)
+                {
+                    return static_cast<int64_t>(v);
+                }
+            }
+
+            for (; cursor < numVertices; ++cursor)
+            {
+                if (live[cursor] > 0)
+                {
+                    return static_cast<int64_t>(cursor);
+                }
+            }
+
+            return int64_t{ -1 };
+        };
+
+        std::vector<uint32_t> result;
+        result.reserve(indices.size());
+        for (auto fan{ skipDeadEnd() }; fan >= 0;)
+        {
+            candidates.clear();
+            for (auto a = offsets[fan]; a < offsets[fan + 1]; ++a)
+            {
+                const auto t{ adjacency[a] };
+                if (emitted[t])
+                {
+                    continue;
+                }
+
+                for (uint32_t k = 0; k < 3; ++k)
+                {
+                    const auto v{ indices[3 * t + k] };
+                    result.push_back(v);
+                    deadEnd.push_back(v);
+                    candidates.push_back(v);
+                    --live[v];
+                    if (time - cacheTime[v] > cacheSize)
+                    {
+                        cacheTime[v] = time++;
+                    }
+                }
+                emitted[t] = true;
+            }
+
+            // Prefer the candidate that entered the cache first, as long as its remaining triangles will still find it there
+            fan = -1;
+            int64_t bestPriority = -1;
+            for (const auto v : candidates)
+            {
+                if (live[v] == 0)
+                {
+                    continue;
+                }
+
+                int64_t priority = 0;
+                if (time - cacheTime[v] + 2 * static_cast<uint64_t>(live[v]) <= cacheSize)
+                {
+                    priority = static_cast<int64_t>(time - cacheTime[v]);
+                }
+
+                if (priority > bestPriority)
+                {
+                    bestPriority = priority;
+                    fan = v;
+                }
+            }
+
+            if (fan < 0)
+            {
+                fan = skipDeadEnd();
+            }
+        }
+
+        indices = std::move(result);
+    }
+
+    void optimizeOverdraw(std::vector<uint32_t> & indices, const glm::vec3 * positions, const size_t numVertices, const size_t positionStride, const uint32_t cacheSize, const float threshold)
+    {
+        validateTriangleList(indices, numVertices);
+        const auto numTriangles{ static_cast<uint32_t>(indices.size() / 3) };
+        if (numTriangles < 2)
+        {
+            return;
+        }
+
+        // A triangle that misses all of its vertices reuses nothing from the ones before it
+        std::vector<uint32_t> hardStarts;
+        FifoCache cache{ numVertices, cacheSize };
+        for (uint32_t t = 0; t < numTriangles; ++t)
+        {
+            if (cache.accessTriangle(&indices[3 * t]) == 3 || t == 0)
+            {
+                hardStarts.push_back(t);
+            }
+        }
+        hardStarts.push_back(numTriangles);
+
+        // The cache is cleared at every cluster start, the order inside the clusters has to do well without what came before
+        std::vector<uint32_t> clusterStarts;
+        for (size_t h = 0; h + 1 < hardStarts.size(); ++h)
+        {
+            const auto start{ hardStarts[h] };
+            const auto end{ hardStarts[h + 1] };
+
+            cache.clear();
+            uint32_t hardMisses = 0;
+            for (auto t = start; t < end; ++t)
+            {
+                hardMisses += cache.accessTriangle(&indices[3 * t]);
+            }
+            const auto softThreshold{ threshold * hardMisses / (end - start) };
+
+            cache.clear();
+            clusterStarts.push_back(start);
+            uint32_t misses = 0;
+            uint32_t triangles = 0;
+            for (auto t = start; t < end; ++t)
+            {
+                misses += cache.accessTriangle(&indices[3 * t]);
+                ++triangles;
+                if (t + 1 < end && misses <= softThreshold * triangles)
+                {
+                    clusterStarts.push_back(t + 1);
+                    cache.clear();
+                    misses = 0;
+                    triangles = 0;
+                }
+            }
+        }
+        clusterStarts.push_back(numTriangles);
+
+        glm::dvec3 centroidSum{ 0.0 };
+        for (const auto index : indices)
+        {
+            centroidSum += glm::dvec3{ getPosition(positions, positionStride, index) };
+        }
+        const glm::vec3 meshCentroid{ centroidSum / static_cast<double>(indices.size()) };
+
+        struct Cluster
+        {
+            float sortKey;
+            uint32_t start;
+            uint32_t end;
+        };
+
+        std::vector<Cluster> clusters;
+        clusters.reserve(clusterStarts.size() - 1);
+        for (size_t i = 0; i + 1 < clusterStarts.size(); ++i)
+        {
+            const auto start{ clusterStarts[i] };
+            const auto end{ clusterStarts[i + 1] };
+
+            glm::vec3 normal{ 0.f };
+            glm::vec3 centroid{ 0.f };
+            auto area{ 0.f };
+            for (auto t = start; t < end; ++t)
+            {
+                const auto & a{ getPosition(positions, positionStride, indices[3 * t]) };
+                const auto & b{ getPosition(positions, positionStride, indices[3 * t + 1]) };
+                const auto & c{ getPosition(positions, positionStride, indices[3 * t + 2]) };
+                const auto n{ glm::cross(b - a, c - a) };
+                const auto triangleArea{ glm::length(n) };
+                normal += n;
+                centroid += (a + b + c) * (triangleArea / 3.f);
+                area += triangleArea;
+            }
+
+            auto sortKey{ 0.f };
+            const auto normalLength{ glm::length(normal) };
+            if (area > 0.f && normalLength > 0.f)
+            {
+                sortKey = glm::dot(centroid / area - meshCentroid, normal / normalLength);
+            }
+            clusters.push_back({ sortKey, start, end });
+        }
+
+        std::stable_sort(clusters.begin(), clusters.end(), [](const Cluster & lhs, const Cluster & rhs) { return lhs.sortKey > rhs.sortKey; });
+
+        std::vector<uint32_t> result;
+        result.reserve(indices.size());
+        for (const auto & cluster : clusters)
+        {
+            result.insert(result.end(), indices.begin() + 3 * static_cast<size_t>(cluster.start), indices.begin() + 3 * static_cast<size_t>(cluster.end));
+        }
+        indices = std::move(result);
+    }
+
+    OverdrawStatistics estimateOverdraw(const std::vector<uint32_t> & indices, const glm::vec3 * positions, const size_t numVertices, const size_t positionStride, const uint32_t numViews, const uint32_t resolution)
+    {
+        validateTriangleList(indices, numVertices);
+        if (indices.empty() || numViews == 0 || resolution == 0)
+        {
+            return {};
+        }
+
+        // Every view looks at the bounding box from the outside of its bounding sphere
+        auto min{ getPosition(positions, positionStride, indices[0]) };
+        auto max{ min };
+        for (const auto index : indices)
+        {
+            min = glm::min(min, getPosition(positions, positionStride, index));
+            max = glm::max(max, getPosition(positions, positionStride, index));
+        }
+        const auto center{ (min + max) * 0.5f };
+        const auto radius{ std::max(glm::length(max - min) * 0.5f, std::numeric_limits<float>::min()) };
+        const auto scale{ 0.5f * resolution / radius };
+        const auto half{ 0.5f * resolution };
+
+        OverdrawStatistics statistics;
+        std::vector<glm::vec3> projected(numVertices);
+        std::vector<float> depth(static_cast<size_t>(resolution) * resolution);
+        const auto goldenAngle{ glm::pi<float>() * (3.f - std::sqrt(5.f)) };
+        for (uint32_t view = 0; view < numViews; ++view)
+        {
+            // Directions on a Fibonacci spiral, looking from the eye into the scene
+            const auto z{ 1.f - (2.f * view + 1.f) / numViews };
+            const auto r{ std::sqrt(std::max(0.f, 1.f - z * z)) };
+            const auto phi{ goldenAngle * view };
+            const glm::vec3 direction{ -r * std::cos(phi), -r * std::sin(phi), -z };
+            const auto right{ glm::normalize(glm::cross(direction, std::abs(direction.y) < 0.99f ? glm::vec3{ 0.f, 1.f, 0.f } : glm::vec3{ 1.f, 0.f, 0.f })) };
+            const auto up{ glm::cross(right, direction) };
+
+            // Pixel coordinates in xy, distance from the center along the view direction in z
+            for (uint32_t v = 0; v < numVertices; ++v)
+            {
+                const auto p{ getPosition(positions, positionStride, v) - center };
+                projected[v] = { glm::dot(p, right) * scale + half, glm::dot(p, up) * scale + half, glm::dot(p, direction) };
+            }
+
+            std::fill(depth.begin(), depth.end(), std::numeric_limits<float>::infinity());
+            for (size_t i = 0; i < indices.size(); i += 3)
+            {
+                const auto & a{ projected[indices[i]] };
+                const auto & b{ projected[indices[i + 1]] };
+                const auto & c{ projected[indices[i + 2]] };
+                const auto area{ edgeFunction(a, b, c.x, c.y) };
+                if (area <= 0.f)
+                {
+                    continue;
+                }
+
+                const auto x0{ std::max(0, static_cast<int>(std::floor(std::min({ a.x, b.x, c.x })))) };
+                const auto x1{ std::min(static_cast<int>(resolution) - 1, static_cast<int>(std::ceil(std::max({ a.x, b.x, c.x })))) };
+                const auto y0{ std::max(0, static_cast<int>(std::floor(std::min({ a.y, b.y, c.y })))) };
+                const auto y1{ std::min(static_cast<int>(resolution) - 1, static_cast<int>(std::ceil(std::max({ a.y, b.y, c.y })))) };
+                const auto topLeftA{ isTopLeft(b, c) };
+                const auto topLeftB{ isTopLeft(c, a) };
+                const auto topLeftC{ isTopLeft(a, b) };
+                for (auto y = y0; y <= y1; ++y)
+                {
+                    for (auto x = x0; x <= x1; ++x)
+                    {
+                        const auto px{ x + 0.5f };
+                        const auto py{ y + 0.5f };
+                        const auto wa{ edgeFunction(b, c, px, py) };
+                        const auto wb{ edgeFunction(c, a, px, py) };
+                        const auto wc{ edgeFunction(a, b, px, py) };
+                        if (wa < 0.f || wb < 0.f || wc < 0.f || (wa == 0.f && !topLeftA) || (wb == 0.f && !topLeftB) || (wc == 0.f && !topLeftC))
+                        {
+                            continue;
+                        }
+
+                        auto & pixelDepth{ depth[static_cast<size_t>(y) * resolution + x] };
+                        const auto fragmentDepth{ (wa * a.z + wb * b.z + wc * c.z) / area };
+                        if (fragmentDepth < pixelDepth)
+                        {
+                            pixelDepth = fragmentDepth;
+                            ++statistics.shaded;
+                        }
+                    }
+                }
+            }
+
+            statistics.covered += std::count_if(depth.begin(), depth.end(), [](const float d) { return d != std::numeric_limits<float>::infinity(); });
+        }
+
+        statistics.overdraw = statistics.covered > 0 ? static_cast<float>(statistics.shaded) / statistics.covered : 0.f;
+        return statistics;
+    }
+
+    std::vector<uint32_t> remapIndicesForVertexFetch(std::vector<uint32_t> & indices, const size_t numVertices)
+    {
+        validateTriangleList(indices, numVertices);
+        constexpr auto unused{ std::numeric_limits<uint32_t>::max() };
+
+        std::vector<uint32_t> remap(numVertices, unused);
+        uint32_t next = 0;
+        for (auto & index : indices)
+        {
+            if (remap[index] == unused)
+            {
+                remap[index] = next++;
+            }
+            index = remap[index];
+        }
+
+        for (auto & newIndex : remap)
+        {
+            if (newIndex == unused)
+            {
+                newIndex = next++;
+            }
+        }
+
+        return remap;
+    }
+}
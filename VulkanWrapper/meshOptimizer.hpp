@@ -0,0 +1,97 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "vertex.hpp"
+
+namespace vw::scene
+{
+    // How well an index list uses the post-transform vertex cache, simulated as a FIFO of cacheSize vertices
+    struct VertexCacheStatistics
+    {
+        // Average cache miss ratio, vertices transformed per triangle. 3 at worst, around 0.6 for well ordered meshes.
+        float acmr = 0.f;
+        // Average transform to vertex ratio, vertices transformed per vertex used. 1 at best.
+        float atvr = 0.f;
+    };
+
+    // Fragments from rendering a mesh with a depth test, without knowing anything about the shading
+    struct OverdrawStatistics
+    {
+        // Fragments that passed the depth test per covered pixel. 1 at best, when every pixel is shaded once.
+        float overdraw = 0.f;
+        uint64_t covered = 0;
+        uint64_t shaded = 0;
+    };
+
+    struct MeshOptimizationStatistics
+    {
+        VertexCacheStatistics before;
+        VertexCacheStatistics after;
+    };
+
+    constexpr uint32_t k_defaultVertexCacheSize = 16;
+    constexpr float k_defaultOverdrawThreshold = 1.05f;
+    constexpr uint32_t k_defaultOverdrawViews = 16;
+    constexpr uint32_t k_defaultOverdrawResolution = 256;
+
+    VertexCacheStatistics analyzeVertexCache(const std::vector<uint32_t> & indices, const size_t numVertices, const uint32_t cacheSize = k_defaultVertexCacheSize);
+    // Reorders the triangles for the post-transform vertex cache with Tipsify (Sander, Nehab and Barczak 2007). The triangles
+    // are emitted in fans around one vertex at a time, the next one picked among the vertices of the current fan that are
+    // still in the cache. Runs in linear time, the triangles keep their winding.
+    void optimizeVertexCache(std::vector<uint32_t> & indices, const size_t numVertices, const uint32_t cacheSize = k_defaultVertexCacheSize);
+    // Reorders the triangles of an index list that is already optimized for the vertex cache to reduce overdraw (Sander, Nehab
+    // and Barczak 2007). The list is split into clusters wherever the cache starts over, and further wherever the part up to
+    // there already has an ACMR below threshold times the one of its cluster. The clusters are then drawn outermost first,
+    // sorted by how far their centroid lies in front of the center of the mesh along their normal, so they tend to occlude
+    // the clusters behind them from any direction. The triangles keep their order within a cluster, which limits the loss of
+    // cache efficiency to the threshold. Positions are read as glm::vec3 every positionStride bytes.
+    void optimizeOverdraw(std::vector<uint32_t> & indices, const glm::vec3 * positions, const size_t numVertices, const size_t positionStride, const uint32_t cacheSize = k_defaultVertexCacheSize, const float threshold = k_defaultOverdrawThreshold);
+    // Rasterizes the mesh on the CPU at resolution squared pixels with an orthographic view from numViews directions spread
+    // evenly over the sphere, with back faces culled (counter-clockwise triangles are front facing) and a less depth test, like
+    // the demos draw. The statistics are summed over all views.
+    OverdrawStatistics estimateOverdraw(const std::vector<uint32_t> & indices, const glm::vec3 * positions, const size_t numVertices, const size_t positionStride, const uint32_t numViews = k_defaultOverdrawViews, const uint32_t resolution = k_defaultOverdrawResolution);
+    // Renumbers the vertices in the order the indices first use them, unused vertices last, and returns the new number of each
+    // vertex. The indices are rewritten to the new numbers.
+    std::vector<uint32_t> remapIndicesForVertexFetch(std::vector<uint32_t> & indices, const size_t numVertices);
+
+    // Moves the vertices to first use order, so the vertex fetches of neighbouring triangles hit neighbouring memory
+    template<VertexDescription VD>
+    void optimizeVertexFetch(std::vector<Vertex<VD>> & vertices, std::vector<uint32_t> & indices)
+    {
+        const auto remap{ remapIndicesForVertexFetch(indices, vertices.size()) };
+        std::vector<Vertex<VD>> reordered(vertices.size());
+        for (size_t i = 0; i < vertices.size(); ++i)
+        {
+            reordered[remap[i]] = vertices[i];
+        }
+        vertices = std::move(reordered);
+    }
+
+    template<VertexDescription VD>
+    void optimizeOverdraw(const std::vector<Vertex<VD>> & vertices, std::vector<uint32_t> & indices, const uint32_t cacheSize = k_defaultVertexCacheSize, const float threshold = k_defaultOverdrawThreshold)
+    {
+        optimizeOverdraw(indices, vertices.empty() ? nullptr : &vertices[0].pos, vertices.size(), sizeof(Vertex<VD>), cacheSize, threshold);
+    }
+
+    template<VertexDescription VD>
+    OverdrawStatistics estimateOverdraw(const std::vector<Vertex<VD>> & vertices, const std::vector<uint32_t> & indices, const uint32_t numViews = k_defaultOverdrawViews, const uint32_t resolution = k_defaultOverdrawResolution)
+    {
+        return estimateOverdraw(indices, vertices.empty() ? nullptr : &vertices[0].pos, vertices.size(), sizeof(Vertex<VD>), numViews, resolution);
+    }
+
+    // Optimizes the triangle order for the vertex cache and for overdraw and then the vertex order for fetching, for example
+    // on the vectors passed to ModelRepository::addResource
+    template<VertexDescription VD>
+    MeshOptimizationStatistics optimizeMesh(std::vector<Vertex<VD>> & vertices, std::vector<uint32_t> & indices, const uint32_t cacheSize = k_defaultVertexCacheSize)
+    {
+        MeshOptimizationStatistics statistics;
+        statistics.before = analyzeVertexCache(indices, vertices.size(), cacheSize);
+        optimizeVertexCache(indices, vertices.size(), cacheSize);
+        optimizeOverdraw(vertices, indices, cacheSize);
+        optimizeVertexFetch(vertices, indices);
+        statistics.after = analyzeVertexCache(indices, vertices.size(), cacheSize);
+        return statistics;
+    }
+}
@@ -25,27 +25,27 @@ namespace vw::scene
     }
 
     template<VertexDescription VD>
-    void Model<VD>::createBuffers(const vk::UniqueDevice & device, const vk::PhysicalDevice & physicalDevice, const vk::UniqueCommandPool & commandPool, const vk::Queue & queue)
+    void Model<VD>::setMappedGeometry(util::MappedFile && file, const Vertex<VD> * vertices, const size_t numVertices, const uint32_t * indices, const size_t numIndices)
     {
-        const auto vertexBufferSize{ sizeof(m_vertices[0]) * m_vertices.size() };
-        const auto indexBufferSize{ sizeof(m_indices[0]) * m_indices.size() };
-
-        // Create & fill staging buffers & memories
-        vk::UniqueBuffer vertexStagingBuffer;
-        vk::UniqueDeviceMemory vertexStagingBufferMemory;
-        util::createBuffer(device, physicalDevice, vertexBufferSize, vk::BufferUsageFlagBits::eTransferSrc, vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent, vertexStagingBuffer, vertexStagingBufferMemory);
-
-        auto * vertexData{ device->mapMemory(*vertexStagingBufferMemory, 0, vertexBufferSize, {}) };
-        memcpy(vertexData, m_vertices.data(), static_cast<size_t>(vertexBufferSize));
-        device->unmapMemory(*vertexStagingBufferMemory);
-
-        vk::UniqueBuffer indexStagingBuffer;
-        vk::UniqueDeviceMemory indexStagingBufferMemory;
-        util::createBuffer(device, physicalDevice, indexBufferSize, vk::BufferUsageFlagBits::eTransferSrc, vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent, indexStagingBuffer, indexStagingBufferMemory);
+        m_vertices.clear();
+        m_indices.clear();
+        m_mappedFile = std::move(file);
+        m_mappedVertices = vertices;
+        m_numMappedVertices = numVertices;
+        m_mappedIndices = indices;
+        m_numMappedIndices = numIndices;
+    }
 
-        auto * indexData{ device->mapMemory(*indexStagingBufferMemory, 0, indexBufferSize, {}) };
-        memcpy(indexData, m_indices.data(), static_cast<size_t>(indexBufferSize));
-        device->unmapMemory(*indexStagingBufferMemory);
+    template<VertexDescription VD>
+    void Model<VD>::createBuffers(const vk::UniqueDevice & device, util::MemoryAllocator & allocator, util::UploadBatcher & uploads)
+    {
+        const auto mapped{ hasMappedGeometry() };
+        const auto * vertices{ mapped ? m_mappedVertices : m_vertices.data() };
+        const auto * indices{ mapped ? m_mappedIndices : m_indices.data() };
+        const auto numVertices{ mapped ? m_numMappedVertices : m_vertices.size() };
+        const auto numIndices{ mapped ? m_numMappedIndices : m_indices.size() };
+        const auto vertexBufferSize{ sizeof(Vertex<VD>) * numVertices };
+        const auto indexBufferSize{ sizeof(uint32_t) * numIndices };
 
         // Get size & offset
         const auto vb = device->createBufferUnique({ {}, vertexBufferSize, vk::BufferUsageFlagBits::eTransferDst | vk::BufferUsageFlagBits::eVertexBuffer });
@@ -56,27 +56,22 @@ namespace vw::scene
         m_offset = vMemReq.size;
 
         // Create buffer & memory
-        util::createBuffer(device, physicalDevice, bufSize, vk::BufferUsageFlagBits::eTransferDst | vk::BufferUsageFlagBits::eVertexBuffer | vk::BufferUsageFlagBits::eIndexBuffer, vk::MemoryPropertyFlagBits::eDeviceLocal, m_buffer, m_bufferMemory);
+        util::createBuffer(device, allocator, bufSize, vk::BufferUsageFlagBits::eTransferDst | vk::BufferUsageFlagBits::eVertexBuffer | vk::BufferUsageFlagBits::eIndexBuffer, vk::MemoryPropertyFlagBits::eDeviceLocal, m_buffer, m_bufferAllocation, util::MemoryUsage::Geometry);
+
+        // Enqueue the copies, they are executed with the next submission of the batch
+        uploads.uploadBuffer(vertices, vertexBufferSize, m_buffer);
+        uploads.uploadBuffer(indices, indexBufferSize, m_buffer, m_offset);
+        m_indexCount = static_cast<uint32_t>(numIndices);
 
-        // Copy staging buffers into buffer
-        auto vec = device->allocateCommandBuffersUnique({ *commandPool, vk::CommandBufferLevel::ePrimary, 1 });
-        if (vec.size() != 1)
+        // The uploads are already copied into the staging ring
+        if (mapped)
         {
-            throw std::runtime_error("allocating single command buffer failed, created " + std::to_string(vec.size()) + " command buffers instead.");
+            m_mappedFile.reset();
+            m_mappedVertices = nullptr;
+            m_numMappedVertices = 0;
+            m_mappedIndices = nullptr;
+            m_numMappedIndices = 0;
         }
-        auto cmdBuffer{ std::move(vec[0]) };
-        cmdBuffer->begin({ vk::CommandBufferUsageFlagBits::eOneTimeSubmit });
-        cmdBuffer->copyBuffer(*vertexStagingBuffer, *m_buffer, { { 0, 0, vertexBufferSize } });
-        cmdBuffer->copyBuffer(*indexStagingBuffer, *m_buffer, { { 0, m_offset, indexBufferSize } });
-        cmdBuffer->end();
-        vk::CommandBuffer commandBuffers[] = { *cmdBuffer };
-        const vk::SubmitInfo info(0, nullptr, nullptr, 1, commandBuffers, 0, nullptr);
-        queue.submit(info, nullptr);
-        queue.waitIdle();
-
-        // Destroy staging buffers before staging memories
-        vertexStagingBuffer.reset(nullptr);
-        indexStagingBuffer.reset(nullptr);
     }
 
     template<VertexDescription VD>
@@ -92,7 +87,7 @@ namespace vw::scene
         vk::DeviceSize offsets = 0;
         commandBuffer->bindVertexBuffers(0, *m_buffer, offsets);
         commandBuffer->bindIndexBuffer(*m_buffer, m_offset, vk::IndexType::eUint32);
-        commandBuffer->drawIndexed(static_cast<uint32_t>(m_indices.size()), 1, 0, 0, 0);
+        commandBuffer->drawIndexed(m_indexCount, 1, 0, 0, 0);
     }
 
     template<VertexDescription VD>
@@ -106,7 +101,7 @@ namespace vw::scene
         {
             auto dynamicOffset = i * static_cast<uint32_t>(dynamicAlignment);
             commandBuffer->bindDescriptorSets(vk::PipelineBindPoint::eGraphics, *pipelineLayout, 0, *desciptorSet, dynamicOffset);
-            commandBuffer->drawIndexed(static_cast<uint32_t>(m_indices.size()), 1, 0, 0, 0);
+            commandBuffer->drawIndexed(m_indexCount, 1, 0, 0, 0);
         }
     }
 
@@ -114,7 +109,7 @@ namespace vw::scene
     void Model<VD>::reset()
     {
         m_buffer.reset(nullptr);
-        m_bufferMemory.reset(nullptr);
+        m_bufferAllocation.reset();
     }
 
     template class Model<VertexDescription::PositionNormalColorTexture>;
@@ -7,6 +7,9 @@
 
 #include <type_traits>
 
+#include "mappedFile.hpp"
+#include "memoryAllocator.hpp"
+#include "uploadBatcher.hpp"
 #include "vertex.hpp"
 
 namespace vw::scene
@@ -25,12 +28,19 @@ namespace vw::scene
         auto & getVertices() noexcept { return m_vertices; }
         const auto & getIndices() const noexcept { return m_indices; }
         auto & getIndices() noexcept { return m_indices; }
+        // Object space bounding sphere, center in xyz and radius in w
+        const auto & getBoundingSphere() const noexcept { return m_boundingSphere; }
+        void setBoundingSphere(const glm::vec4 & boundingSphere) noexcept { m_boundingSphere = boundingSphere; }
+        // Takes the vertices and indices from the mapped file instead of the vectors, which stay empty. The file is kept mapped
+        // until the buffers are created.
+        void setMappedGeometry(util::MappedFile && file, const Vertex<VD> * vertices, const size_t numVertices, const uint32_t * indices, const size_t numIndices);
+        bool hasMappedGeometry() const noexcept { return static_cast<bool>(m_mappedFile); }
 
         void translate(const glm::vec3 & translate);
         void scale(const glm::vec3 & scale);
         void rotate(const glm::vec3 & axis, const float radians);
 
-        void createBuffers(const vk::UniqueDevice & device, const vk::PhysicalDevice & physicalDevice, const vk::UniqueCommandPool & commandPool, const vk::Queue & queue);
+        void createBuffers(const vk::UniqueDevice & device, util::MemoryAllocator & allocator, util::UploadBatcher & uploads);
         void pushConstants(const vk::UniqueCommandBuffer & commandBuffer, const vk::UniquePipelineLayout & pipelineLayout) const;
         void draw(const vk::UniqueCommandBuffer & commandBuffer) const;
         void drawInstanced(const vk::UniqueCommandBuffer & commandBuffer, const vk::UniquePipelineLayout & pipelineLayout, const vk::UniqueDescriptorSet & desciptorSet, const uint32_t num, const size_t dynamicAlignment) const;
@@ -41,7 +51,14 @@ namespace vw::scene
 
         std::vector<Vertex<VD>> m_vertices;
         std::vector<uint32_t> m_indices;
-        vk::UniqueDeviceMemory m_bufferMemory;
+        util::MappedFile m_mappedFile;
+        const Vertex<VD> * m_mappedVertices = nullptr;
+        size_t m_numMappedVertices = 0;
+        const uint32_t * m_mappedIndices = nullptr;
+        size_t m_numMappedIndices = 0;
+        uint32_t m_indexCount = 0;
+        glm::vec4 m_boundingSphere{ 0.f };
+        util::UniqueAllocation m_bufferAllocation;
         vk::UniqueBuffer m_buffer;
         vk::DeviceSize m_offset = 0;
     };
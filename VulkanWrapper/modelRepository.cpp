@@ -2,111 +2,275 @@
 
 #include <glm/gtc/matrix_transform.inl>
 
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include "culling.hpp"
 #include "util.hpp"
 
 namespace vw::scene
 {
     template<VertexDescription VD>
-    ModelRepository<VD>::ModelRepository(const vk::UniqueDevice & device, const vk::PhysicalDevice & physicalDevice, const uint32_t maxInstances)
-        : m_dynamicAlignment{ calculateDynamicAlignment(physicalDevice.getProperties(), sizeof(glm::mat4)) },
-          m_bufferSize{ maxInstances * m_dynamicAlignment }
+    ModelRepository<VD>::ModelRepository(const vk::UniqueDevice & device, const vk::PhysicalDevice & physicalDevice, util::MemoryAllocator & allocator, const uint32_t initialInstances, const uint32_t framesInFlight, const util::InstanceFormat instanceFormat)
+        : m_freeSlot{ k_invalidIndex },
+          m_allFramesMask{ static_cast<uint8_t>((1u << framesInFlight) - 1) },
+          m_instanceFormat{ instanceFormat },
+          m_instanceStride{ util::getInstanceStride(instanceFormat) },
+          m_bufferSize{ 0 },
+          m_nonCoherentAtomSize{ physicalDevice.getProperties().limits.nonCoherentAtomSize },
+          m_drawIndirectFirstInstance{ physicalDevice.getFeatures().drawIndirectFirstInstance == VK_TRUE },
+          m_multiDrawIndirect{ physicalDevice.getFeatures().multiDrawIndirect == VK_TRUE },
+          m_maxDrawIndirectCount{ physicalDevice.getProperties().limits.maxDrawIndirectCount },
+          m_allocator{ &allocator }
     {
-        m_dynamicUniformBufferObject.model = static_cast<glm::mat4 *>(_aligned_malloc(m_bufferSize, m_dynamicAlignment));
-        if (m_dynamicUniformBufferObject.model == nullptr)
+        // Stale copies are tracked with one bit per frame
+        if (framesInFlight == 0 || framesInFlight > 8)
         {
-            throw std::runtime_error("model matrix pointer must not be null");
+            throw std::invalid_argument("frames in flight must be between 1 and 8");
         }
 
-        for (uint32_t i = 0; i < maxInstances; ++i)
+        m_geometry[k_vertexSpace].elementSize = sizeof(Vertex<VD>);
+        m_geometry[k_indexSpace].elementSize = sizeof(uint32_t);
+
+        growInstances(std::min(std::max(initialInstances, 1u), InstanceID::k_maxIndices));
+        m_frames.resize(framesInFlight);
+        for (auto & frame : m_frames)
         {
-            m_freeMatrixSpaces.emplace(i);
+            createInstanceBuffers(device, frame);
         }
-
-        // Create dynamic buffer
-        util::createBuffer(device, physicalDevice, m_bufferSize, vk::BufferUsageFlagBits::eUniformBuffer, vk::MemoryPropertyFlagBits::eHostVisible, m_dynamicUniformBuffer, m_dynamicUniformBufferMemory);
-
-        // Map dynamic buffer
-        m_mappedMemory = device->mapMemory(*m_dynamicUniformBufferMemory, 0, m_bufferSize, {});
     }
 
     template<VertexDescription VD>
     ModelRepository<VD>::~ModelRepository()
     {
-        _aligned_free(m_dynamicUniformBufferObject.model);
+        _aligned_free(m_instanceBufferObject.model);
+        _aligned_free(m_instanceBounds.x);
     }
 
     template<VertexDescription VD>
-    ModelResourceID ModelRepository<VD>::addResource(std::vector<Vertex<VD>> && vertices, std::vector<uint32_t> && indices, const vk::UniqueDevice & device, const vk::PhysicalDevice & physicalDevice, const vk::UniqueCommandPool & commandPool, const vk::Queue & queue)
+    ModelResourceID ModelRepository<VD>::addResource(std::vector<Vertex<VD>> && vertices, std::vector<uint32_t> && indices, const vk::UniqueDevice & device, util::MemoryAllocator & allocator, util::UploadBatcher & uploads)
     {
-        ModelResourceID id;
-        m_resourceIds.emplace(id);
-        m_resourceMap.emplace(id, ModelResource<VD>{ std::move(vertices), std::move(indices), device, physicalDevice, commandPool, queue });
-        m_dynamicOffsetMap.emplace(id, std::set<vk::DeviceSize>{});
-        m_instanceMap.emplace(id, std::vector<ModelID>{});
+        const auto id{ addResourceAsync(std::move(vertices), std::move(indices), device, allocator, uploads) };
+        uploads.wait(uploads.submit());
         return id;
     }
 
     template<VertexDescription VD>
-    ModelID ModelRepository<VD>::createInstance(const ModelResourceID & resourceId)
+    ModelResourceID ModelRepository<VD>::addResourceAsync(std::vector<Vertex<VD>> && vertices, std::vector<uint32_t> && indices, const vk::UniqueDevice & device, util::MemoryAllocator & allocator, util::UploadBatcher & uploads)
     {
-        const auto it{ m_resourceIds.find(resourceId) };
-        if (it == m_resourceIds.end())
+        if (indices.empty())
         {
-            throw std::invalid_argument("Model resource with this ID is not in repository");
+            throw std::invalid_argument("resource must have indices");
+        }
+
+        if (m_freeResources.empty() && m_resources.size() >= ModelResourceID::k_maxIndices)
+        {
+            throw std::runtime_error("too many resources");
+        }
+
+        // Vertex offsets are signed. Growing keeps the ranges in place, so the new geometry may have to go behind the end.
+        const auto vertexCount{ static_cast<uint32_t>(vertices.size()) };
+        const auto indexCount{ static_cast<uint32_t>(indices.size()) };
+        const auto vertexEnd{ m_geometry[k_vertexSpace].end };
+        const auto indexEnd{ m_geometry[k_indexSpace].end };
+        if (vertices.size() > static_cast<size_t>(std::numeric_limits<int32_t>::max() - vertexEnd) || indices.size() > static_cast<size_t>(std::numeric_limits<uint32_t>::max() - indexEnd))
+        {
+            throw std::runtime_error("shared geometry buffers are full");
+        }
+
+        auto vertexOffset{ allocateGeometry(k_vertexSpace, vertexCount) };
+        auto firstIndex{ allocateGeometry(k_indexSpace, indexCount) };
+        if (vertexOffset == k_invalidIndex || firstIndex == k_invalidIndex)
+        {
+            // Only the buffers without room are grown, the ranges taken from the other one stay valid
+            growGeometry(vertexOffset == k_invalidIndex ? vertexEnd + vertexCount : 0, firstIndex == k_invalidIndex ? indexEnd + indexCount : 0, device, allocator, uploads);
+            vertexOffset = vertexOffset == k_invalidIndex ? allocateGeometry(k_vertexSpace, vertexCount) : vertexOffset;
+            firstIndex = firstIndex == k_invalidIndex ? allocateGeometry(k_indexSpace, indexCount) : firstIndex;
+        }
+
+        // Reuse the slot of a removed resource, its instance range is empty and already in place
+        uint32_t index;
+        if (!m_freeResources.empty())
+        {
+            index = m_freeResources.back();
+            m_freeResources.pop_back();
+            m_resources[index] = ModelResource<VD>{ vertices, indices, firstIndex, static_cast<int32_t>(vertexOffset) };
+        }
+        else
+        {
+            index = static_cast<uint32_t>(m_resources.size());
+            m_resources.emplace_back(vertices, indices, firstIndex, static_cast<int32_t>(vertexOffset));
+            m_resourceGenerations.push_back(0);
+            m_resourceRanges.push_back({ m_numInstances, 0 });
+        }
+
+        // Enqueue the copies into the ranges taken for the resource. They are staged right away, the repository keeps no host copy.
+        const auto & resource{ m_resources[index] };
+        const std::array<const void *, 2> data{ vertices.data(), indices.data() };
+        for (uint32_t space = 0; space < m_geometry.size(); ++space)
+        {
+            const auto range{ getGeometryRange(resource, space) };
+            if (range.count > 0)
+            {
+                const auto & geometry{ m_geometry[space] };
+                uploads.uploadBuffer(data[space], geometry.elementSize * range.count, geometry.buffer, geometry.elementSize * range.offset);
+            }
         }
 
-        return addInstance(resourceId);
+        // The frames get larger indirect buffers with their next flush. Frames without any cannot be using them, they get theirs
+        // right away so that their descriptor sets can be written before the first flush.
+        if (m_resources.size() > m_drawCapacity)
+        {
+            m_drawCapacity = std::max(static_cast<uint32_t>(m_resources.size()), 2 * m_drawCapacity);
+        }
+
+        for (auto & frame : m_frames)
+        {
+            if (frame.drawCapacity == 0)
+            {
+                createIndirectBuffers(device, frame);
+            }
+        }
+
+        return { index, m_resourceGenerations[index] };
     }
 
     template<VertexDescription VD>
-    std::vector<ModelID> ModelRepository<VD>::createInstances(const ModelResourceID & resourceId, const uint32_t numInstances)
+    void ModelRepository<VD>::reserveGeometry(const uint32_t vertexCount, const uint32_t indexCount, const vk::UniqueDevice & device, util::MemoryAllocator & allocator, util::UploadBatcher & uploads)
     {
-        const auto it{ m_resourceIds.find(resourceId) };
-        if (it == m_resourceIds.end())
+        const auto growVertices{ vertexCount > m_geometry[k_vertexSpace].capacity };
+        const auto growIndices{ indexCount > m_geometry[k_indexSpace].capacity };
+        if (growVertices || growIndices)
         {
-            throw std::invalid_argument("Model resource with this ID is not in repository");
+            growGeometry(growVertices ? vertexCount : 0, growIndices ? indexCount : 0, device, allocator, uploads);
         }
+    }
 
-        std::vector<ModelID> vec;
-        for (uint32_t i = 0; i < numInstances; ++i)
+    template<VertexDescription VD>
+    void ModelRepository<VD>::removeResource(const ModelResourceID & id)
+    {
+        const auto index{ getResourceIndex(id) };
+
+        // Destroying the last instance of the range moves no other instance of it
+        const auto & range{ m_resourceRanges[index] };
+        while (range.count > 0)
+        {
+            const auto slotIndex{ m_denseToSlot[range.first + range.count - 1] };
+            destroyInstance({ slotIndex, m_instanceSlots[slotIndex].generation });
+        }
+
+        // A move in flight retires its destination once it completes
+        auto & resource{ m_resources[index] };
+        for (uint32_t space = 0; space < m_geometry.size(); ++space)
         {
-            vec.emplace_back(addInstance(resourceId));
+            retireGeometry(space, getGeometryRange(resource, space));
         }
 
-        return vec;
+        resource = ModelResource<VD>{ {}, {}, 0, 0 };
+        ++m_resourceGenerations[index];
+        m_freeResources.push_back(index);
     }
 
     template<VertexDescription VD>
-    void ModelRepository<VD>::destroyInstance(const ModelID & id)
+    bool ModelRepository<VD>::defragment(util::UploadBatcher & uploads, const std::chrono::microseconds budget)
     {
-        if (m_modelIds.find(id) == m_modelIds.end())
+        // The direct draw path records the geometry offsets into the command buffer
+        if (!m_drawIndirectFirstInstance)
         {
-            throw std::invalid_argument("modelrepository does not contain this modelID");
+            throw std::runtime_error("defragmentation requires drawIndirectFirstInstance");
         }
 
-        m_modelIds.erase(id);
-        const auto offset{ m_modelToOffsetMap[id] };
-        for (auto & pair : m_instanceMap)
+        const auto start{ std::chrono::steady_clock::now() };
+        finishMoves(uploads);
+        releaseRetiredGeometry();
+
+        // Alternate between the buffers, so neither waits for the other to be compact
+        const auto firstMove{ m_moves.size() };
+        while (std::chrono::steady_clock::now() - start < budget)
         {
-            const auto & resId{ pair.first };
-            auto & vec{ pair.second };
-            const auto it{ std::find(vec.begin(), vec.end(), id) };
-            if (it == vec.end())
+            const auto movedVertices{ startMove(k_vertexSpace, uploads) };
+            const auto movedIndices{ startMove(k_indexSpace, uploads) };
+            if (!movedVertices && !movedIndices)
             {
-                continue;
+                break;
             }
+        }
 
-            vec.erase(it);
-            m_dynamicOffsetMap.find(resId)->second.erase(offset);
+        if (m_moves.size() > firstMove)
+        {
+            const auto ticket{ uploads.submit() };
+            for (auto i = firstMove; i < m_moves.size(); ++i)
+            {
+                m_moves[i].ticket = ticket;
+            }
         }
 
-        m_modelToOffsetMap.erase(id);
-        const auto idx{ offset / m_dynamicAlignment };
-        m_freeMatrixSpaces.emplace(idx);
+        return !m_moves.empty();
     }
 
     template<VertexDescription VD>
-    void ModelRepository<VD>::destroyInstances(const std::vector<ModelID> & ids)
+    InstanceID ModelRepository<VD>::createInstance(const ModelResourceID & resourceId)
+    {
+        std::vector<InstanceID> ids;
+        addInstances(getResourceIndex(resourceId), 1, ids);
+        return ids.front();
+    }
+
+    template<VertexDescription VD>
+    std::vector<InstanceID> ModelRepository<VD>::createInstances(const ModelResourceID & resourceId, const uint32_t numInstances)
+    {
+        std::vector<InstanceID> ids;
+        ids.reserve(numInstances);
+        addInstances(getResourceIndex(resourceId), numInstances, ids);
+        return ids;
+    }
+
+    template<VertexDescription VD>
+    void ModelRepository<VD>::destroyInstance(const InstanceID & id)
+    {
+        const auto denseIndex{ getDenseIndex(id) };
+        const auto resourceIndex{ m_instanceResources[denseIndex] };
+
+        // Swap and pop inside the resource range
+        auto & range{ m_resourceRanges[resourceIndex] };
+        auto hole{ range.first + range.count - 1 };
+        if (denseIndex != hole)
+        {
+            moveInstance(hole, denseIndex);
+        }
+        --range.count;
+
+        // Close the gap by moving the last instance of every following range in front of it
+        for (auto r = resourceIndex + 1; r < m_resourceRanges.size(); ++r)
+        {
+            auto & nextRange{ m_resourceRanges[r] };
+            if (nextRange.count > 0)
+            {
+                const auto last{ nextRange.first + nextRange.count - 1 };
+                moveInstance(last, hole);
+                hole = last;
+            }
+            --nextRange.first;
+        }
+
+        --m_numInstances;
+        m_instanceBounds.radius[m_numInstances] = -std::numeric_limits<float>::infinity();
+
+        // Invalidate outstanding handles and put the slot back into the free list, unless its generation wrapped around
+        auto & slot{ m_instanceSlots[id.getIndex()] };
+        if (++slot.generation == 0)
+        {
+            slot.denseIndex = k_invalidIndex;
+        }
+        else
+        {
+            pushFreeSlot(id.getIndex());
+        }
+    }
+
+    template<VertexDescription VD>
+    void ModelRepository<VD>::destroyInstances(const std::vector<InstanceID> & ids)
     {
         for (const auto id : ids)
         {
@@ -115,118 +279,913 @@ namespace vw::scene
     }
 
     template<VertexDescription VD>
-    void ModelRepository<VD>::setModelMatrix(const ModelID id, const glm::mat4 & modelMatrix) const
+    void ModelRepository<VD>::setModelMatrix(const InstanceID id, const glm::mat4 & modelMatrix) const
     {
-        if (m_modelIds.find(id) == m_modelIds.end())
+        const auto denseIndex{ getDenseIndex(id) };
+        m_instanceBufferObject.model[denseIndex] = modelMatrix;
+        updateInstanceBounds(denseIndex);
+        packInstance(denseIndex);
+        markDirty(denseIndex);
+    }
+
+    template<VertexDescription VD>
+    void ModelRepository<VD>::translate(const InstanceID id, const glm::vec3 & translate) const
+    {
+        const auto denseIndex{ getDenseIndex(id) };
+        auto & modelMat{ m_instanceBufferObject.model[denseIndex] };
+        modelMat = glm::translate(modelMat, translate);
+        updateInstanceBounds(denseIndex);
+        packInstance(denseIndex);
+        markDirty(denseIndex);
+    }
+
+    template<VertexDescription VD>
+    void ModelRepository<VD>::scale(const InstanceID id, const glm::vec3 & scale) const
+    {
+        const auto denseIndex{ getDenseIndex(id) };
+        auto & modelMat{ m_instanceBufferObject.model[denseIndex] };
+        modelMat = glm::scale(modelMat, scale);
+        updateInstanceBounds(denseIndex);
+        packInstance(denseIndex);
+        markDirty(denseIndex);
+    }
+
+    template<VertexDescription VD>
+    void ModelRepository<VD>::rotate(const InstanceID id, const glm::vec3 & axis, const float radians)
+    {
+        const auto denseIndex{ getDenseIndex(id) };
+        auto & modelMat{ m_instanceBufferObject.model[denseIndex] };
+        modelMat = glm::rotate(modelMat, radians, axis);
+        updateInstanceBounds(denseIndex);
+        packInstance(denseIndex);
+        markDirty(denseIndex);
+    }
+
+    template<VertexDescription VD>
+    void ModelRepository<VD>::setTransforms(const std::vector<InstanceID> & ids, const util::TransformArrays & transforms)
+    {
+        m_transformIndices.resize(ids.size());
+        for (size_t i = 0; i < ids.size(); ++i)
         {
-            throw std::invalid_argument("modelrepository does not contain this modelID");
+            m_transformIndices[i] = getDenseIndex(ids[i]);
         }
 
-        const auto offset{ m_modelToOffsetMap.at(id) };
-        glm::mat4 * modelMat = reinterpret_cast<glm::mat4 *>((reinterpret_cast<uint64_t>(m_dynamicUniformBufferObject.model) + offset));
-        *modelMat = modelMatrix;
+        util::composeTransforms(transforms, ids.size(), m_transformIndices.data(), m_instanceBufferObject.model);
+
+        // The axis lengths of the composed matrices are the scale factors, so the radius needs no square roots. The packed
+        // layout takes the components as they are instead of extracting them from the matrices again.
+        const auto hasScale{ transforms.scaleX != nullptr && transforms.scaleY != nullptr && transforms.scaleZ != nullptr };
+        for (size_t i = 0; i < ids.size(); ++i)
+        {
+            const auto denseIndex{ m_transformIndices[i] };
+            const auto & localBounds{ m_resources[m_instanceResources[denseIndex]].getBoundingSphere() };
+            const glm::vec3 center{ m_instanceBufferObject.model[denseIndex] * glm::vec4(glm::vec3(localBounds), 1.f) };
+            const auto scale{ hasScale ? std::max(std::abs(transforms.scaleX[i]), std::max(std::abs(transforms.scaleY[i]), std::abs(transforms.scaleZ[i]))) : 1.f };
+            m_instanceBounds.x[denseIndex] = center.x;
+            m_instanceBounds.y[denseIndex] = center.y;
+            m_instanceBounds.z[denseIndex] = center.z;
+            m_instanceBounds.radius[denseIndex] = localBounds.w * scale;
+
+            if (m_instanceFormat == util::InstanceFormat::PositionRotationScale)
+            {
+                auto * packed{ reinterpret_cast<glm::vec4 *>(m_packedInstances.data() + denseIndex * m_instanceStride) };
+                packed[0] = glm::vec4(transforms.translationX[i], transforms.translationY[i], transforms.translationZ[i], scale);
+                packed[1] = glm::vec4(transforms.rotationX[i], transforms.rotationY[i], transforms.rotationZ[i], transforms.rotationW[i]);
+            }
+            else
+            {
+                packInstance(denseIndex);
+            }
+            markDirty(denseIndex);
+        }
     }
 
     template<VertexDescription VD>
-    void ModelRepository<VD>::translate(const ModelID id, const glm::vec3 & translate) const
+    vk::DescriptorBufferInfo ModelRepository<VD>::getDescriptorBufferInfo(const uint32_t frameIndex) const
     {
-        if (m_modelIds.find(id) == m_modelIds.end())
+        const auto & frame{ getFrame(frameIndex) };
+        return { *frame.instanceBuffer, 0, frame.capacity * m_instanceStride };
+    }
+
+    template<VertexDescription VD>
+    vk::WriteDescriptorSet ModelRepository<VD>::getWriteDescriptorSet(const vk::UniqueDescriptorSet & descriptorSet, const uint32_t binding, const vk::DescriptorBufferInfo & info) const
+    {
+        return { *descriptorSet, binding, 0, 1, vk::DescriptorType::eStorageBuffer, nullptr, &info };
+    }
+
+    template<VertexDescription VD>
+    bool ModelRepository<VD>::flushDynamicBuffer(const vk::UniqueDevice & device, const uint32_t frameIndex)
+    {
+        // Counts the frames, geometry the frames in flight may still draw is reused only afterwards
+        ++m_flushCount;
+        releaseRetiredGeometry();
+
+        // The device is done with the previous submission of this frame, so its buffers can be replaced right away. The new
+        // ones are filled from the host copy.
+        auto replaced{ false };
+        if (getFrame(frameIndex).capacity < m_instanceCapacity)
+        {
+            createInstanceBuffers(device, m_frames[frameIndex]);
+            m_uploadAllMask |= static_cast<uint8_t>(1u << frameIndex);
+            replaced = true;
+        }
+
+        if (getFrame(frameIndex).drawCapacity < m_drawCapacity)
         {
-            throw std::invalid_argument("modelrepository does not contain this modelID");
+            createIndirectBuffers(device, m_frames[frameIndex]);
+            replaced = true;
+        }
+
+        // A resource slot may have been reused since the last flush, so the bounds are written along with the commands
+        const auto & frame{ getFrame(frameIndex) };
+        for (size_t i = 0; i < m_resources.size(); ++i)
+        {
+            const auto & range{ m_resourceRanges[i] };
+            frame.mappedIndirectCommands[i] = m_resources[i].getDrawCommand(range.first, range.count);
+            frame.mappedBounds[i] = m_resources[i].getBoundingSphere();
+        }
+
+        // The instances of each resource are already contiguous, so only the instances changed since this copy was last
+        // written have to be uploaded
+        if (!m_culled)
+        {
+            collectDirtyInstances(frameIndex);
+            const void * instances{ m_instanceFormat == util::InstanceFormat::Matrix ? static_cast<const void *>(m_instanceBufferObject.model) : m_packedInstances.data() };
+
+            util::flushDirtyRanges(device, *frame.instanceBufferAllocation, instances, m_bufferSize, m_instanceStride, m_nonCoherentAtomSize, m_flushIndices);
+            util::flushDirtyRanges(device, *frame.instanceDrawIdBufferAllocation, m_instanceResources.data(), m_instanceCapacity * sizeof(uint32_t), sizeof(uint32_t), m_nonCoherentAtomSize, m_flushIndices);
+        }
+        else
+        {
+            // Culling packs the visible instances, which moves nearly all of them
+            auto * dst{ static_cast<uint8_t *>(frame.mappedInstances) };
+            uint32_t firstInstance = 0;
+            for (size_t i = 0; i < m_resources.size(); ++i)
+            {
+                const auto & range{ m_resourceRanges[i] };
+                auto packedIndex{ firstInstance };
+                for (auto denseIndex = range.first; denseIndex < range.first + range.count; ++denseIndex)
+                {
+                    if (m_visibility[denseIndex])
+                    {
+                        frame.mappedInstanceDrawIds[packedIndex++] = static_cast<uint32_t>(i);
+                        const auto * instance{ m_instanceFormat == util::InstanceFormat::Matrix ? reinterpret_cast<const uint8_t *>(&m_instanceBufferObject.model[denseIndex]) : &m_packedInstances[denseIndex * m_instanceStride] };
+                        std::copy(instance, instance + m_instanceStride, dst);
+                        dst += m_instanceStride;
+                    }
+                }
+
+                const auto instanceCount{ packedIndex - firstInstance };
+                frame.mappedIndirectCommands[i].instanceCount = instanceCount;
+                frame.mappedIndirectCommands[i].firstInstance = firstInstance;
+                firstInstance += instanceCount;
+            }
+
+            const auto & instances{ *frame.instanceBufferAllocation };
+            const auto & drawIds{ *frame.instanceDrawIdBufferAllocation };
+            const std::vector<vk::MappedMemoryRange> ranges{ { instances.memory, instances.offset, instances.size }, { drawIds.memory, drawIds.offset, drawIds.size } };
+            device->flushMappedMemoryRanges(ranges);
+            m_uploadAllMask |= static_cast<uint8_t>(1u << frameIndex);
         }
 
-        const auto offset{ m_modelToOffsetMap.at(id) };
-        glm::mat4 * modelMat = reinterpret_cast<glm::mat4 *>((reinterpret_cast<uint64_t>(m_dynamicUniformBufferObject.model) + offset));
-        *modelMat = glm::translate(*modelMat, translate);
+        if (frame.indirectBufferAllocation)
+        {
+            const auto & indirect{ *frame.indirectBufferAllocation };
+            device->flushMappedMemoryRanges(vk::MappedMemoryRange{ indirect.memory, indirect.offset, indirect.size });
+        }
+
+        return replaced;
     }
 
     template<VertexDescription VD>
-    void ModelRepository<VD>::scale(const ModelID id, const glm::vec3 & scale) const
+    void ModelRepository<VD>::draw(const vk::UniqueCommandBuffer & cmdBuffer, const vk::UniquePipelineLayout & pipelineLayout, const vk::UniqueDescriptorSet & descriptorSet, const uint32_t frameIndex) const
     {
-        if (m_modelIds.find(id) == m_modelIds.end())
+        if (m_resources.empty())
+        {
+            return;
+        }
+
+        cmdBuffer->bindDescriptorSets(vk::PipelineBindPoint::eGraphics, *pipelineLayout, 0, *descriptorSet, nullptr);
+        bindGeometry(cmdBuffer);
+
+        // Without drawIndirectFirstInstance the instance ranges have to be baked into the command buffer
+        if (!m_drawIndirectFirstInstance)
         {
-            throw std::invalid_argument("modelrepository does not contain this modelID");
+            for (size_t i = 0; i < m_resources.size(); ++i)
+            {
+                m_resources[i].draw(m_resourceRanges[i].first, m_resourceRanges[i].count, cmdBuffer);
+            }
+
+            return;
         }
 
-        const auto offset{ m_modelToOffsetMap.at(id) };
-        glm::mat4 * modelMat = reinterpret_cast<glm::mat4 *>((reinterpret_cast<uint64_t>(m_dynamicUniformBufferObject.model) + offset));
-        *modelMat = glm::scale(*modelMat, scale);
+        drawIndirect(cmdBuffer, getFrame(frameIndex).indirectBuffer);
     }
 
     template<VertexDescription VD>
-    void ModelRepository<VD>::rotate(const ModelID id, const glm::vec3 & axis, const float radians)
+    uint32_t ModelRepository<VD>::cull(const std::array<glm::vec4, 6> & frustumPlanes)
     {
-        if (m_modelIds.find(id) == m_modelIds.end())
+        // The direct draw path records the instance counts into the command buffer
+        if (!m_drawIndirectFirstInstance)
         {
-            throw std::invalid_argument("modelrepository does not contain this modelID");
+            throw std::runtime_error("cpu culling requires drawIndirectFirstInstance");
         }
 
-        const auto offset{ m_modelToOffsetMap.at(id) };
-        glm::mat4 * modelMat = reinterpret_cast<glm::mat4 *>((reinterpret_cast<uint64_t>(m_dynamicUniformBufferObject.model) + offset));
-        *modelMat = glm::rotate(*modelMat, radians, axis);
+        // Entries past the live instances have an infinite negative radius
+        m_culled = true;
+        const auto count{ (m_numInstances + util::k_cullBatchSize - 1) / util::k_cullBatchSize * util::k_cullBatchSize };
+        return static_cast<uint32_t>(util::cullSpheres(frustumPlanes, m_instanceBounds.x, m_instanceBounds.y, m_instanceBounds.z, m_instanceBounds.radius, count, m_visibility.data()));
     }
 
     template<VertexDescription VD>
-    vk::DescriptorBufferInfo ModelRepository<VD>::getDescriptorBufferInfo() const
+    void ModelRepository<VD>::resetCulling()
     {
-        return { *m_dynamicUniformBuffer, 0, sizeof(DynamicUniformBufferObject) };
+        m_culled = false;
+        std::fill(m_visibility.begin(), m_visibility.end(), static_cast<uint8_t>(1));
     }
 
     template<VertexDescription VD>
-    vk::WriteDescriptorSet ModelRepository<VD>::getWriteDescriptorSet(const vk::UniqueDescriptorSet & descriptorSet, const uint32_t binding, const vk::DescriptorBufferInfo & info) const
+    std::vector<vk::DescriptorBufferInfo> ModelRepository<VD>::getCullingDescriptorBufferInfos(const uint32_t frameIndex) const
+    {
+        const auto & frame{ getFrame(frameIndex) };
+        return {
+            { *frame.instanceBuffer, 0, frame.capacity * m_instanceStride },
+            { *frame.instanceDrawIdBuffer, 0, VK_WHOLE_SIZE },
+            { *frame.boundsBuffer, 0, VK_WHOLE_SIZE },
+            { *frame.indirectBuffer, 0, VK_WHOLE_SIZE },
+            { *frame.culledIndirectBuffer, 0, VK_WHOLE_SIZE },
+            { *frame.visibleInstanceBuffer, 0, frame.capacity * m_instanceStride }
+        };
+    }
+
+    template<VertexDescription VD>
+    vk::DescriptorBufferInfo ModelRepository<VD>::getVisibleInstanceDescriptorBufferInfo(const uint32_t frameIndex) const
+    {
+        const auto & frame{ getFrame(frameIndex) };
+        return { *frame.visibleInstanceBuffer, 0, frame.capacity * m_instanceStride };
+    }
+
+    template<VertexDescription VD>
+    void ModelRepository<VD>::cull(const vk::UniqueCommandBuffer & cmdBuffer, const vk::UniquePipelineLayout & pipelineLayout, const vk::UniqueDescriptorSet & descriptorSet, const uint32_t frameIndex) const
+    {
+        // Visible instances are compacted into the range of their resource, so the culled commands keep firstInstance
+        if (!m_drawIndirectFirstInstance)
+        {
+            throw std::runtime_error("gpu culling requires drawIndirectFirstInstance");
+        }
+
+        if (m_resources.empty())
+        {
+            return;
+        }
+
+        // The shader increments the instance counts, so start from zero
+        const auto & frame{ getFrame(frameIndex) };
+        cmdBuffer->fillBuffer(*frame.culledIndirectBuffer, 0, VK_WHOLE_SIZE, 0);
+        const vk::BufferMemoryBarrier clearBarrier{ vk::AccessFlagBits::eTransferWrite, vk::AccessFlagBits::eShaderRead | vk::AccessFlagBits::eShaderWrite, VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED, *frame.culledIndirectBuffer, 0, VK_WHOLE_SIZE };
+        cmdBuffer->pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eComputeShader, {}, nullptr, clearBarrier, nullptr);
+
+        const auto drawCount{ static_cast<uint32_t>(m_resources.size()) };
+        cmdBuffer->bindDescriptorSets(vk::PipelineBindPoint::eCompute, *pipelineLayout, 0, *descriptorSet, nullptr);
+        cmdBuffer->pushConstants(*pipelineLayout, vk::ShaderStageFlagBits::eCompute, 0, sizeof(drawCount), &drawCount);
+        cmdBuffer->dispatch((frame.capacity + k_cullWorkGroupSize - 1) / k_cullWorkGroupSize, 1, 1);
+
+        const std::vector<vk::BufferMemoryBarrier> cullBarriers{
+            { vk::AccessFlagBits::eShaderWrite, vk::AccessFlagBits::eIndirectCommandRead, VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED, *frame.culledIndirectBuffer, 0, VK_WHOLE_SIZE },
+            { vk::AccessFlagBits::eShaderWrite, vk::AccessFlagBits::eShaderRead, VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED, *frame.visibleInstanceBuffer, 0, frame.capacity * m_instanceStride }
+        };
+        cmdBuffer->pipelineBarrier(vk::PipelineStageFlagBits::eComputeShader, vk::PipelineStageFlagBits::eDrawIndirect | vk::PipelineStageFlagBits::eVertexShader, {}, nullptr, cullBarriers, nullptr);
+    }
+
+    template<VertexDescription VD>
+    void ModelRepository<VD>::drawCulled(const vk::UniqueCommandBuffer & cmdBuffer, const vk::UniquePipelineLayout & pipelineLayout, const vk::UniqueDescriptorSet & descriptorSet, const uint32_t frameIndex) const
     {
-        return { *descriptorSet, binding, 0, 1, vk::DescriptorType::eUniformBufferDynamic, nullptr, &info };
+        if (m_resources.empty())
+        {
+            return;
+        }
+
+        cmdBuffer->bindDescriptorSets(vk::PipelineBindPoint::eGraphics, *pipelineLayout, 0, *descriptorSet, nullptr);
+        bindGeometry(cmdBuffer);
+        drawIndirect(cmdBuffer, getFrame(frameIndex).culledIndirectBuffer);
     }
 
     template<VertexDescription VD>
-    void ModelRepository<VD>::flushDynamicBuffer(const vk::UniqueDevice & device) const
+    void ModelRepository<VD>::bindGeometry(const vk::UniqueCommandBuffer & cmdBuffer) const
     {
-        memcpy(m_mappedMemory, m_dynamicUniformBufferObject.model, m_bufferSize);
-        vk::MappedMemoryRange mmr{ *m_dynamicUniformBufferMemory, 0, m_bufferSize };
-        device->flushMappedMemoryRanges(mmr);
+        const vk::DeviceSize offset = 0;
+        cmdBuffer->bindVertexBuffers(0, *m_geometry[k_vertexSpace].buffer, offset);
+        cmdBuffer->bindIndexBuffer(*m_geometry[k_indexSpace].buffer, 0, vk::IndexType::eUint32);
     }
 
     template<VertexDescription VD>
-    void ModelRepository<VD>::draw(const vk::UniqueCommandBuffer & cmdBuffer, const vk::UniquePipelineLayout & pipelineLayout, const vk::UniqueDescriptorSet & descriptorSet) const
+    void ModelRepository<VD>::drawIndirect(const vk::UniqueCommandBuffer & cmdBuffer, const vk::UniqueBuffer & indirectBuffer) const
     {
-        for (const auto & resourcePair : m_resourceMap)
+        // The commands of all resources are consecutive, so with multiDrawIndirect one call draws them all
+        const auto drawCount{ static_cast<uint32_t>(m_resources.size()) };
+        if (m_multiDrawIndirect && drawCount <= m_maxDrawIndirectCount)
+        {
+            cmdBuffer->drawIndexedIndirect(*indirectBuffer, 0, drawCount, sizeof(vk::DrawIndexedIndirectCommand));
+            return;
+        }
+
+        for (uint32_t i = 0; i < drawCount; ++i)
         {
-            const auto id{ resourcePair.first };
-            const auto & resource{ resourcePair.second };
-            resource.draw(m_dynamicOffsetMap.at(id), cmdBuffer, pipelineLayout, descriptorSet);
+            cmdBuffer->drawIndexedIndirect(*indirectBuffer, i * sizeof(vk::DrawIndexedIndirectCommand), 1, sizeof(vk::DrawIndexedIndirectCommand));
         }
     }
 
     template<VertexDescription VD>
-    vk::DeviceSize ModelRepository<VD>::calculateDynamicAlignment(const vk::PhysicalDeviceProperties & properties, const vk::DeviceSize initialAlignment) const
+    void ModelRepository<VD>::createIndirectBuffers(const vk::UniqueDevice & device, FrameResources & frame) const
     {
-        const auto minUboAlignment = properties.limits.minUniformBufferOffsetAlignment;
-        return minUboAlignment > 0 ? (initialAlignment + minUboAlignment - 1) & ~(minUboAlignment - 1) : initialAlignment;
+        // One command and one bounding sphere per resource, both are written by the next flush
+        const auto commandsSize{ sizeof(vk::DrawIndexedIndirectCommand) * m_drawCapacity };
+        util::createBuffer(device, *m_allocator, commandsSize, vk::BufferUsageFlagBits::eIndirectBuffer | vk::BufferUsageFlagBits::eStorageBuffer, vk::MemoryPropertyFlagBits::eHostVisible, frame.indirectBuffer, frame.indirectBufferAllocation, util::MemoryUsage::Instances);
+        frame.mappedIndirectCommands = static_cast<vk::DrawIndexedIndirectCommand *>(frame.indirectBufferAllocation->mapped);
+
+        // The culling shader writes its commands with the same layout, they may be read back to check them
+        util::createBuffer(device, *m_allocator, commandsSize, vk::BufferUsageFlagBits::eIndirectBuffer | vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eTransferSrc | vk::BufferUsageFlagBits::eTransferDst, vk::MemoryPropertyFlagBits::eDeviceLocal, frame.culledIndirectBuffer, frame.culledIndirectBufferAllocation, util::MemoryUsage::Instances);
+
+        util::createBuffer(device, *m_allocator, sizeof(glm::vec4) * m_drawCapacity, vk::BufferUsageFlagBits::eStorageBuffer, vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent, frame.boundsBuffer, frame.boundsBufferAllocation, util::MemoryUsage::Instances);
+        frame.mappedBounds = static_cast<glm::vec4 *>(frame.boundsBufferAllocation->mapped);
+        frame.drawCapacity = m_drawCapacity;
     }
 
     template<VertexDescription VD>
-    ModelID ModelRepository<VD>::addInstance(const ModelResourceID & resourceId)
+    void ModelRepository<VD>::createInstanceBuffers(const vk::UniqueDevice & device, FrameResources & frame) const
     {
-        const ModelID modelId;
-        const auto idx = *m_freeMatrixSpaces.begin();
-        const auto dynamicOffset{ idx * m_dynamicAlignment };
+        // Instance buffers, indexed by gl_InstanceIndex in the vertex shader, and the culling buffers: the resource index of
+        // every packed instance and the compacted visible instances
+        const auto drawIdBufferSize{ m_instanceCapacity * sizeof(uint32_t) };
+        util::createBuffer(device, *m_allocator, m_bufferSize, vk::BufferUsageFlagBits::eStorageBuffer, vk::MemoryPropertyFlagBits::eHostVisible, frame.instanceBuffer, frame.instanceBufferAllocation, util::MemoryUsage::Instances);
+        frame.mappedInstances = frame.instanceBufferAllocation->mapped;
+        util::createBuffer(device, *m_allocator, drawIdBufferSize, vk::BufferUsageFlagBits::eStorageBuffer, vk::MemoryPropertyFlagBits::eHostVisible, frame.instanceDrawIdBuffer, frame.instanceDrawIdBufferAllocation, util::MemoryUsage::Instances);
+        frame.mappedInstanceDrawIds = static_cast<uint32_t *>(frame.instanceDrawIdBufferAllocation->mapped);
+        util::createBuffer(device, *m_allocator, m_bufferSize, vk::BufferUsageFlagBits::eStorageBuffer, vk::MemoryPropertyFlagBits::eDeviceLocal, frame.visibleInstanceBuffer, frame.visibleInstanceBufferAllocation, util::MemoryUsage::Instances);
+        frame.capacity = m_instanceCapacity;
+    }
 
-        m_modelIds.emplace(modelId);
+    template<VertexDescription VD>
+    void ModelRepository<VD>::growInstances(const uint32_t capacity)
+    {
+        // Only the host copy grows here, the buffers of each frame follow with its next flush
+        auto * model{ static_cast<glm::mat4 *>(_aligned_malloc(capacity * sizeof(glm::mat4), alignof(glm::mat4))) };
+        if (model == nullptr)
+        {
+            throw std::runtime_error("model matrix pointer must not be null");
+        }
 
-        // set initial matrix in dynamic UBO
-        glm::mat4 * modelMat = reinterpret_cast<glm::mat4 *>((reinterpret_cast<uint64_t>(m_dynamicUniformBufferObject.model) + dynamicOffset));
-        *modelMat = glm::mat4(1.f);
+        std::copy(m_instanceBufferObject.model, m_instanceBufferObject.model + m_numInstances, model);
+        _aligned_free(m_instanceBufferObject.model);
+        m_instanceBufferObject.model = model;
 
-        // set dynamic offset
-        m_modelToOffsetMap[modelId] = dynamicOffset;
-        m_dynamicOffsetMap[resourceId].emplace(dynamicOffset);
+        // Queue the new slots behind the free ones
+        const auto oldCapacity{ m_instanceCapacity };
+        m_instanceSlots.resize(capacity);
+        for (auto i = oldCapacity; i < capacity; ++i)
+        {
+            m_instanceSlots[i].generation = 0;
+            pushFreeSlot(i);
+        }
+        m_denseToSlot.resize(capacity);
+        m_instanceResources.resize(capacity);
+        m_dirtyMasks.resize(capacity, 0);
 
-        // set instanceId
-        m_instanceMap[resourceId].emplace_back(modelId);
+        // Pad the bounds to whole culling batches, unused entries are never visible
+        const auto boundsCount{ (capacity + util::k_cullBatchSize - 1) / util::k_cullBatchSize * util::k_cullBatchSize };
+        auto * bounds{ static_cast<float *>(_aligned_malloc(4 * boundsCount * sizeof(float), 32)) };
+        if (bounds == nullptr)
+        {
+            throw std::runtime_error("instance bounds pointer must not be null");
+        }
 
-        m_freeMatrixSpaces.erase(idx);
+        const InstanceBounds grown{ bounds, bounds + boundsCount, bounds + 2 * boundsCount, bounds + 3 * boundsCount };
+        const std::array<std::pair<float *, float *>, 4> components{ { { m_instanceBounds.x, grown.x }, { m_instanceBounds.y, grown.y }, { m_instanceBounds.z, grown.z }, { m_instanceBounds.radius, grown.radius } } };
+        for (const auto & [from, to] : components)
+        {
+            std::copy(from, from + m_instanceBoundsCount, to);
+            std::fill(to + m_instanceBoundsCount, to + boundsCount, 0.f);
+        }
+        std::fill(grown.radius + m_instanceBoundsCount, grown.radius + boundsCount, -std::numeric_limits<float>::infinity());
+
+        _aligned_free(m_instanceBounds.x);
+        m_instanceBounds = grown;
+        m_instanceBoundsCount = boundsCount;
+        m_visibility.resize(boundsCount, 1);
+
+        if (m_instanceFormat != util::InstanceFormat::Matrix)
+        {
+            m_packedInstances.resize(capacity * m_instanceStride);
+        }
+
+        m_instanceCapacity = capacity;
+        m_bufferSize = capacity * m_instanceStride;
+    }
+
+    template<VertexDescription VD>
+    void ModelRepository<VD>::pushFreeSlot(const uint32_t slotIndex)
+    {
+        m_instanceSlots[slotIndex].denseIndex = k_invalidIndex;
+        if (m_numFreeSlots == 0)
+        {
+            m_freeSlot = slotIndex;
+        }
+        else
+        {
+            m_instanceSlots[m_lastFreeSlot].denseIndex = slotIndex;
+        }
+        m_lastFreeSlot = slotIndex;
+        ++m_numFreeSlots;
+    }
+
+    template<VertexDescription VD>
+    void ModelRepository<VD>::growGeometry(const uint32_t vertexCount, const uint32_t indexCount, const vk::UniqueDevice & device, util::MemoryAllocator & allocator, util::UploadBatcher & uploads)
+    {
+        // Vertex offsets are signed
+        const std::array<uint32_t, 2> counts{ vertexCount, indexCount };
+        const std::array<uint32_t, 2> limits{ static_cast<uint32_t>(std::numeric_limits<int32_t>::max()), std::numeric_limits<uint32_t>::max() };
+        const std::array<vk::BufferUsageFlags, 2> usages{ vk::BufferUsageFlagBits::eVertexBuffer, vk::BufferUsageFlagBits::eIndexBuffer };
+        const auto firstRetired{ m_retiredGeometryBuffers.size() };
+        for (uint32_t space = 0; space < m_geometry.size(); ++space)
+        {
+            if (counts[space] == 0)
+            {
+                continue;
+            }
 
-        return modelId;
+            // Grow geometrically, so the buffers are copied only a few times while many resources are added
+            auto & geometry{ m_geometry[space] };
+            geometry.capacity = static_cast<uint32_t>(std::min<uint64_t>(std::max<uint64_t>(counts[space], 2ull * geometry.capacity), limits[space]));
+            RetiredGeometryBuffer retired{ std::move(geometry.allocation), std::move(geometry.buffer), m_flushCount + m_frames.size(), &uploads, 0 };
+            util::createBuffer(device, allocator, geometry.elementSize * geometry.capacity, vk::BufferUsageFlagBits::eTransferSrc | vk::BufferUsageFlagBits::eTransferDst | usages[space], vk::MemoryPropertyFlagBits::eDeviceLocal, geometry.buffer, geometry.allocation, util::MemoryUsage::Geometry);
+            if (!retired.buffer)
+            {
+                continue;
+            }
+
+            // The ranges keep their offsets, so only the geometry in use is copied: the resources and the destinations of the
+            // moves in flight. The copies run after the earlier uploads and moves into the old buffer.
+            std::vector<GeometryRange> ranges;
+            for (const auto & resource : m_resources)
+            {
+                ranges.push_back(getGeometryRange(resource, space));
+            }
+            for (const auto & move : m_moves)
+            {
+                if (move.space == space)
+                {
+                    ranges.push_back(move.destination);
+                }
+            }
+            std::sort(ranges.begin(), ranges.end(), [](const GeometryRange & lhs, const GeometryRange & rhs) { return lhs.offset < rhs.offset; });
+
+            std::vector<vk::BufferCopy> regions;
+            for (const auto & range : ranges)
+            {
+                if (range.count == 0)
+                {
+                    continue;
+                }
+
+                const auto offset{ geometry.elementSize * range.offset };
+                const auto size{ geometry.elementSize * range.count };
+                if (!regions.empty() && regions.back().srcOffset + regions.back().size == offset)
+                {
+                    regions.back().size += size;
+                }
+                else
+                {
+                    regions.emplace_back(offset, offset, size);
+                }
+            }
+
+            if (!regions.empty())
+            {
+                uploads.copyOwnedBuffer(retired.buffer, geometry.buffer, regions);
+            }
+
+            // The frames in flight keep drawing from the old buffer, it is destroyed once they have been flushed again and the
+            // copies have finished
+            m_retiredGeometryBuffers.push_back(std::move(retired));
+        }
+
+        if (m_retiredGeometryBuffers.size() > firstRetired)
+        {
+            const auto ticket{ uploads.submit() };
+            for (auto i = firstRetired; i < m_retiredGeometryBuffers.size(); ++i)
+            {
+                m_retiredGeometryBuffers[i].ticket = ticket;
+            }
+        }
+    }
+
+    template<VertexDescription VD>
+    typename ModelRepository<VD>::GeometryRange ModelRepository<VD>::getGeometryRange(const ModelResource<VD> & resource, const uint32_t space) const
+    {
+        if (space == k_vertexSpace)
+        {
+            return { static_cast<uint32_t>(resource.getVertexOffset()), resource.getVertexCount() };
+        }
+
+        return { resource.getFirstIndex(), resource.getIndexCount() };
+    }
+
+    template<VertexDescription VD>
+    void ModelRepository<VD>::setGeometryOffset(ModelResource<VD> & resource, const uint32_t space, const uint32_t offset) const
+    {
+        if (space == k_vertexSpace)
+        {
+            resource.setVertexOffset(static_cast<int32_t>(offset));
+        }
+        else
+        {
+            resource.setFirstIndex(offset);
+        }
+    }
+
+    template<VertexDescription VD>
+    uint32_t ModelRepository<VD>::allocateGeometry(const uint32_t space, const uint32_t count)
+    {
+        if (count == 0)
+        {
+            return 0;
+        }
+
+        // First fit, which keeps the end of the buffer free
+        auto & geometry{ m_geometry[space] };
+        for (auto hole = geometry.freeRanges.begin(); hole != geometry.freeRanges.end(); ++hole)
+        {
+            if (hole->count >= count)
+            {
+                const auto offset{ hole->offset };
+                hole->offset += count;
+                hole->count -= count;
+                if (hole->count == 0)
+                {
+                    geometry.freeRanges.erase(hole);
+                }
+
+                geometry.used += count;
+                return offset;
+            }
+        }
+
+        if (count > geometry.capacity - geometry.end)
+        {
+            return k_invalidIndex;
+        }
+
+        const auto offset{ geometry.end };
+        geometry.end += count;
+        geometry.used += count;
+        return offset;
+    }
+
+    template<VertexDescription VD>
+    void ModelRepository<VD>::freeGeometry(const uint32_t space, const GeometryRange & range)
+    {
+        auto & geometry{ m_geometry[space] };
+        auto & ranges{ geometry.freeRanges };
+        geometry.used -= range.count;
+
+        // Merge with the free neighbours
+        auto merged{ range };
+        auto next{ std::lower_bound(ranges.begin(), ranges.end(), range.offset, [](const GeometryRange & free, const uint32_t offset) { return free.offset < offset; }) };
+        if (next != ranges.end() && merged.offset + merged.count == next->offset)
+        {
+            merged.count += next->count;
+            next = ranges.erase(next);
+        }
+
+        if (next != ranges.begin() && std::prev(next)->offset + std::prev(next)->count == merged.offset)
+        {
+            merged.offset = std::prev(next)->offset;
+            merged.count += std::prev(next)->count;
+            next = ranges.erase(std::prev(next));
+        }
+
+        // The range in front of a free range is in use, so only the end moves
+        if (merged.offset + merged.count == geometry.end)
+        {
+            geometry.end = merged.offset;
+        }
+        else
+        {
+            ranges.insert(next, merged);
+        }
+    }
+
+    template<VertexDescription VD>
+    void ModelRepository<VD>::retireGeometry(const uint32_t space, const GeometryRange & range, const uint32_t extraFlushes)
+    {
+        // The frames flushed so far may still be in flight, each is waited for before its index is flushed again
+        if (range.count > 0)
+        {
+            m_retiredRanges.push_back({ space, range, m_flushCount + m_frames.size() + extraFlushes });
+        }
+    }
+
+    template<VertexDescription VD>
+    void ModelRepository<VD>::releaseRetiredGeometry()
+    {
+        // Ranges are retired in order, so the oldest are in front. One kept for an extra frame at most holds back the next ones.
+        auto retired{ m_retiredRanges.begin() };
+        for (; retired != m_retiredRanges.end() && retired->flushCount <= m_flushCount; ++retired)
+        {
+            freeGeometry(retired->space, retired->range);
+        }
+        m_retiredRanges.erase(m_retiredRanges.begin(), retired);
+
+        // So are the geometry buffers, whose copies complete in order as well
+        auto retiredBuffer{ m_retiredGeometryBuffers.begin() };
+        while (retiredBuffer != m_retiredGeometryBuffers.end() && retiredBuffer->flushCount <= m_flushCount && retiredBuffer->uploads->isFinished(retiredBuffer->ticket))
+        {
+            ++retiredBuffer;
+        }
+        m_retiredGeometryBuffers.erase(m_retiredGeometryBuffers.begin(), retiredBuffer);
+    }
+
+    template<VertexDescription VD>
+    void ModelRepository<VD>::finishMoves(util::UploadBatcher & uploads)
+    {
+        // Tickets complete in order
+        auto move{ m_moves.begin() };
+        for (; move != m_moves.end() && uploads.isComplete(move->ticket); ++move)
+        {
+            // The frames already in flight still draw from the source
+            if (m_resourceGenerations[move->resourceIndex] == move->generation)
+            {
+                // With a dedicated transfer queue the copy has only just been submitted with the acquires, possibly after the
+                // current frame, so the source is kept for one more frame
+                setGeometryOffset(m_resources[move->resourceIndex], move->space, move->destination.offset);
+                retireGeometry(move->space, move->source, uploads.usesTransferQueue() ? 1 : 0);
+            }
+            else
+            {
+                // The resource was removed while it moved and its source was retired then
+                retireGeometry(move->space, move->destination);
+            }
+        }
+        m_moves.erase(m_moves.begin(), move);
+    }
+
+    template<VertexDescription VD>
+    bool ModelRepository<VD>::startMove(const uint32_t space, util::UploadBatcher & uploads)
+    {
+        auto & geometry{ m_geometry[space] };
+        if (geometry.freeRanges.empty())
+        {
+            return false;
+        }
+
+        // The resources nearest to the end first, moving those is what lets the end shrink
+        std::vector<std::pair<uint32_t, uint32_t>> candidates;
+        for (uint32_t i = 0; i < m_resources.size(); ++i)
+        {
+            const auto range{ getGeometryRange(m_resources[i], space) };
+            const auto moving{ std::any_of(m_moves.begin(), m_moves.end(), [i, space](const GeometryMove & move) { return move.resourceIndex == i && move.space == space; }) };
+            if (range.count > 0 && !moving)
+            {
+                candidates.emplace_back(range.offset, i);
+            }
+        }
+        std::sort(candidates.rbegin(), candidates.rend());
+
+        for (const auto & [offset, index] : candidates)
+        {
+            // First fit among the holes in front of the resource, which never overlap it
+            const auto source{ getGeometryRange(m_resources[index], space) };
+            for (auto hole = geometry.freeRanges.begin(); hole != geometry.freeRanges.end() && hole->offset < offset; ++hole)
+            {
+                if (hole->count < source.count)
+                {
+                    continue;
+                }
+
+                const GeometryRange destination{ hole->offset, source.count };
+                hole->offset += source.count;
+                hole->count -= source.count;
+                if (hole->count == 0)
+                {
+                    geometry.freeRanges.erase(hole);
+                }
+                geometry.used += source.count;
+
+                uploads.copyOwnedBuffer(geometry.buffer, geometry.buffer, vk::BufferCopy{ geometry.elementSize * source.offset, geometry.elementSize * destination.offset, geometry.elementSize * source.count });
+
+                m_moves.push_back({ index, m_resourceGenerations[index], space, source, destination, 0 });
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    template<VertexDescription VD>
+    uint32_t ModelRepository<VD>::getResourceIndex(const ModelResourceID & id) const
+    {
+        if (id.getIndex() >= m_resources.size() || id.getGeneration() != m_resourceGenerations[id.getIndex()])
+        {
+            throw std::invalid_argument("Model resource with this ID is not in repository");
+        }
+
+        return id.getIndex();
+    }
+
+    template<VertexDescription VD>
+    uint32_t ModelRepository<VD>::getDenseIndex(const InstanceID & id) const
+    {
+        // Freeing a slot bumps its generation, so stale handles never match. A retired slot matches the very first handle again.
+        if (id.getIndex() >= m_instanceSlots.size() || m_instanceSlots[id.getIndex()].generation != id.getGeneration() || m_instanceSlots[id.getIndex()].denseIndex == k_invalidIndex)
+        {
+            throw std::invalid_argument("modelrepository does not contain this instanceID");
+        }
+
+        return m_instanceSlots[id.getIndex()].denseIndex;
+    }
+
+    template<VertexDescription VD>
+    void ModelRepository<VD>::addInstances(const uint32_t resourceIndex, const uint32_t numInstances, std::vector<InstanceID> & ids)
+    {
+        // Every instance slot needs an index that fits into a handle, retired slots are not reused
+        if (numInstances > m_numFreeSlots + (InstanceID::k_maxIndices - m_instanceCapacity))
+        {
+            throw std::runtime_error("too many instances");
+        }
+
+        // Doubling keeps the copies amortized constant per instance. There are never more free slots than free dense entries.
+        if (numInstances > m_numFreeSlots)
+        {
+            growInstances(std::min(std::max(m_instanceCapacity + numInstances - m_numFreeSlots, 2 * m_instanceCapacity), InstanceID::k_maxIndices));
+        }
+
+        // Shift every following range back by numInstances, moving at most numInstances instances per range
+        for (auto r = m_resourceRanges.size(); r-- > resourceIndex + 1;)
+        {
+            auto & range{ m_resourceRanges[r] };
+            const auto numMoved{ std::min(range.count, numInstances) };
+            const auto target{ range.first + std::max(range.count, numInstances) };
+            for (uint32_t i = 0; i < numMoved; ++i)
+            {
+                moveInstance(range.first + i, target + i);
+            }
+            range.first += numInstances;
+        }
+
+        auto & range{ m_resourceRanges[resourceIndex] };
+        const auto & localBounds{ m_resources[resourceIndex].getBoundingSphere() };
+        for (uint32_t i = 0; i < numInstances; ++i)
+        {
+            const auto denseIndex{ range.first + range.count++ };
+            const auto slotIndex{ m_freeSlot };
+            auto & slot{ m_instanceSlots[slotIndex] };
+            m_freeSlot = slot.denseIndex;
+            --m_numFreeSlots;
+            slot.denseIndex = denseIndex;
+
+            m_denseToSlot[denseIndex] = slotIndex;
+            m_instanceResources[denseIndex] = resourceIndex;
+            m_instanceBufferObject.model[denseIndex] = glm::mat4(1.f);
+            packInstance(denseIndex);
+            m_instanceBounds.x[denseIndex] = localBounds.x;
+            m_instanceBounds.y[denseIndex] = localBounds.y;
+            m_instanceBounds.z[denseIndex] = localBounds.z;
+            m_instanceBounds.radius[denseIndex] = localBounds.w;
+            m_visibility[denseIndex] = 1;
+            markDirty(denseIndex);
+            ids.emplace_back(slotIndex, slot.generation);
+        }
+
+        m_numInstances += numInstances;
+    }
+
+    template<VertexDescription VD>
+    void ModelRepository<VD>::moveInstance(const uint32_t from, const uint32_t to)
+    {
+        m_instanceBufferObject.model[to] = m_instanceBufferObject.model[from];
+        if (m_instanceFormat != util::InstanceFormat::Matrix)
+        {
+            std::copy_n(m_packedInstances.begin() + from * m_instanceStride, m_instanceStride, m_packedInstances.begin() + to * m_instanceStride);
+        }
+        m_instanceBounds.x[to] = m_instanceBounds.x[from];
+        m_instanceBounds.y[to] = m_instanceBounds.y[from];
+        m_instanceBounds.z[to] = m_instanceBounds.z[from];
+        m_instanceBounds.radius[to] = m_instanceBounds.radius[from];
+        m_visibility[to] = m_visibility[from];
+        m_instanceResources[to] = m_instanceResources[from];
+        m_denseToSlot[to] = m_denseToSlot[from];
+        m_instanceSlots[m_denseToSlot[to]].denseIndex = to;
+        markDirty(to);
+    }
+
+    template<VertexDescription VD>
+    void ModelRepository<VD>::markDirty(const uint32_t denseIndex) const
+    {
+        if (!m_dirtyMasks[denseIndex])
+        {
+            m_dirtyInstances.push_back(denseIndex);
+        }
+        m_dirtyMasks[denseIndex] = m_allFramesMask;
+    }
+
+    template<VertexDescription VD>
+    void ModelRepository<VD>::collectDirtyInstances(const uint32_t frameIndex) const
+    {
+        // Collects the live instances whose copy for this frame is stale into m_flushIndices, in ascending order. Instances stay
+        // in m_dirtyInstances until every frame has been flushed.
+        const auto frameBit{ static_cast<uint8_t>(1u << frameIndex) };
+        const auto uploadAll{ (m_uploadAllMask & frameBit) != 0 };
+        m_uploadAllMask &= ~frameBit;
+        m_flushIndices.clear();
+
+        // With many changes, scanning the masks in order is cheaper than sorting
+        if (uploadAll || m_dirtyInstances.size() > m_numInstances / 4)
+        {
+            for (const auto denseIndex : m_dirtyInstances)
+            {
+                if (denseIndex >= m_numInstances)
+                {
+                    m_dirtyMasks[denseIndex] = 0;
+                }
+            }
+
+            m_dirtyInstances.clear();
+            for (uint32_t i = 0; i < m_numInstances; ++i)
+            {
+                if (uploadAll || (m_dirtyMasks[i] & frameBit))
+                {
+                    m_flushIndices.push_back(i);
+                }
+
+                m_dirtyMasks[i] &= ~frameBit;
+                if (m_dirtyMasks[i])
+                {
+                    m_dirtyInstances.push_back(i);
+                }
+            }
+        }
+        else
+        {
+            std::sort(m_dirtyInstances.begin(), m_dirtyInstances.end());
+            auto kept{ m_dirtyInstances.begin() };
+            for (const auto denseIndex : m_dirtyInstances)
+            {
+                // Instances that were destroyed since need no upload
+                if (denseIndex >= m_numInstances)
+                {
+                    m_dirtyMasks[denseIndex] = 0;
+                    continue;
+                }
+
+                if (m_dirtyMasks[denseIndex] & frameBit)
+                {
+                    m_flushIndices.push_back(denseIndex);
+                    m_dirtyMasks[denseIndex] &= ~frameBit;
+                }
+
+                if (m_dirtyMasks[denseIndex])
+                {
+                    *kept++ = denseIndex;
+                }
+            }
+            m_dirtyInstances.erase(kept, m_dirtyInstances.end());
+        }
+    }
+
+    template<VertexDescription VD>
+    const typename ModelRepository<VD>::FrameResources & ModelRepository<VD>::getFrame(const uint32_t frameIndex) const
+    {
+        if (frameIndex >= m_frames.size())
+        {
+            throw std::invalid_argument("frame index exceeds the number of frames in flight");
+        }
+
+        return m_frames[frameIndex];
+    }
+
+    template<VertexDescription VD>
+    void ModelRepository<VD>::updateInstanceBounds(const uint32_t denseIndex) const
+    {
+        const auto & modelMat{ m_instanceBufferObject.model[denseIndex] };
+        const auto & localBounds{ m_resources[m_instanceResources[denseIndex]].getBoundingSphere() };
+
+        // Scale the radius by the largest axis scale, so the sphere stays conservative under non-uniform scaling
+        const glm::vec3 center{ modelMat * glm::vec4(glm::vec3(localBounds), 1.f) };
+        const auto scale{ std::max(glm::length(glm::vec3(modelMat[0])), std::max(glm::length(glm::vec3(modelMat[1])), glm::length(glm::vec3(modelMat[2])))) };
+        m_instanceBounds.x[denseIndex] = center.x;
+        m_instanceBounds.y[denseIndex] = center.y;
+        m_instanceBounds.z[denseIndex] = center.z;
+        m_instanceBounds.radius[denseIndex] = localBounds.w * scale;
+    }
+
+    template<VertexDescription VD>
+    void ModelRepository<VD>::packInstance(const uint32_t denseIndex) const
+    {
+        // Matrices are uploaded straight from the host copy, the other layouts are converted once per change
+        if (m_instanceFormat != util::InstanceFormat::Matrix)
+        {
+            util::packInstance(m_instanceFormat, m_instanceBufferObject.model[denseIndex], &m_packedInstances[denseIndex * m_instanceStride]);
+        }
     }
 
     template class ModelRepository<VertexDescription::NotUsed>;
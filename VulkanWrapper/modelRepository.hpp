@@ -1,13 +1,18 @@
 #pragma once
 
-#include "modelId.hpp"
+#include "instanceFormat.hpp"
+#include "instanceId.hpp"
+#include "memoryAllocator.hpp"
 #include "modelResource.hpp"
 #include "modelResourceId.hpp"
+#include "transform.hpp"
+#include "uploadBatcher.hpp"
 #include "vertex.hpp"
 
-#include <set>
-#include <unordered_set>
-#include <unordered_map>
+#include <array>
+#include <chrono>
+#include <limits>
+#include <vector>
 
 namespace vw::scene
 {
@@ -15,50 +20,256 @@ namespace vw::scene
     class ModelRepository
     {
     public:
-        ModelRepository(const vk::UniqueDevice & device, const vk::PhysicalDevice & physicalDevice, const uint32_t maxInstances);
+        // The instance data is buffered once per frame in flight, so the host can update one copy while the device reads the others.
+        // Every frame index passed to the methods below has to be smaller than framesInFlight.
+        // The instance storage starts with room for initialInstances and doubles whenever it runs out. The allocator has to
+        // outlive the repository. The instance buffers hold the transforms in instanceFormat, the host keeps full matrices.
+        ModelRepository(const vk::UniqueDevice & device, const vk::PhysicalDevice & physicalDevice, util::MemoryAllocator & allocator, const uint32_t initialInstances, const uint32_t framesInFlight = 1, const util::InstanceFormat instanceFormat = util::InstanceFormat::Matrix);
         ModelRepository(const ModelRepository &) = delete;
         ModelRepository(ModelRepository && other) = default;
         ModelRepository & operator=(const ModelRepository &) = delete;
         ModelRepository & operator=(ModelRepository && other) = default;
         ~ModelRepository();
 
-        ModelResourceID addResource(std::vector<Vertex<VD>> && vertices, std::vector<uint32_t> && indices, const vk::UniqueDevice & device, const vk::PhysicalDevice & physicalDevice, const vk::UniqueCommandPool & commandPool, const vk::Queue & queue);
-        ModelID createInstance(const ModelResourceID & resourceId);
-        std::vector<ModelID> createInstances(const ModelResourceID & resourceId, const uint32_t numInstances);
-        void destroyInstance(const ModelID & id);
-        void destroyInstances(const std::vector<ModelID> & ids);
+        // Submits the upload of the resource and waits for it
+        ModelResourceID addResource(std::vector<Vertex<VD>> && vertices, std::vector<uint32_t> && indices, const vk::UniqueDevice & device, util::MemoryAllocator & allocator, util::UploadBatcher & uploads);
+        // Only enqueues the upload, the resource may be drawn once the batch is submitted to the queue the draws go to
+        ModelResourceID addResourceAsync(std::vector<Vertex<VD>> && vertices, std::vector<uint32_t> && indices, const vk::UniqueDevice & device, util::MemoryAllocator & allocator, util::UploadBatcher & uploads);
+        // All resources share one vertex and one index buffer. Growing them copies the geometry into larger buffers on the device
+        // without waiting for it, the ranges keep their offsets; reserving the total geometry up front saves the copies. The old
+        // buffers are kept until the frames in flight have been flushed again and the copies have finished, command buffers
+        // binding them have to be recorded again by then. With a dedicated transfer queue the copies run with the acquires of the
+        // batch, so like a new resource the grown buffers may be drawn from once its ticket has completed. The batcher has to
+        // outlive the old buffers.
+        void reserveGeometry(const uint32_t vertexCount, const uint32_t indexCount, const vk::UniqueDevice & device, util::MemoryAllocator & allocator, util::UploadBatcher & uploads);
+        // Destroys the instances of the resource and frees its geometry. The geometry is reused only once the frames in flight
+        // that may still draw it have been flushed again, flushDynamicBuffer() returns it to the free ranges.
+        void removeResource(const ModelResourceID & id);
+        // Incrementally compacts the shared buffers by moving the resources at their ends into holes further down. Called once
+        // per frame with the batcher the resources were added with: completed moves are applied to the draw commands and new
+        // moves are enqueued until the budget is used up, the call never waits for the device. The moves are copies inside the
+        // buffers, a dedicated transfer queue does not own the geometry, so they then run with the acquires of the batch. Returns
+        // whether moves are still in flight.
+        bool defragment(util::UploadBatcher & uploads, const std::chrono::microseconds budget);
+        // Instances are kept sorted by resource, so creating or destroying one shifts an instance of every following resource:
+        // the cost is O(number of resources) per instance.
+        InstanceID createInstance(const ModelResourceID & resourceId);
+        std::vector<InstanceID> createInstances(const ModelResourceID & resourceId, const uint32_t numInstances);
+        void destroyInstance(const InstanceID & id);
+        void destroyInstances(const std::vector<InstanceID> & ids);
 
-        void setModelMatrix(const ModelID id, const glm::mat4 & modelMatrix) const;
-        void translate(const ModelID id, const glm::vec3 & translate) const;
-        void scale(const ModelID id, const glm::vec3 & scale) const;
-        void rotate(const ModelID id, const glm::vec3 & axis, const float radians);
+        void setModelMatrix(const InstanceID id, const glm::mat4 & modelMatrix) const;
+        void translate(const InstanceID id, const glm::vec3 & translate) const;
+        void scale(const InstanceID id, const glm::vec3 & scale) const;
+        void rotate(const InstanceID id, const glm::vec3 & axis, const float radians);
+        // Composes the model matrices of many instances at once, the component arrays hold one entry per id. With the
+        // PositionRotationScale format the components are stored as they are, the matrix setters convert their matrices.
+        void setTransforms(const std::vector<InstanceID> & ids, const util::TransformArrays & transforms);
 
-        vk::DescriptorBufferInfo getDescriptorBufferInfo() const;
+        auto getFramesInFlight() const noexcept { return static_cast<uint32_t>(m_frames.size()); }
+        auto getInstanceFormat() const noexcept { return m_instanceFormat; }
+        vk::DescriptorBufferInfo getDescriptorBufferInfo(const uint32_t frameIndex) const;
         vk::WriteDescriptorSet getWriteDescriptorSet(const vk::UniqueDescriptorSet & descriptorSet, const uint32_t binding, const vk::DescriptorBufferInfo & info) const;
 
-        void flushDynamicBuffer(const vk::UniqueDevice & device) const;
-        void draw(const vk::UniqueCommandBuffer & cmdBuffer, const vk::UniquePipelineLayout & pipelineLayout, const vk::UniqueDescriptorSet & descriptorSet) const;
+        // Uploads the instances changed since the last flush of this frame and the indirect draw commands. With indirect drawing, recorded
+        // command buffers stay valid when instances are created or destroyed; only adding a resource requires recording them again.
+        // Once the instance storage has grown or the resources have outgrown the indirect buffers, the first flush of every frame
+        // replaces the buffers of that frame, which is safe because the device has finished the frame's previous submission. It
+        // then returns true: the descriptor sets of the frame have to be written again and the command buffers using them recorded
+        // again before the next submission. Command buffers of a frame are recorded after its flush.
+        auto drawsIndirect() const noexcept { return m_drawIndirectFirstInstance; }
+        auto getInstanceCapacity() const noexcept { return m_instanceCapacity; }
+        bool flushDynamicBuffer(const vk::UniqueDevice & device, const uint32_t frameIndex);
+        void draw(const vk::UniqueCommandBuffer & cmdBuffer, const vk::UniquePipelineLayout & pipelineLayout, const vk::UniqueDescriptorSet & descriptorSet, const uint32_t frameIndex) const;
+
+        // CPU frustum culling. Instances whose bounding sphere lies outside the planes are left out by the following flushes,
+        // until the next cull() or resetCulling(). Returns the number of visible instances.
+        uint32_t cull(const std::array<glm::vec4, 6> & frustumPlanes);
+        void resetCulling();
+
+        // GPU frustum culling. The culling shader reads the instance matrices, the instance draw ids, the resource bounding
+        // spheres and the indirect commands, and writes the visible instances and their commands (bindings 1 to 6, in this
+        // order). Both instance buffers use the instance format. drawCulled() expects the visible instance buffer in place of
+        // the instance buffer.
+        static const uint32_t k_cullWorkGroupSize = 64;
+        std::vector<vk::DescriptorBufferInfo> getCullingDescriptorBufferInfos(const uint32_t frameIndex) const;
+        vk::DescriptorBufferInfo getVisibleInstanceDescriptorBufferInfo(const uint32_t frameIndex) const;
+        void cull(const vk::UniqueCommandBuffer & cmdBuffer, const vk::UniquePipelineLayout & pipelineLayout, const vk::UniqueDescriptorSet & descriptorSet, const uint32_t frameIndex) const;
+        void drawCulled(const vk::UniqueCommandBuffer & cmdBuffer, const vk::UniquePipelineLayout & pipelineLayout, const vk::UniqueDescriptorSet & descriptorSet, const uint32_t frameIndex) const;
     private:
-        struct DynamicUniformBufferObject
+        static const uint32_t k_invalidIndex = std::numeric_limits<uint32_t>::max();
+
+        // Instances live in a slot map: handles point at slots, slots point into the dense arrays below. The dense arrays
+        // hold the instances of each resource in one contiguous range, with the ranges in resource order.
+        struct InstanceSlot
+        {
+            uint32_t denseIndex; // next free slot while unused, k_invalidIndex once retired
+            uint8_t generation;
+        };
+
+        struct ResourceRange
+        {
+            uint32_t first;
+            uint32_t count;
+        };
+
+        // Removed resources keep their slot with empty geometry and no instances until a new resource reuses it
+        std::vector<ModelResource<VD>> m_resources;
+        std::vector<uint8_t> m_resourceGenerations;
+        std::vector<uint32_t> m_freeResources;
+
+        // Ranges of a shared buffer, in vertices or indices
+        struct GeometryRange
+        {
+            uint32_t offset;
+            uint32_t count;
+        };
+
+        static constexpr uint32_t k_vertexSpace = 0;
+        static constexpr uint32_t k_indexSpace = 1;
+        struct GeometrySpace
+        {
+            util::UniqueAllocation allocation;
+            vk::UniqueBuffer buffer;
+            vk::DeviceSize elementSize;
+            uint32_t capacity = 0;
+            uint32_t used = 0;
+            // Behind the last range in use, the free ranges below it are sorted by offset and never adjacent
+            uint32_t end = 0;
+            std::vector<GeometryRange> freeRanges;
+        };
+        std::array<GeometrySpace, 2> m_geometry;
+
+        // Ranges the frames in flight may still read, they are freed once flushCount has been reached
+        struct RetiredRange
+        {
+            uint32_t space;
+            GeometryRange range;
+            uint64_t flushCount;
+        };
+        std::vector<RetiredRange> m_retiredRanges;
+
+        // Buffers replaced by growing the geometry, the frames in flight may still draw from them until flushCount has been reached
+        // and the copies out of them are in the batch of the ticket
+        struct RetiredGeometryBuffer
+        {
+            util::UniqueAllocation allocation;
+            vk::UniqueBuffer buffer;
+            uint64_t flushCount;
+            util::UploadBatcher * uploads;
+            util::UploadBatcher::Ticket ticket;
+        };
+        std::vector<RetiredGeometryBuffer> m_retiredGeometryBuffers;
+
+        struct GeometryMove
+        {
+            uint32_t resourceIndex;
+            uint8_t generation;
+            uint32_t space;
+            GeometryRange source;
+            GeometryRange destination;
+            util::UploadBatcher::Ticket ticket;
+        };
+        std::vector<GeometryMove> m_moves;
+        mutable uint64_t m_flushCount = 0;
+        std::vector<ResourceRange> m_resourceRanges;
+        std::vector<InstanceSlot> m_instanceSlots;
+        // The free list is a queue, a freed slot is reused only after all other free slots. A slot whose generation would
+        // wrap around is retired for good, so a stale handle never aliases a live instance.
+        uint32_t m_freeSlot = 0;
+        uint32_t m_lastFreeSlot = 0;
+        uint32_t m_numFreeSlots = 0;
+        uint32_t m_numInstances = 0;
+        uint32_t m_instanceCapacity = 0;
+
+        struct InstanceBufferObject
         {
             glm::mat4 * model = nullptr;
-        } m_dynamicUniformBufferObject;
-
-        std::unordered_set<ModelResourceID, ModelResourceID::KeyHash> m_resourceIds;
-        std::unordered_set<ModelID, ModelID::KeyHash> m_modelIds;
-        std::unordered_map<ModelResourceID, ModelResource<VD>, ModelResourceID::KeyHash> m_resourceMap;
-        std::unordered_map<ModelResourceID, std::vector<ModelID>, ModelResourceID::KeyHash> m_instanceMap;
-        std::unordered_map<ModelID, vk::DeviceSize, ModelID::KeyHash> m_modelToOffsetMap;
-        std::unordered_map<ModelResourceID, std::set<vk::DeviceSize>, ModelResourceID::KeyHash> m_dynamicOffsetMap;
-        std::set<vk::DeviceSize> m_freeMatrixSpaces;
-
-        vk::UniqueDeviceMemory m_dynamicUniformBufferMemory;
-        vk::UniqueBuffer m_dynamicUniformBuffer;
-        vk::DeviceSize m_dynamicAlignment;
+        } m_instanceBufferObject;
+        std::vector<uint32_t> m_denseToSlot;
+        std::vector<uint32_t> m_instanceResources;
+        std::vector<uint32_t> m_transformIndices;
+        // The instances in the layout of the instance buffers, written along with the matrices. Unused for full matrices.
+        mutable std::vector<uint8_t> m_packedInstances;
+
+        // Dense instances changed since the last flush of some frame, with one bit per frame whose copy is stale
+        mutable std::vector<uint32_t> m_dirtyInstances;
+        mutable std::vector<uint8_t> m_dirtyMasks;
+        mutable std::vector<uint32_t> m_flushIndices;
+        mutable uint8_t m_uploadAllMask = 0;
+        uint8_t m_allFramesMask;
+
+        // World space bounding spheres per dense instance, laid out for util::cullSpheres
+        struct InstanceBounds
+        {
+            float * x = nullptr;
+            float * y = nullptr;
+            float * z = nullptr;
+            float * radius = nullptr;
+        } m_instanceBounds;
+        size_t m_instanceBoundsCount = 0;
+        std::vector<uint8_t> m_visibility;
+        bool m_culled = false;
+
+        util::InstanceFormat m_instanceFormat;
+        vk::DeviceSize m_instanceStride;
         vk::DeviceSize m_bufferSize;
-        void * m_mappedMemory;
+        vk::DeviceSize m_nonCoherentAtomSize;
+        bool m_drawIndirectFirstInstance;
+        bool m_multiDrawIndirect;
+        uint32_t m_maxDrawIndirectCount;
+
+        // Instance data written by the host or by the culling shader, one copy per frame in flight. The instance buffers of a
+        // frame may be smaller than the host copy until its next flush.
+        struct FrameResources
+        {
+            uint32_t capacity = 0;
+            util::UniqueAllocation instanceBufferAllocation;
+            vk::UniqueBuffer instanceBuffer;
+            void * mappedInstances = nullptr;
+            util::UniqueAllocation instanceDrawIdBufferAllocation;
+            vk::UniqueBuffer instanceDrawIdBuffer;
+            uint32_t * mappedInstanceDrawIds = nullptr;
+            util::UniqueAllocation indirectBufferAllocation;
+            vk::UniqueBuffer indirectBuffer;
+            vk::DrawIndexedIndirectCommand * mappedIndirectCommands = nullptr;
+            util::UniqueAllocation visibleInstanceBufferAllocation;
+            vk::UniqueBuffer visibleInstanceBuffer;
+            util::UniqueAllocation culledIndirectBufferAllocation;
+            vk::UniqueBuffer culledIndirectBuffer;
+            // The indirect, culled indirect and bounds buffers hold drawCapacity resources
+            uint32_t drawCapacity = 0;
+            util::UniqueAllocation boundsBufferAllocation;
+            vk::UniqueBuffer boundsBuffer;
+            glm::vec4 * mappedBounds = nullptr;
+        };
+        std::vector<FrameResources> m_frames;
+        util::MemoryAllocator * m_allocator;
+        uint32_t m_drawCapacity = 0;
 
-        vk::DeviceSize calculateDynamicAlignment(const vk::PhysicalDeviceProperties & properties, const vk::DeviceSize initialAlignment) const;
-        ModelID addInstance(const ModelResourceID & resourceId);
+        void createIndirectBuffers(const vk::UniqueDevice & device, FrameResources & frame) const;
+        void createInstanceBuffers(const vk::UniqueDevice & device, FrameResources & frame) const;
+        void growInstances(const uint32_t capacity);
+        void pushFreeSlot(const uint32_t slotIndex);
+        void growGeometry(const uint32_t vertexCount, const uint32_t indexCount, const vk::UniqueDevice & device, util::MemoryAllocator & allocator, util::UploadBatcher & uploads);
+        GeometryRange getGeometryRange(const ModelResource<VD> & resource, const uint32_t space) const;
+        void setGeometryOffset(ModelResource<VD> & resource, const uint32_t space, const uint32_t offset) const;
+        uint32_t allocateGeometry(const uint32_t space, const uint32_t count);
+        void freeGeometry(const uint32_t space, const GeometryRange & range);
+        void retireGeometry(const uint32_t space, const GeometryRange & range, const uint32_t extraFlushes = 0);
+        void releaseRetiredGeometry();
+        void finishMoves(util::UploadBatcher & uploads);
+        bool startMove(const uint32_t space, util::UploadBatcher & uploads);
+        void bindGeometry(const vk::UniqueCommandBuffer & cmdBuffer) const;
+        void drawIndirect(const vk::UniqueCommandBuffer & cmdBuffer, const vk::UniqueBuffer & indirectBuffer) const;
+        uint32_t getResourceIndex(const ModelResourceID & id) const;
+        uint32_t getDenseIndex(const InstanceID & id) const;
+        void addInstances(const uint32_t resourceIndex, const uint32_t numInstances, std::vector<InstanceID> & ids);
+        void moveInstance(const uint32_t from, const uint32_t to);
+        void updateInstanceBounds(const uint32_t denseIndex) const;
+        void packInstance(const uint32_t denseIndex) const;
+        void markDirty(const uint32_t denseIndex) const;
+        void collectDirtyInstances(const uint32_t frameIndex) const;
+        const FrameResources & getFrame(const uint32_t frameIndex) const;
     };
 }
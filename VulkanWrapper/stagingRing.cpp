@@ -0,0 +1,138 @@
+#include "stagingRing.hpp"
+
+#include <limits>
+
+namespace vw::util
+{
+    StagingRing::StagingRing(const vk::UniqueDevice & device, MemoryAllocator & allocator, const vk::DeviceSize size)
+        : m_device{ *device },
+          m_allocator{ &allocator },
+          m_size{ (size + k_defaultAlignment - 1) / k_defaultAlignment * k_defaultAlignment }
+    {
+        if (size == 0)
+        {
+            throw std::invalid_argument("staging ring size must not be zero");
+        }
+
+        m_buffer = m_device.createBufferUnique({ {}, m_size, vk::BufferUsageFlagBits::eTransferSrc });
+        m_allocation = allocator.allocateBufferMemory(m_buffer, vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent, MemoryUsage::Staging);
+    }
+
+    StagingRing::~StagingRing()
+    {
+        // The regions must not be freed while the device still copies from them
+        waitIdle();
+    }
+
+    StagingRing::Region StagingRing::allocate(const vk::DeviceSize size, const vk::DeviceSize alignment)
+    {
+        if (size == 0)
+        {
+            throw std::invalid_argument("staging region size must not be zero");
+        }
+
+        // Release the submissions that have already completed
+        isComplete(0);
+
+        if (size > m_size)
+        {
+            DedicatedBuffer dedicated;
+            dedicated.buffer = m_device.createBufferUnique({ {}, size, vk::BufferUsageFlagBits::eTransferSrc });
+            dedicated.allocation = m_allocator->allocateBufferMemory(dedicated.buffer, vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent, MemoryUsage::Staging);
+            const Region region{ *dedicated.buffer, 0, size, dedicated.allocation->mapped };
+            m_dedicatedBuffers.emplace_back(std::move(dedicated));
+            return region;
+        }
+
+        while (true)
+        {
+            auto begin{ (m_head + alignment - 1) / alignment * alignment };
+            if (begin % m_size + size > m_size)
+            {
+                // Regions never wrap around, skip the rest of the ring instead
+                begin = (begin + m_size - 1) / m_size * m_size;
+            }
+
+            if (begin + size - m_tail <= m_size)
+            {
+                m_head = begin + size;
+                const auto offset{ begin % m_size };
+                return { *m_buffer, offset, size, static_cast<uint8_t *>(m_allocation->mapped) + offset };
+            }
+
+            if (m_submissions.empty())
+            {
+                throw std::runtime_error("staging ring is full, the pending uploads have to be submitted first");
+            }
+
+            retireOldest();
+        }
+    }
+
+    StagingRing::Region StagingRing::upload(const void * data, const vk::DeviceSize size, const vk::DeviceSize alignment)
+    {
+        const auto region{ allocate(size, alignment) };
+        memcpy(region.mapped, data, static_cast<size_t>(size));
+        return region;
+    }
+
+    uint64_t StagingRing::submit(const vk::Queue & queue, vk::ArrayProxy<const vk::CommandBuffer> commandBuffers)
+    {
+        vk::UniqueFence fence;
+        if (!m_unusedFences.empty())
+        {
+            fence = std::move(m_unusedFences.back());
+            m_unusedFences.pop_back();
+        }
+        else
+        {
+            fence = m_device.createFenceUnique({});
+        }
+
+        const vk::SubmitInfo info{ 0, nullptr, nullptr, commandBuffers.size(), commandBuffers.data() };
+        queue.submit(info, *fence);
+
+        m_submissions.emplace_back(Submission{ std::move(fence), m_head, std::move(m_dedicatedBuffers) });
+        m_submittedHead = m_head;
+        m_dedicatedBuffers.clear();
+        return ++m_submitCount;
+    }
+
+    bool StagingRing::isComplete(const uint64_t ticket)
+    {
+        while (!m_submissions.empty() && m_device.getFenceStatus(*m_submissions.front().fence) == vk::Result::eSuccess)
+        {
+            retireOldest();
+        }
+
+        return ticket <= m_retireCount;
+    }
+
+    void StagingRing::wait(const uint64_t ticket)
+    {
+        while (m_retireCount < ticket && !m_submissions.empty())
+        {
+            retireOldest();
+        }
+    }
+
+    void StagingRing::waitIdle()
+    {
+        while (!m_submissions.empty())
+        {
+            retireOldest();
+        }
+    }
+
+    void StagingRing::retireOldest()
+    {
+        auto & submission{ m_submissions.front() };
+        m_device.waitForFences(*submission.fence, VK_TRUE, std::numeric_limits<uint64_t>::max());
+        m_device.resetFences(*submission.fence);
+
+        m_tail = submission.end;
+        ++m_retireCount;
+        m_unusedFences.emplace_back(std::move(submission.fence));
+        m_submissions.pop_front();
+    }
+}
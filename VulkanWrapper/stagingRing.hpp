@@ -0,0 +1,92 @@
+#pragma once
+
+#include <vulkan/vulkan.hpp>
+
+#include <deque>
+#include <type_traits>
+#include <vector>
+
+#include "memoryAllocator.hpp"
+
+namespace vw::util
+{
+    // A persistently mapped, host visible ring buffer all uploads are staged in. Regions are taken from the head of the ring
+    // and stay reserved until the submission copying from them has completed, which is tracked with one fence per submission.
+    // When the ring is full, taking a region waits for the oldest submission. Uploads larger than the ring get a buffer of
+    // their own, which is destroyed together with the submission.
+    class StagingRing
+    {
+    public:
+        static constexpr vk::DeviceSize k_defaultSize = 32 * 1024 * 1024;
+        // Satisfies the offset alignment of buffer copies and of buffer to image copies of up to 16 byte texels
+        static constexpr vk::DeviceSize k_defaultAlignment = 16;
+
+        struct Region
+        {
+            vk::Buffer buffer;
+            vk::DeviceSize offset;
+            vk::DeviceSize size;
+            void * mapped;
+        };
+
+        StagingRing(const vk::UniqueDevice & device, MemoryAllocator & allocator, const vk::DeviceSize size = k_defaultSize);
+        StagingRing(const StagingRing &) = delete;
+        StagingRing(StagingRing && other) = default;
+        StagingRing & operator=(const StagingRing &) = delete;
+        StagingRing & operator=(StagingRing && other) = default;
+        ~StagingRing();
+
+        // The region may be written until the commands reading it are passed to submit()
+        Region allocate(const vk::DeviceSize size, const vk::DeviceSize alignment = k_defaultAlignment);
+        Region upload(const void * data, const vk::DeviceSize size, const vk::DeviceSize alignment = k_defaultAlignment);
+        // Submits the command buffers reading the regions taken since the last submission. Returns the ticket of the
+        // submission, tickets count up from one and zero is always complete.
+        uint64_t submit(const vk::Queue & queue, vk::ArrayProxy<const vk::CommandBuffer> commandBuffers);
+        bool isComplete(const uint64_t ticket);
+        // Waits for the submission and all submissions before it
+        void wait(const uint64_t ticket);
+        // Waits for all submissions, afterwards the whole ring is free again
+        void waitIdle();
+
+        auto getSize() const noexcept { return m_size; }
+        // Bytes of the ring taken by regions that are not submitted yet, including alignment padding
+        auto getUnsubmittedSize() const noexcept { return m_head - m_submittedHead; }
+    private:
+        struct DedicatedBuffer
+        {
+            UniqueAllocation allocation;
+            vk::UniqueBuffer buffer;
+        };
+
+        struct Submission
+        {
+            vk::UniqueFence fence;
+            // Ring position behind the last region read by this submission
+            uint64_t end;
+            std::vector<DedicatedBuffer> dedicatedBuffers;
+        };
+
+        vk::Device m_device;
+        MemoryAllocator * m_allocator;
+        vk::DeviceSize m_size;
+        UniqueAllocation m_allocation;
+        vk::UniqueBuffer m_buffer;
+
+        // Positions grow monotonically, the offset into the ring is the position modulo its size
+        uint64_t m_head = 0;
+        uint64_t m_tail = 0;
+        uint64_t m_submittedHead = 0;
+        uint64_t m_submitCount = 0;
+        uint64_t m_retireCount = 0;
+        std::deque<Submission> m_submissions;
+        std::vector<DedicatedBuffer> m_dedicatedBuffers;
+        std::vector<vk::UniqueFence> m_unusedFences;
+
+        void retireOldest();
+    };
+
+    static_assert(std::is_move_constructible_v<StagingRing>);
+    static_assert(!std::is_copy_constructible_v<StagingRing>);
+    static_assert(std::is_move_assignable_v<StagingRing>);
+    static_assert(!std::is_copy_assignable_v<StagingRing>);
+}
@@ -0,0 +1,85 @@
+#include "transform.hpp"
+
+#include <xmmintrin.h>
+
+namespace vw::util
+{
+    void composeTransforms(const TransformArrays & transforms, const size_t count, const uint32_t * indices, glm::mat4 * matrices)
+    {
+        const auto & t{ transforms };
+        const auto hasScale{ t.scaleX != nullptr && t.scaleY != nullptr && t.scaleZ != nullptr };
+
+        size_t i = 0;
+        const auto one{ _mm_set1_ps(1.f) };
+        const auto two{ _mm_set1_ps(2.f) };
+        for (; i + 4 <= count; i += 4)
+        {
+            const auto qx{ _mm_loadu_ps(t.rotationX + i) };
+            const auto qy{ _mm_loadu_ps(t.rotationY + i) };
+            const auto qz{ _mm_loadu_ps(t.rotationZ + i) };
+            const auto qw{ _mm_loadu_ps(t.rotationW + i) };
+            const auto sx{ hasScale ? _mm_loadu_ps(t.scaleX + i) : one };
+            const auto sy{ hasScale ? _mm_loadu_ps(t.scaleY + i) : one };
+            const auto sz{ hasScale ? _mm_loadu_ps(t.scaleZ + i) : one };
+
+            const auto xx{ _mm_mul_ps(qx, qx) };
+            const auto yy{ _mm_mul_ps(qy, qy) };
+            const auto zz{ _mm_mul_ps(qz, qz) };
+            const auto xy{ _mm_mul_ps(qx, qy) };
+            const auto xz{ _mm_mul_ps(qx, qz) };
+            const auto yz{ _mm_mul_ps(qy, qz) };
+            const auto wx{ _mm_mul_ps(qw, qx) };
+            const auto wy{ _mm_mul_ps(qw, qy) };
+            const auto wz{ _mm_mul_ps(qw, qz) };
+
+            // m[column][row] holds one matrix element of the four objects, same layout as glm::mat4_cast
+            __m128 m[4][4];
+            m[0][0] = _mm_mul_ps(sx, _mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(yy, zz))));
+            m[0][1] = _mm_mul_ps(sx, _mm_mul_ps(two, _mm_add_ps(xy, wz)));
+            m[0][2] = _mm_mul_ps(sx, _mm_mul_ps(two, _mm_sub_ps(xz, wy)));
+            m[0][3] = _mm_setzero_ps();
+            m[1][0] = _mm_mul_ps(sy, _mm_mul_ps(two, _mm_sub_ps(xy, wz)));
+            m[1][1] = _mm_mul_ps(sy, _mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(xx, zz))));
+            m[1][2] = _mm_mul_ps(sy, _mm_mul_ps(two, _mm_add_ps(yz, wx)));
+            m[1][3] = _mm_setzero_ps();
+            m[2][0] = _mm_mul_ps(sz, _mm_mul_ps(two, _mm_add_ps(xz, wy)));
+            m[2][1] = _mm_mul_ps(sz, _mm_mul_ps(two, _mm_sub_ps(yz, wx)));
+            m[2][2] = _mm_mul_ps(sz, _mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(xx, yy))));
+            m[2][3] = _mm_setzero_ps();
+            m[3][0] = _mm_loadu_ps(t.translationX + i);
+            m[3][1] = _mm_loadu_ps(t.translationY + i);
+            m[3][2] = _mm_loadu_ps(t.translationZ + i);
+            m[3][3] = one;
+
+            // Transpose, so that m[column][k] holds the column of object k
+            for (auto & column : m)
+            {
+                _MM_TRANSPOSE4_PS(column[0], column[1], column[2], column[3]);
+            }
+
+            for (size_t k = 0; k < 4; ++k)
+            {
+                auto & matrix{ matrices[indices[i + k]] };
+                for (glm::length_t c = 0; c < 4; ++c)
+                {
+                    _mm_storeu_ps(&matrix[c][0], m[c][k]);
+                }
+            }
+        }
+
+        for (; i < count; ++i)
+        {
+            const auto x{ t.rotationX[i] };
+            const auto y{ t.rotationY[i] };
+            const auto z{ t.rotationZ[i] };
+            const auto w{ t.rotationW[i] };
+            const glm::vec3 s{ hasScale ? glm::vec3(t.scaleX[i], t.scaleY[i], t.scaleZ[i]) : glm::vec3(1.f) };
+
+            auto & matrix{ matrices[indices[i]] };
+            matrix[0] = glm::vec4(1.f - 2.f * (y * y + z * z), 2.f * (x * y + w * z), 2.f * (x * z - w * y), 0.f) * s.x;
+            matrix[1] = glm::vec4(2.f * (x * y - w * z), 1.f - 2.f * (x * x + z * z), 2.f * (y * z + w * x), 0.f) * s.y;
+            matrix[2] = glm::vec4(2.f * (x * z + w * y), 2.f * (y * z - w * x), 1.f - 2.f * (x * x + y * y), 0.f) * s.z;
+            matrix[3] = glm::vec4(t.translationX[i], t.translationY[i], t.translationZ[i], 1.f);
+        }
+    }
+}
@@ -0,0 +1,155 @@
+#include "transientAttachmentAllocator.hpp"
+
+#include <algorithm>
+#include <numeric>
+#include <stdexcept>
+
+namespace vw::util
+{
+    TransientAttachmentAllocator::TransientAttachmentAllocator(const vk::UniqueDevice & device, MemoryAllocator & allocator)
+        : m_device{ *device },
+          m_allocator{ &allocator }
+    {
+    }
+
+    TransientAttachmentAllocator::AttachmentId TransientAttachmentAllocator::addAttachment(const vk::Format format, const vk::Extent2D extent, const vk::ImageUsageFlags usage, const vk::ImageAspectFlags aspect, const uint32_t firstPass, const uint32_t lastPass, const vk::SampleCountFlagBits samples)
+    {
+        if (firstPass > lastPass)
+        {
+            throw std::invalid_argument("the first pass of an attachment must not come after its last pass");
+        }
+
+        // Only attachments that are never read outside of their render passes may be transient
+        const vk::ImageUsageFlags attachmentUsage{ vk::ImageUsageFlagBits::eColorAttachment | vk::ImageUsageFlagBits::eDepthStencilAttachment | vk::ImageUsageFlagBits::eInputAttachment };
+        const auto transient{ (usage & ~attachmentUsage) == vk::ImageUsageFlags{} };
+        const auto imageUsage{ transient ? usage | vk::ImageUsageFlagBits::eTransientAttachment : usage };
+
+        const vk::ImageCreateInfo info{ {}, vk::ImageType::e2D, format, { extent.width, extent.height, 1 }, 1, 1, samples, vk::ImageTiling::eOptimal, imageUsage, vk::SharingMode::eExclusive };
+        m_attachments.emplace_back(Attachment{ info, aspect, firstPass, lastPass, vk::UniqueImage{}, vk::UniqueImageView{} });
+        return static_cast<AttachmentId>(m_attachments.size() - 1);
+    }
+
+    void TransientAttachmentAllocator::build()
+    {
+        for (auto & attachment : m_attachments)
+        {
+            attachment.view.reset(nullptr);
+            attachment.image.reset(nullptr);
+            attachment.image = m_device.createImageUnique(attachment.info);
+        }
+
+        // The largest attachments pick their memory first, so the smaller ones fill in around them
+        std::vector<uint32_t> order(m_attachments.size());
+        std::iota(order.begin(), order.end(), 0);
+        std::vector<vk::MemoryRequirements> requirements(m_attachments.size());
+        for (uint32_t i = 0; i < m_attachments.size(); ++i)
+        {
+            requirements[i] = m_device.getImageMemoryRequirements(*m_attachments[i].image);
+        }
+
+        std::stable_sort(order.begin(), order.end(), [&](const auto a, const auto b) { return requirements[a].size > requirements[b].size; });
+
+        std::vector<MemorySlot> slots;
+        for (const auto index : order)
+        {
+            auto & attachment{ m_attachments[index] };
+            const auto & req{ requirements[index] };
+            auto properties{ vk::MemoryPropertyFlags{ vk::MemoryPropertyFlagBits::eDeviceLocal } };
+            if (attachment.info.usage & vk::ImageUsageFlagBits::eTransientAttachment && hasMemoryType(req.memoryTypeBits, properties | vk::MemoryPropertyFlagBits::eLazilyAllocated))
+            {
+                properties |= vk::MemoryPropertyFlagBits::eLazilyAllocated;
+            }
+
+            const auto slot{ std::find_if(slots.begin(), slots.end(), [&](const auto & s)
+            {
+                if (s.properties != properties || !hasMemoryType(s.requirements.memoryTypeBits & req.memoryTypeBits, properties))
+                {
+                    return false;
+                }
+
+                return std::none_of(s.attachments.begin(), s.attachments.end(), [&](const auto other)
+                {
+                    return m_attachments[other].firstPass <= attachment.lastPass && attachment.firstPass <= m_attachments[other].lastPass;
+                });
+            }) };
+
+            if (slot == slots.end())
+            {
+                attachment.memoryIndex = static_cast<uint32_t>(slots.size());
+                slots.emplace_back(MemorySlot{ req, properties, { index } });
+            }
+            else
+            {
+                attachment.memoryIndex = static_cast<uint32_t>(slot - slots.begin());
+                slot->requirements.size = std::max(slot->requirements.size, req.size);
+                slot->requirements.alignment = std::max(slot->requirements.alignment, req.alignment);
+                slot->requirements.memoryTypeBits &= req.memoryTypeBits;
+                slot->attachments.emplace_back(index);
+            }
+        }
+
+        m_memory.resize(slots.size());
+        for (uint32_t i = 0; i < slots.size(); ++i)
+        {
+            if (!fits(m_memory[i], slots[i]))
+            {
+                m_memory[i].reset();
+                m_memory[i] = m_allocator->allocate(slots[i].requirements, slots[i].properties, false, MemoryUsage::Attachment);
+            }
+        }
+
+        for (auto & attachment : m_attachments)
+        {
+            const auto & memory{ m_memory[attachment.memoryIndex] };
+            m_device.bindImageMemory(*attachment.image, memory->memory, memory->offset);
+
+            const vk::ImageViewCreateInfo viewInfo{ {}, *attachment.image, vk::ImageViewType::e2D, attachment.info.format, {}, { attachment.aspect, 0, 1, 0, 1 } };
+            attachment.view = m_device.createImageViewUnique(viewInfo);
+        }
+    }
+
+    void TransientAttachmentAllocator::clear()
+    {
+        m_attachments.clear();
+    }
+
+    void TransientAttachmentAllocator::release()
+    {
+        m_attachments.clear();
+        m_memory.clear();
+    }
+
+    bool TransientAttachmentAllocator::isLazilyAllocated(const AttachmentId id) const
+    {
+        const auto & memory{ m_memory.at(m_attachments.at(id).memoryIndex) };
+        return static_cast<bool>(m_allocator->getMemoryProperties().memoryTypes[memory->memoryTypeIndex].propertyFlags & vk::MemoryPropertyFlagBits::eLazilyAllocated);
+    }
+
+    bool TransientAttachmentAllocator::hasMemoryType(const uint32_t typeFilter, const vk::MemoryPropertyFlags properties) const
+    {
+        const auto & memoryProperties{ m_allocator->getMemoryProperties() };
+        for (uint32_t i = 0; i < memoryProperties.memoryTypeCount; ++i)
+        {
+            if (typeFilter & (1 << i) && (memoryProperties.memoryTypes[i].propertyFlags & properties) == properties)
+            {
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    bool TransientAttachmentAllocator::fits(const UniqueAllocation & allocation, const MemorySlot & slot) const
+    {
+        if (!allocation)
+        {
+            return false;
+        }
+
+        const auto flags{ m_allocator->getMemoryProperties().memoryTypes[allocation->memoryTypeIndex].propertyFlags };
+        return allocation->size >= slot.requirements.size
+            && allocation->offset % std::max(slot.requirements.alignment, vk::DeviceSize{ 1 }) == 0
+            && slot.requirements.memoryTypeBits & (1 << allocation->memoryTypeIndex)
+            && (flags & slot.properties) == slot.properties;
+    }
+}
@@ -0,0 +1,319 @@
+#include "uploadBatcher.hpp"
+
+#include <limits>
+
+namespace vw::util
+{
+    UploadBatcher::UploadBatcher(const vk::UniqueDevice & device, MemoryAllocator & allocator, const vk::Queue & queue, const uint32_t queueFamilyIndex, const vk::DeviceSize stagingSize)
+        : UploadBatcher{ device, allocator, queue, queueFamilyIndex, queue, queueFamilyIndex, stagingSize }
+    {
+    }
+
+    UploadBatcher::UploadBatcher(const vk::UniqueDevice & device, MemoryAllocator & allocator, const vk::Queue & queue, const uint32_t queueFamilyIndex, const vk::Queue & transferQueue, const uint32_t transferQueueFamilyIndex, const vk::DeviceSize stagingSize)
+        : m_device{ *device },
+          m_queue{ queue },
+          m_queueFamilyIndex{ queueFamilyIndex },
+          m_transferQueue{ transferQueue },
+          m_transferQueueFamilyIndex{ transferQueueFamilyIndex },
+          m_commandPool{ device->createCommandPoolUnique({ vk::CommandPoolCreateFlagBits::eTransient | vk::CommandPoolCreateFlagBits::eResetCommandBuffer, transferQueueFamilyIndex }) },
+          m_staging{ device, allocator, stagingSize }
+    {
+        if (usesTransferQueue())
+        {
+            m_acquireCommandPool = device->createCommandPoolUnique({ vk::CommandPoolCreateFlagBits::eTransient | vk::CommandPoolCreateFlagBits::eResetCommandBuffer, queueFamilyIndex });
+        }
+    }
+
+    UploadBatcher::~UploadBatcher()
+    {
+        // The command buffers must not be freed while they are executed
+        waitIdle();
+    }
+
+    void UploadBatcher::uploadBuffer(const void * data, const vk::DeviceSize size, const vk::UniqueBuffer & dstBuffer, const vk::DeviceSize dstOffset)
+    {
+        const auto region{ stage(data, size) };
+        getCommandBuffer().copyBuffer(region.buffer, *dstBuffer, vk::BufferCopy{ region.offset, dstOffset, size });
+        releaseBuffer(dstBuffer, dstOffset, size);
+    }
+
+    void UploadBatcher::uploadImage(const void * data, const vk::DeviceSize size, const vk::UniqueImage & dstImage, const uint32_t width, const uint32_t height, const vk::ImageLayout finalLayout)
+    {
+        const auto region{ stage(data, size) };
+        const auto commandBuffer{ getCommandBuffer() };
+        const vk::ImageSubresourceRange range{ vk::ImageAspectFlagBits::eColor, 0, 1, 0, 1 };
+
+        const vk::ImageMemoryBarrier toTransfer{ {}, vk::AccessFlagBits::eTransferWrite, vk::ImageLayout::eUndefined, vk::ImageLayout::eTransferDstOptimal, VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED, *dstImage, range };
+        commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eTopOfPipe, vk::PipelineStageFlagBits::eTransfer, {}, nullptr, nullptr, toTransfer);
+
+        const vk::BufferImageCopy copy{ region.offset, 0, 0, { vk::ImageAspectFlagBits::eColor, 0, 0, 1 }, {}, { width, height, 1 } };
+        commandBuffer.copyBufferToImage(region.buffer, *dstImage, vk::ImageLayout::eTransferDstOptimal, copy);
+
+        if (usesTransferQueue())
+        {
+            // The release and acquire barriers perform the transition
+            releaseImage(dstImage, vk::ImageLayout::eTransferDstOptimal, finalLayout);
+            return;
+        }
+
+        const vk::ImageMemoryBarrier toFinal{ vk::AccessFlagBits::eTransferWrite, vk::AccessFlagBits::eMemoryRead, vk::ImageLayout::eTransferDstOptimal, finalLayout, VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED, *dstImage, range };
+        commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eAllCommands, {}, nullptr, nullptr, toFinal);
+    }
+
+    void UploadBatcher::copyBuffer(const vk::UniqueBuffer & srcBuffer, const vk::UniqueBuffer & dstBuffer, const vk::DeviceSize size, const vk::DeviceSize srcOffset, const vk::DeviceSize dstOffset)
+    {
+        getCommandBuffer().copyBuffer(*srcBuffer, *dstBuffer, vk::BufferCopy{ srcOffset, dstOffset, size });
+        releaseBuffer(dstBuffer, dstOffset, size);
+    }
+
+    void UploadBatcher::copyOwnedBuffer(const vk::UniqueBuffer & srcBuffer, const vk::UniqueBuffer & dstBuffer, const vk::ArrayProxy<const vk::BufferCopy> regions)
+    {
+        // The batch is submitted even without transfers, its acquires run once it has completed
+        auto commandBuffer{ getCommandBuffer() };
+        if (usesTransferQueue())
+        {
+            if (!m_acquireCommandBuffer)
+            {
+                m_acquireCommandBuffer = beginCommandBuffer(m_acquireCommandPool, m_unusedAcquireCommandBuffers);
+            }
+            commandBuffer = *m_acquireCommandBuffer;
+        }
+
+        // The earlier copies may have written the source or read the destination
+        const vk::MemoryBarrier barrier{ vk::AccessFlagBits::eTransferWrite, vk::AccessFlagBits::eTransferRead | vk::AccessFlagBits::eTransferWrite };
+        commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eTransfer, {}, barrier, nullptr, nullptr);
+        commandBuffer.copyBuffer(*srcBuffer, *dstBuffer, regions);
+    }
+
+    void UploadBatcher::copyBufferToImage(const vk::UniqueBuffer & srcBuffer, const vk::UniqueImage & dstImage, const uint32_t width, const uint32_t height)
+    {
+        const vk::BufferImageCopy copy{ 0, 0, 0, { vk::ImageAspectFlagBits::eColor, 0, 0, 1 }, {}, { width, height, 1 } };
+        getCommandBuffer().copyBufferToImage(*srcBuffer, *dstImage, vk::ImageLayout::eTransferDstOptimal, copy);
+        releaseImage(dstImage, vk::ImageLayout::eTransferDstOptimal, vk::ImageLayout::eTransferDstOptimal);
+    }
+
+    vk::CommandBuffer UploadBatcher::getCommandBuffer()
+    {
+        if (!m_commandBuffer)
+        {
+            recycle();
+            m_commandBuffer = beginCommandBuffer(m_commandPool, m_unusedCommandBuffers);
+        }
+
+        return *m_commandBuffer;
+    }
+
+    UploadBatcher::Ticket UploadBatcher::submit()
+    {
+        if (!m_commandBuffer)
+        {
+            return m_lastTicket;
+        }
+
+        if (!usesTransferQueue())
+        {
+            // Later submissions on the queue see the uploaded data without waiting on the host
+            const vk::MemoryBarrier barrier{ vk::AccessFlagBits::eTransferWrite, vk::AccessFlagBits::eMemoryRead | vk::AccessFlagBits::eMemoryWrite };
+            m_commandBuffer->pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eAllCommands, {}, barrier, nullptr, nullptr);
+        }
+
+        m_commandBuffer->end();
+        if (m_acquireCommandBuffer)
+        {
+            // Later submissions on the queue also see the copies recorded with the acquires
+            const vk::MemoryBarrier barrier{ vk::AccessFlagBits::eTransferWrite, vk::AccessFlagBits::eMemoryRead | vk::AccessFlagBits::eMemoryWrite };
+            m_acquireCommandBuffer->pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eAllCommands, {}, barrier, nullptr, nullptr);
+            m_acquireCommandBuffer->end();
+        }
+
+        m_lastTicket = m_staging.submit(m_transferQueue, *m_commandBuffer);
+        m_batches.emplace_back(Batch{ m_lastTicket, std::move(m_commandBuffer), std::move(m_acquireCommandBuffer), vk::UniqueFence{} });
+        return m_lastTicket;
+    }
+
+    void UploadBatcher::acquire()
+    {
+        if (!usesTransferQueue())
+        {
+            return;
+        }
+
+        // Transfers complete in order, so the first one still running ends the search
+        for (auto & batch : m_batches)
+        {
+            if (batch.ticket <= m_acquiredTicket)
+            {
+                continue;
+            }
+
+            if (!m_staging.isComplete(batch.ticket))
+            {
+                break;
+            }
+
+            if (batch.acquireCommandBuffer)
+            {
+                if (!m_unusedFences.empty())
+                {
+                    batch.acquireFence = std::move(m_unusedFences.back());
+                    m_unusedFences.pop_back();
+                }
+                else
+                {
+                    batch.acquireFence = m_device.createFenceUnique({});
+                }
+
+                const auto commandBuffer{ *batch.acquireCommandBuffer };
+                m_queue.submit(vk::SubmitInfo{ 0, nullptr, nullptr, 1, &commandBuffer }, *batch.acquireFence);
+            }
+
+            m_acquiredTicket = batch.ticket;
+        }
+    }
+
+    bool UploadBatcher::isComplete(const Ticket ticket)
+    {
+        if (!usesTransferQueue())
+        {
+            return m_staging.isComplete(ticket);
+        }
+
+        acquire();
+        return ticket <= m_acquiredTicket;
+    }
+
+    void UploadBatcher::wait(const Ticket ticket)
+    {
+        m_staging.wait(ticket);
+        acquire();
+    }
+
+    bool UploadBatcher::isFinished(const Ticket ticket)
+    {
+        // Batches are recycled in order once they have completed on both queues
+        acquire();
+        recycle();
+        return ticket <= m_lastTicket && (m_batches.empty() || m_batches.front().ticket > ticket);
+    }
+
+    void UploadBatcher::waitIdle()
+    {
+        m_staging.waitIdle();
+        acquire();
+        for (const auto & batch : m_batches)
+        {
+            if (batch.acquireFence)
+            {
+                m_device.waitForFences(*batch.acquireFence, VK_TRUE, std::numeric_limits<uint64_t>::max());
+            }
+        }
+
+        recycle();
+    }
+
+    StagingRing::Region UploadBatcher::stage(const void * data, const vk::DeviceSize size)
+    {
+        // A region that does not fit next to the regions of the open batch could never be taken, submit the batch first.
+        // The padding in front of a region is smaller than the region plus its alignment.
+        if (!empty() && size <= m_staging.getSize() && m_staging.getUnsubmittedSize() + 2 * size + StagingRing::k_defaultAlignment > m_staging.getSize())
+        {
+            submit();
+        }
+
+        return m_staging.upload(data, size);
+    }
+
+    void UploadBatcher::releaseBuffer(const vk::UniqueBuffer & buffer, const vk::DeviceSize offset, const vk::DeviceSize size)
+    {
+        if (!usesTransferQueue())
+        {
+            return;
+        }
+
+        const vk::BufferMemoryBarrier release{ vk::AccessFlagBits::eTransferWrite, {}, m_transferQueueFamilyIndex, m_queueFamilyIndex, *buffer, offset, size };
+        m_commandBuffer->pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eBottomOfPipe, {}, nullptr, release, nullptr);
+
+        if (!m_acquireCommandBuffer)
+        {
+            m_acquireCommandBuffer = beginCommandBuffer(m_acquireCommandPool, m_unusedAcquireCommandBuffers);
+        }
+
+        const vk::BufferMemoryBarrier acquire{ {}, vk::AccessFlagBits::eMemoryRead, m_transferQueueFamilyIndex, m_queueFamilyIndex, *buffer, offset, size };
+        m_acquireCommandBuffer->pipelineBarrier(vk::PipelineStageFlagBits::eTopOfPipe, vk::PipelineStageFlagBits::eAllCommands, {}, nullptr, acquire, nullptr);
+    }
+
+    void UploadBatcher::releaseImage(const vk::UniqueImage & image, const vk::ImageLayout oldLayout, const vk::ImageLayout newLayout)
+    {
+        if (!usesTransferQueue())
+        {
+            return;
+        }
+
+        const vk::ImageSubresourceRange range{ vk::ImageAspectFlagBits::eColor, 0, 1, 0, 1 };
+        const vk::ImageMemoryBarrier release{ vk::AccessFlagBits::eTransferWrite, {}, oldLayout, newLayout, m_transferQueueFamilyIndex, m_queueFamilyIndex, *image, range };
+        m_commandBuffer->pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eBottomOfPipe, {}, nullptr, nullptr, release);
+
+        if (!m_acquireCommandBuffer)
+        {
+            m_acquireCommandBuffer = beginCommandBuffer(m_acquireCommandPool, m_unusedAcquireCommandBuffers);
+        }
+
+        const vk::ImageMemoryBarrier acquire{ {}, vk::AccessFlagBits::eMemoryRead, oldLayout, newLayout, m_transferQueueFamilyIndex, m_queueFamilyIndex, *image, range };
+        m_acquireCommandBuffer->pipelineBarrier(vk::PipelineStageFlagBits::eTopOfPipe, vk::PipelineStageFlagBits::eAllCommands, {}, nullptr, nullptr, acquire);
+    }
+
+    void UploadBatcher::recycle()
+    {
+        // Reuse the command buffers and fences of batches that have completed on both queues
+        while (!m_batches.empty())
+        {
+            auto & batch{ m_batches.front() };
+            if (!m_staging.isComplete(batch.ticket) || (usesTransferQueue() && batch.ticket > m_acquiredTicket))
+            {
+                break;
+            }
+
+            if (batch.acquireFence)
+            {
+                if (m_device.getFenceStatus(*batch.acquireFence) != vk::Result::eSuccess)
+                {
+                    break;
+                }
+
+                m_device.resetFences(*batch.acquireFence);
+                m_unusedFences.emplace_back(std::move(batch.acquireFence));
+            }
+
+            m_unusedCommandBuffers.emplace_back(std::move(batch.commandBuffer));
+            if (batch.acquireCommandBuffer)
+            {
+                m_unusedAcquireCommandBuffers.emplace_back(std::move(batch.acquireCommandBuffer));
+            }
+
+            m_batches.pop_front();
+        }
+    }
+
+    vk::UniqueCommandBuffer UploadBatcher::beginCommandBuffer(const vk::UniqueCommandPool & pool, std::vector<vk::UniqueCommandBuffer> & unused)
+    {
+        vk::UniqueCommandBuffer commandBuffer;
+        if (!unused.empty())
+        {
+            commandBuffer = std::move(unused.back());
+            unused.pop_back();
+            commandBuffer->reset({});
+        }
+        else
+        {
+            auto vec = m_device.allocateCommandBuffersUnique({ *pool, vk::CommandBufferLevel::ePrimary, 1 });
+            if (vec.size() != 1)
+            {
+                throw std::runtime_error("allocating single command buffer failed, created " + std::to_string(vec.size()) + " command buffers instead.");
+            }
+            commandBuffer = std::move(vec[0]);
+        }
+
+        commandBuffer->begin({ vk::CommandBufferUsageFlagBits::eOneTimeSubmit });
+        return commandBuffer;
+    }
+}
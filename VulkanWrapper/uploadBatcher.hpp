@@ -0,0 +1,99 @@
+#pragma once
+
+#include <vulkan/vulkan.hpp>
+
+#include <deque>
+#include <type_traits>
+#include <vector>
+
+#include "memoryAllocator.hpp"
+#include "stagingRing.hpp"
+
+namespace vw::util
+{
+    // Records buffer and image uploads into a single command buffer, which is submitted with one fence instead of submitting
+    // and waiting for every copy on its own. The data is copied into the staging ring when it is enqueued, so the caller may
+    // release it right away.
+    // The uploads may run on a dedicated transfer queue. The batch then releases the destinations to the queue family of the
+    // queue that uses them, and the matching acquire is submitted to that queue only after the transfer has completed, so
+    // rendering never waits for an upload. The destinations must not be in use by the other queue while they are uploaded to.
+    // On a single queue each batch ends with a barrier that makes its copies visible to all later work on the queue.
+    class UploadBatcher
+    {
+    public:
+        using Ticket = uint64_t;
+
+        UploadBatcher(const vk::UniqueDevice & device, MemoryAllocator & allocator, const vk::Queue & queue, const uint32_t queueFamilyIndex, const vk::DeviceSize stagingSize = StagingRing::k_defaultSize);
+        // Uploads on transferQueue for resources used on queue
+        UploadBatcher(const vk::UniqueDevice & device, MemoryAllocator & allocator, const vk::Queue & queue, const uint32_t queueFamilyIndex, const vk::Queue & transferQueue, const uint32_t transferQueueFamilyIndex, const vk::DeviceSize stagingSize = StagingRing::k_defaultSize);
+        UploadBatcher(const UploadBatcher &) = delete;
+        UploadBatcher(UploadBatcher && other) = default;
+        UploadBatcher & operator=(const UploadBatcher &) = delete;
+        UploadBatcher & operator=(UploadBatcher && other) = delete;
+        ~UploadBatcher();
+
+        void uploadBuffer(const void * data, const vk::DeviceSize size, const vk::UniqueBuffer & dstBuffer, const vk::DeviceSize dstOffset = 0);
+        // Uploads tightly packed texels into the first mip level of a color image, whose contents are discarded
+        void uploadImage(const void * data, const vk::DeviceSize size, const vk::UniqueImage & dstImage, const uint32_t width, const uint32_t height, const vk::ImageLayout finalLayout = vk::ImageLayout::eShaderReadOnlyOptimal);
+        void copyBuffer(const vk::UniqueBuffer & srcBuffer, const vk::UniqueBuffer & dstBuffer, const vk::DeviceSize size, const vk::DeviceSize srcOffset = 0, const vk::DeviceSize dstOffset = 0);
+        // Copies between buffers owned by the queue that uses them, after the earlier copies of the batch. A dedicated transfer
+        // queue does not own them, so the copy is then recorded with the acquires of the batch and runs on the other queue.
+        void copyOwnedBuffer(const vk::UniqueBuffer & srcBuffer, const vk::UniqueBuffer & dstBuffer, const vk::ArrayProxy<const vk::BufferCopy> regions);
+        // The image has to be in transfer destination layout and stays in it
+        void copyBufferToImage(const vk::UniqueBuffer & srcBuffer, const vk::UniqueImage & dstImage, const uint32_t width, const uint32_t height);
+        // For commands the batch has no function for. Resources written by them are not released to the other queue.
+        vk::CommandBuffer getCommandBuffer();
+
+        // Submits the enqueued uploads. Without any, the ticket of the last submission is returned.
+        Ticket submit();
+        // Submits the acquires of the completed transfers, should be called before each frame is submitted
+        void acquire();
+        // A completed ticket's uploads may be used by all work submitted to the queue afterwards
+        bool isComplete(const Ticket ticket);
+        void wait(const Ticket ticket);
+        // Whether the submitted batch and its acquires have finished executing, so the buffers they read may be destroyed
+        bool isFinished(const Ticket ticket);
+        void waitIdle();
+
+        bool empty() const noexcept { return !m_commandBuffer; }
+        bool usesTransferQueue() const noexcept { return m_transferQueueFamilyIndex != m_queueFamilyIndex; }
+        auto & getStagingRing() noexcept { return m_staging; }
+    private:
+        struct Batch
+        {
+            Ticket ticket;
+            vk::UniqueCommandBuffer commandBuffer;
+            vk::UniqueCommandBuffer acquireCommandBuffer;
+            vk::UniqueFence acquireFence;
+        };
+
+        vk::Device m_device;
+        vk::Queue m_queue;
+        uint32_t m_queueFamilyIndex;
+        vk::Queue m_transferQueue;
+        uint32_t m_transferQueueFamilyIndex;
+        vk::UniqueCommandPool m_commandPool;
+        vk::UniqueCommandPool m_acquireCommandPool;
+        StagingRing m_staging;
+
+        vk::UniqueCommandBuffer m_commandBuffer;
+        vk::UniqueCommandBuffer m_acquireCommandBuffer;
+        Ticket m_lastTicket = 0;
+        Ticket m_acquiredTicket = 0;
+        std::deque<Batch> m_batches;
+        std::vector<vk::UniqueCommandBuffer> m_unusedCommandBuffers;
+        std::vector<vk::UniqueCommandBuffer> m_unusedAcquireCommandBuffers;
+        std::vector<vk::UniqueFence> m_unusedFences;
+
+        StagingRing::Region stage(const void * data, const vk::DeviceSize size);
+        void releaseBuffer(const vk::UniqueBuffer & buffer, const vk::DeviceSize offset, const vk::DeviceSize size);
+        void releaseImage(const vk::UniqueImage & image, const vk::ImageLayout oldLayout, const vk::ImageLayout newLayout);
+        void recycle();
+        vk::UniqueCommandBuffer beginCommandBuffer(const vk::UniqueCommandPool & pool, std::vector<vk::UniqueCommandBuffer> & unused);
+    };
+
+    static_assert(std::is_move_constructible_v<UploadBatcher>);
+    static_assert(!std::is_copy_constructible_v<UploadBatcher>);
+    static_assert(!std::is_move_assignable_v<UploadBatcher>);
+    static_assert(!std::is_copy_assignable_v<UploadBatcher>);
+}
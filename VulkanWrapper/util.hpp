@@ -2,6 +2,11 @@
 
 #include <vulkan/vulkan.hpp>
 
+#include <algorithm>
+#include <vector>
+
+#include "memoryAllocator.hpp"
+
 namespace vw::util
 {
     static uint32_t findMemoryType(const vk::PhysicalDevice & physicalDevice, uint32_t typeFilter, vk::MemoryPropertyFlags properties)
@@ -18,41 +23,44 @@ namespace vw::util
         throw std::runtime_error("failed to find suitable memory type!");
     }
 
-    static void createBuffer(const vk::UniqueDevice & device, const vk::PhysicalDevice & physicalDevice, vk::DeviceSize size, vk::BufferUsageFlags usage, vk::MemoryPropertyFlags properties, vk::UniqueBuffer & buffer, vk::UniqueDeviceMemory & bufferMemory)
+    static void createBuffer(const vk::UniqueDevice & device, MemoryAllocator & allocator, vk::DeviceSize size, vk::BufferUsageFlags usage, vk::MemoryPropertyFlags properties, vk::UniqueBuffer & buffer, UniqueAllocation & allocation, const MemoryUsage memoryUsage)
     {
         vk::BufferCreateInfo bufferInfo{ {}, size, usage };
         buffer = device->createBufferUnique(bufferInfo);
-
-        const auto memRequirements{ device->getBufferMemoryRequirements(*buffer) };
-        vk::MemoryAllocateInfo allocInfo{ memRequirements.size, findMemoryType(physicalDevice, memRequirements.memoryTypeBits, properties) };
-        bufferMemory = device->allocateMemoryUnique(allocInfo);
-
-        device->bindBufferMemory(*buffer, *bufferMemory, 0);
+        allocation = allocator.allocateBufferMemory(buffer, properties, memoryUsage);
     }
 
-    static void copyBuffer(const vk::Device & device, const vk::UniqueCommandPool & commandPool, const vk::Queue & queue, vk::UniqueBuffer & srcBuffer, vk::UniqueBuffer & dstBuffer, vk::DeviceSize size)
+    // Copies the changed elements of a host shadow buffer of size bytes into a mapped allocation and flushes them. The sorted
+    // indices are merged into ranges aligned to atomSize; the allocator sizes host visible allocations to whole atoms, so the
+    // ranges never leave the allocation.
+    static void flushDirtyRanges(const vk::UniqueDevice & device, const Allocation & allocation, const void * shadow, const vk::DeviceSize size, const vk::DeviceSize stride, const vk::DeviceSize atomSize, const std::vector<uint32_t> & sortedIndices)
     {
-        auto vec = device.allocateCommandBuffersUnique({ *commandPool, vk::CommandBufferLevel::ePrimary, 1 });
-        assert(vec.size() == 1);
-
-        auto cmdBuffer{ std::move(vec[0]) };
-        cmdBuffer->begin({ vk::CommandBufferUsageFlagBits::eOneTimeSubmit });
-        cmdBuffer->copyBuffer(*srcBuffer, *dstBuffer, { { 0, 0, size } });
-        cmdBuffer->end();
-        vk::CommandBuffer commandBuffers[] = { *cmdBuffer };
-        const vk::SubmitInfo info(0, nullptr, nullptr, 1, commandBuffers, 0, nullptr);
-        queue.submit(info, nullptr);
-        queue.waitIdle();
-    }
+        const auto atom{ std::max(atomSize, vk::DeviceSize{ 1 }) };
+        std::vector<vk::MappedMemoryRange> ranges;
+        for (const auto index : sortedIndices)
+        {
+            const auto begin{ index * stride / atom * atom };
+            const auto end{ std::min(((index + 1) * stride + atom - 1) / atom * atom, allocation.size) };
+            if (!ranges.empty() && begin <= ranges.back().offset + ranges.back().size)
+            {
+                ranges.back().size = end - ranges.back().offset;
+            }
+            else
+            {
+                ranges.emplace_back(allocation.memory, begin, end - begin);
+            }
+        }
 
-    static void copyBuffer(const vk::UniqueCommandBuffer & commandBuffer, const vk::Queue & queue, vk::UniqueBuffer & srcBuffer, vk::UniqueBuffer & dstBuffer, vk::DeviceSize size)
-    {
-        commandBuffer->begin({ vk::CommandBufferUsageFlagBits::eOneTimeSubmit });
-        commandBuffer->copyBuffer(*srcBuffer, *dstBuffer, { { 0, 0, size } });
-        commandBuffer->end();
-        vk::CommandBuffer commandBuffers[] = { *commandBuffer };
-        const vk::SubmitInfo info{ 0, nullptr, nullptr, 1, commandBuffers };
-        queue.submit(info, nullptr);
-        queue.waitIdle();
+        for (auto & range : ranges)
+        {
+            const auto copySize{ std::min(range.offset + range.size, size) - range.offset };
+            memcpy(static_cast<uint8_t *>(allocation.mapped) + range.offset, static_cast<const uint8_t *>(shadow) + range.offset, static_cast<size_t>(copySize));
+            range.offset += allocation.offset;
+        }
+
+        if (!ranges.empty())
+        {
+            device->flushMappedMemoryRanges(ranges);
+        }
     }
 }
\ No newline at end of file
@@ -0,0 +1,23 @@
+#pragma once
+
+#define GLM_FORCE_RADIANS
+#include <glm/glm.hpp>
+
+#include <array>
+#include <cstdint>
+
+namespace vw::util
+{
+    // Number of spheres tested per iteration, arrays passed to cullSpheres are padded to a multiple of this. Both projects build
+    // with /arch:AVX, so the library and its users agree on the size.
+    #if defined(__AVX__)
+    constexpr size_t k_cullBatchSize = 8;
+    #else
+    constexpr size_t k_cullBatchSize = 4;
+    #endif
+
+    // Writes 1 for every sphere that intersects all planes and 0 otherwise, and returns the number of visible spheres. The arrays
+    // must be aligned to 32 bytes and hold count spheres, count being a multiple of k_cullBatchSize. A negative infinite radius
+    // marks an unused entry.
+    size_t cullSpheres(const std::array<glm::vec4, 6> & planes, const float * x, const float * y, const float * z, const float * radius, const size_t count, uint8_t * visible);
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#define GLM_FORCE_RADIANS
+#include <glm/glm.hpp>
+#include <vulkan/vulkan.hpp>
+
+#include <cstdint>
+#include <vector>
+
+namespace vw::util
+{
+    // Layouts of the per-instance transforms in the instance storage buffers. The shaders reading the buffers select the same
+    // layout with the specialization constant 0, set to the value of the enumerator.
+    enum class InstanceFormat : uint32_t
+    {
+        // The model matrix, 64 bytes
+        Matrix = 0,
+        // The first three rows of the model matrix, 48 bytes. Holds any affine transform.
+        Affine = 1,
+        // vec4(position, scale) followed by the rotation quaternion as vec4(x, y, z, w), 32 bytes. Shear and non-uniform scale
+        // are lost, the largest axis scale is kept.
+        PositionRotationScale = 2
+    };
+
+    constexpr vk::DeviceSize getInstanceStride(const InstanceFormat format)
+    {
+        return format == InstanceFormat::Affine ? 3 * sizeof(glm::vec4) : format == InstanceFormat::PositionRotationScale ? 2 * sizeof(glm::vec4) : sizeof(glm::mat4);
+    }
+
+    // Writes the matrix to dst in the given layout
+    void packInstance(const InstanceFormat format, const glm::mat4 & matrix, void * dst);
+    // Writes matrices[i] to dst + i * getInstanceStride(format) for every index, so dst mirrors the layout of the device buffer
+    void packInstances(const InstanceFormat format, const glm::mat4 * matrices, const std::vector<uint32_t> & indices, void * dst);
+}
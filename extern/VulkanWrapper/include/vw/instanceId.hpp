@@ -0,0 +1,8 @@
+#pragma once
+
+#include "handle.hpp"
+
+namespace vw::scene
+{
+    using InstanceID = Handle<struct InstanceTag>;
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <type_traits>
+
+namespace vw::util
+{
+    // A whole file mapped read-only into memory. The pages are read by the OS on first access, nothing is copied up front.
+    class MappedFile
+    {
+    public:
+        MappedFile() {}
+        explicit MappedFile(const std::experimental::filesystem::path & path);
+        MappedFile(const MappedFile &) = delete;
+        MappedFile(MappedFile && other) noexcept;
+        MappedFile & operator=(const MappedFile &) = delete;
+        MappedFile & operator=(MappedFile && other) noexcept;
+        ~MappedFile() { reset(); }
+
+        const uint8_t * data() const noexcept { return m_data; }
+        size_t size() const noexcept { return m_size; }
+        explicit operator bool() const noexcept { return m_data != nullptr; }
+
+        void reset();
+    private:
+        void * m_file = nullptr;
+        void * m_mapping = nullptr;
+        const uint8_t * m_data = nullptr;
+        size_t m_size = 0;
+    };
+
+    static_assert(std::is_move_constructible_v<MappedFile>);
+    static_assert(!std::is_copy_constructible_v<MappedFile>);
+    static_assert(std::is_move_assignable_v<MappedFile>);
+    static_assert(!std::is_copy_assignable_v<MappedFile>);
+}
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <vulkan/vulkan.hpp>
+
+#include <algorithm>
+#include <array>
+
+namespace vw::util
+{
+    // What device memory is used for, allocations are accounted per usage
+    enum class MemoryUsage
+    {
+        Other,
+        Geometry,
+        Instances,
+        Uniforms,
+        Staging,
+        Texture,
+        Attachment,
+        Ui,
+        Count
+    };
+
+    // The usage a resource most likely has, judging by how it is bound
+    inline MemoryUsage toMemoryUsage(const vk::BufferUsageFlags usage)
+    {
+        if (usage & (vk::BufferUsageFlagBits::eVertexBuffer | vk::BufferUsageFlagBits::eIndexBuffer))
+        {
+            return MemoryUsage::Geometry;
+        }
+
+        if (usage & vk::BufferUsageFlagBits::eUniformBuffer)
+        {
+            return MemoryUsage::Uniforms;
+        }
+
+        if (usage & (vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eIndirectBuffer))
+        {
+            return MemoryUsage::Instances;
+        }
+
+        return usage & vk::BufferUsageFlagBits::eTransferSrc ? MemoryUsage::Staging : MemoryUsage::Other;
+    }
+
+    inline MemoryUsage toMemoryUsage(const vk::ImageUsageFlags usage)
+    {
+        if (usage & (vk::ImageUsageFlagBits::eColorAttachment | vk::ImageUsageFlagBits::eDepthStencilAttachment | vk::ImageUsageFlagBits::eInputAttachment | vk::ImageUsageFlagBits::eTransientAttachment))
+        {
+            return MemoryUsage::Attachment;
+        }
+
+        return usage & (vk::ImageUsageFlagBits::eSampled | vk::ImageUsageFlagBits::eStorage) ? MemoryUsage::Texture : MemoryUsage::Other;
+    }
+
+    inline const char * toString(const MemoryUsage usage)
+    {
+        constexpr std::array<const char *, static_cast<size_t>(MemoryUsage::Count)> names{ "Other", "Geometry", "Instances", "Uniforms", "Staging", "Texture", "Attachment", "UI" };
+        return names[static_cast<size_t>(usage)];
+    }
+
+    // Live and peak bytes and the number of live allocations, plus the number of allocations ever made, which keeps growing
+    // when resources are recreated every frame
+    struct MemoryCounter
+    {
+        vk::DeviceSize bytes = 0;
+        vk::DeviceSize peakBytes = 0;
+        uint32_t count = 0;
+        uint64_t totalCount = 0;
+
+        void add(const vk::DeviceSize size) noexcept
+        {
+            bytes += size;
+            peakBytes = std::max(peakBytes, bytes);
+            ++count;
+            ++totalCount;
+        }
+
+        void remove(const vk::DeviceSize size) noexcept
+        {
+            bytes -= size;
+            --count;
+        }
+    };
+
+    // Suballocated ranges are counted per heap, memory type and usage; the device memory blocks they are taken from are counted
+    // per heap. The difference between the two is memory held by the allocator but not handed out.
+    struct MemoryStatistics
+    {
+        MemoryCounter total;
+        std::array<MemoryCounter, VK_MAX_MEMORY_HEAPS> heaps;
+        std::array<MemoryCounter, VK_MAX_MEMORY_TYPES> types;
+        std::array<MemoryCounter, static_cast<size_t>(MemoryUsage::Count)> usages;
+        MemoryCounter blocks;
+        std::array<MemoryCounter, VK_MAX_MEMORY_HEAPS> heapBlocks;
+
+        const auto & getUsage(const MemoryUsage usage) const noexcept { return usages[static_cast<size_t>(usage)]; }
+    };
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+
+#include "model.hpp"
+
+namespace vw::scene
+{
+    // Imported meshes are cached in a binary file next to their source, named after the vertex description, the import
+    // flags and the flags of the processing the loader applied on top, which have to be part of the key as well. The
+    // file holds a header followed by the vertices and the indices exactly as they are uploaded, so a cached mesh is
+    // mapped and handed to the upload without being parsed or copied. A cache is stale once the size or modification
+    // time of its source changes. The version has to be bumped whenever the format or the vertices produced by the
+    // loader change.
+    constexpr uint32_t k_meshCacheVersion = 2;
+
+    template<VertexDescription VD>
+    std::experimental::filesystem::path getMeshCachePath(const std::experimental::filesystem::path & source, const uint32_t importFlags, const uint32_t loaderFlags);
+
+    // Maps the cache of the source into the model, false if there is no up to date cache
+    template<VertexDescription VD>
+    bool loadMeshCache(const std::experimental::filesystem::path & source, const uint32_t importFlags, const uint32_t loaderFlags, Model<VD> & model);
+
+    // Writes the vertices, indices and bounding sphere of the model, false if the cache could not be written
+    template<VertexDescription VD>
+    bool storeMeshCache(const std::experimental::filesystem::path & source, const uint32_t importFlags, const uint32_t loaderFlags, const Model<VD> & model);
+}
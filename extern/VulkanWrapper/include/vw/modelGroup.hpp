@@ -2,34 +2,31 @@
 
 #include <glm/gtc/matrix_transform.hpp>
 
+#include "instanceFormat.hpp"
+#include "uploadBatcher.hpp"
 #include "vertex.hpp"
 #include "util.hpp"
 #include "modelId.hpp"
 
 namespace vw::scene
 {
+    // The instance storage starts with room for initialCapacity instances and doubles whenever it runs out. The dynamic uniform
+    // buffer follows with the next flush, which then reports that the descriptors have to be written again.
     template<VertexDescription VD>
     class ModelGroup
     {
     public:
-        ModelGroup(const vk::PhysicalDeviceProperties & prop, const uint32_t maxNumInstances)
-          : m_maxNumInstances{ maxNumInstances },
-            m_numInstances{ 0 },
-            m_dynamicAlignment{ sizeof(glm::mat4) }
+        // One model matrix per instance in a dynamic uniform buffer, each padded to minUniformBufferOffsetAlignment and drawn
+        // with its own dynamic offset
+        ModelGroup(const vk::PhysicalDeviceProperties & prop, const uint32_t initialCapacity)
+          : ModelGroup{ prop, initialCapacity, util::InstanceFormat::Matrix, false }
+        {
+        }
+        // The instances packed into a storage buffer in the given format, indexed by gl_InstanceIndex and drawn with a single
+        // instanced draw
+        ModelGroup(const vk::PhysicalDeviceProperties & prop, const uint32_t initialCapacity, const util::InstanceFormat format)
+          : ModelGroup{ prop, initialCapacity, format, true }
         {
-            const auto minUboAlignment = prop.limits.minUniformBufferOffsetAlignment;
-            if (minUboAlignment > 0)
-            {
-                m_dynamicAlignment = (m_dynamicAlignment + minUboAlignment - 1) & ~(minUboAlignment - 1);
-            }
-
-            const auto bufferSize{ m_maxNumInstances * m_dynamicAlignment };
-
-            m_dynamicUniformBufferObject.model = static_cast<glm::mat4 *>(_aligned_malloc(bufferSize, m_dynamicAlignment));
-            if (m_dynamicUniformBufferObject.model == nullptr)
-            {
-                throw std::runtime_error("model matrix pointer must not be null");
-            }
         }
         ModelGroup(ModelGroup && other) = default;
         ModelGroup & operator=(ModelGroup && other) = default;
@@ -50,31 +47,21 @@ namespace vw::scene
 
         auto getDescriptorBufferInfo()
         {
+            if (m_packed)
+            {
+                return vk::DescriptorBufferInfo{ *m_dynamicUniformBuffer, 0, m_bufferCapacity * m_bufferStride };
+            }
+
             return vk::DescriptorBufferInfo{ *m_dynamicUniformBuffer, 0, sizeof(DynamicUniformBufferObject) };
         }
 
-        void createBuffers(const vk::UniqueDevice & device, const vk::PhysicalDevice & physicalDevice, const vk::UniqueCommandPool & commandPool, const vk::Queue & queue)
+        auto getDescriptorType() const noexcept { return m_packed ? vk::DescriptorType::eStorageBuffer : vk::DescriptorType::eUniformBufferDynamic; }
+
+        void createBuffers(const vk::UniqueDevice & device, util::MemoryAllocator & allocator, util::UploadBatcher & uploads)
         {
             const auto vertexBufferSize{ sizeof(m_vertices[0]) * m_vertices.size() };
             const auto indexBufferSize{ sizeof(m_indices[0]) * m_indices.size() };
 
-            // Create & fill staging buffers & memories
-            vk::UniqueBuffer vertexStagingBuffer;
-            vk::UniqueDeviceMemory vertexStagingBufferMemory;
-            util::createBuffer(device, physicalDevice, vertexBufferSize, vk::BufferUsageFlagBits::eTransferSrc, vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent, vertexStagingBuffer, vertexStagingBufferMemory);
-
-            auto * vertexData{ device->mapMemory(*vertexStagingBufferMemory, 0, vertexBufferSize,{}) };
-            memcpy(vertexData, m_vertices.data(), static_cast<size_t>(vertexBufferSize));
-            device->unmapMemory(*vertexStagingBufferMemory);
-
-            vk::UniqueBuffer indexStagingBuffer;
-            vk::UniqueDeviceMemory indexStagingBufferMemory;
-            util::createBuffer(device, physicalDevice, indexBufferSize, vk::BufferUsageFlagBits::eTransferSrc, vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent, indexStagingBuffer, indexStagingBufferMemory);
-
-            auto * indexData{ device->mapMemory(*indexStagingBufferMemory, 0, indexBufferSize,{}) };
-            memcpy(indexData, m_indices.data(), static_cast<size_t>(indexBufferSize));
-            device->unmapMemory(*indexStagingBufferMemory);
-
             // Get size & offset
             const auto vb = device->createBufferUnique({ {}, vertexBufferSize, vk::BufferUsageFlagBits::eTransferDst | vk::BufferUsageFlagBits::eVertexBuffer });
             const auto ib = device->createBufferUnique({ {}, indexBufferSize, vk::BufferUsageFlagBits::eTransferDst | vk::BufferUsageFlagBits::eIndexBuffer });
@@ -84,31 +71,15 @@ namespace vw::scene
             m_offset = vMemReq.size;
 
             // Create buffer & memory
-            util::createBuffer(device, physicalDevice, bufSize, vk::BufferUsageFlagBits::eTransferDst | vk::BufferUsageFlagBits::eVertexBuffer | vk::BufferUsageFlagBits::eIndexBuffer, vk::MemoryPropertyFlagBits::eDeviceLocal, m_buffer, m_bufferMemory);
+            util::createBuffer(device, allocator, bufSize, vk::BufferUsageFlagBits::eTransferDst | vk::BufferUsageFlagBits::eVertexBuffer | vk::BufferUsageFlagBits::eIndexBuffer, vk::MemoryPropertyFlagBits::eDeviceLocal, m_buffer, m_bufferAllocation, util::MemoryUsage::Geometry);
 
-            // Copy staging buffers into buffer
-            auto vec = device->allocateCommandBuffersUnique({ *commandPool, vk::CommandBufferLevel::ePrimary, 1 });
-            if (vec.size() != 1)
-            {
-                throw std::runtime_error("allocating single command buffer failed, created " + std::to_string(vec.size()) + " command buffers instead.");
-            }
-            auto cmdBuffer{ std::move(vec[0]) };
-            cmdBuffer->begin({ vk::CommandBufferUsageFlagBits::eOneTimeSubmit });
-            cmdBuffer->copyBuffer(*vertexStagingBuffer, *m_buffer, { { 0, 0, vertexBufferSize } });
-            cmdBuffer->copyBuffer(*indexStagingBuffer, *m_buffer, { { 0, m_offset, indexBufferSize } });
-            cmdBuffer->end();
-            vk::CommandBuffer commandBuffers[] = { *cmdBuffer };
-            const vk::SubmitInfo info(0, nullptr, nullptr, 1, commandBuffers, 0, nullptr);
-            queue.submit(info, nullptr);
-            queue.waitIdle();
-
-            // Destroy staging buffers before staging memories
-            vertexStagingBuffer.reset(nullptr);
-            indexStagingBuffer.reset(nullptr);
+            // Enqueue the copies, they are executed with the next submission of the batch
+            uploads.uploadBuffer(m_vertices.data(), vertexBufferSize, m_buffer);
+            uploads.uploadBuffer(m_indices.data(), indexBufferSize, m_buffer, m_offset);
 
             // Create dynamic buffer
-            const auto dynamicBufferSize{ m_maxNumInstances * m_dynamicAlignment };
-            util::createBuffer(device, physicalDevice, dynamicBufferSize, vk::BufferUsageFlagBits::eUniformBuffer, vk::MemoryPropertyFlagBits::eHostVisible, m_dynamicUniformBuffer, m_dynamicUniformBufferMemory);
+            m_allocator = &allocator;
+            createDynamicBuffer(device);
         }
 
         void draw(const vk::UniqueCommandBuffer & commandBuffer, const vk::UniquePipelineLayout & pipelineLayout, const vk::UniqueDescriptorSet & desciptorSet) const
@@ -117,6 +88,13 @@ namespace vw::scene
             commandBuffer->bindVertexBuffers(0, *m_buffer, offsets);
             commandBuffer->bindIndexBuffer(*m_buffer, m_offset, vk::IndexType::eUint32);
 
+            if (m_packed)
+            {
+                commandBuffer->bindDescriptorSets(vk::PipelineBindPoint::eGraphics, *pipelineLayout, 0, *desciptorSet, nullptr);
+                commandBuffer->drawIndexed(static_cast<uint32_t>(m_indices.size()), m_numInstances, 0, 0, 0);
+                return;
+            }
+
             for (uint32_t i = 0; i < m_numInstances; ++i)
             {
                 auto dynamicOffset = i * static_cast<uint32_t>(m_dynamicAlignment);
@@ -125,16 +103,45 @@ namespace vw::scene
             }
         }
 
-        void flush(const vk::UniqueDevice & device)
+        // Returns true when the dynamic buffer had to grow. The old buffer is kept until releaseRetiredBuffers(), so the device can
+        // finish the frames still reading it; afterwards the descriptors have to be written again and command buffers recorded again.
+        // The changed instances are written from the host, so no frame reading the buffer may be in flight.
+        bool flush(const vk::UniqueDevice & device)
         {
-            const auto bufSize{ m_maxNumInstances * m_dynamicAlignment };
-            auto data{ device->mapMemory(*m_dynamicUniformBufferMemory, 0, bufSize, {}) };
-            memcpy(data, m_dynamicUniformBufferObject.model, bufSize);
-            vk::MappedMemoryRange mmr{ *m_dynamicUniformBufferMemory, 0, bufSize };
-            device->flushMappedMemoryRanges(mmr);
-            device->unmapMemory(*m_dynamicUniformBufferMemory);
+            const auto grown{ prepareFlush(device) };
+            const auto bufSize{ m_bufferCapacity * m_bufferStride };
+            util::flushDirtyRanges(device, *m_dynamicUniformBufferAllocation, getFlushedInstances(), bufSize, m_bufferStride, m_nonCoherentAtomSize, m_dirtyInstances);
+            m_dirtyInstances.clear();
+            return grown;
+        }
+
+        // Like flush(), but hands each run of changed instances to upload(buffer, data, size, offset) instead of writing it from
+        // the host. For frames that overlap: the caller copies the runs with a transfer ordered after the frames still reading
+        // the buffer. The data is only valid during the call.
+        template<class Upload>
+        bool flush(const vk::UniqueDevice & device, Upload && upload)
+        {
+            const auto grown{ prepareFlush(device) };
+            const auto * instances{ static_cast<const uint8_t *>(getFlushedInstances()) };
+            for (size_t first = 0; first < m_dirtyInstances.size();)
+            {
+                auto last{ first + 1 };
+                while (last < m_dirtyInstances.size() && m_dirtyInstances[last] == m_dirtyInstances[last - 1] + 1)
+                {
+                    ++last;
+                }
+
+                const auto offset{ m_dirtyInstances[first] * m_bufferStride };
+                upload(m_dynamicUniformBuffer, instances + offset, (last - first) * m_bufferStride, offset);
+                first = last;
+            }
+            m_dirtyInstances.clear();
+            return grown;
         }
 
+        // Only call once the device has finished every frame submitted before the last flush that grew the buffer
+        void releaseRetiredBuffers() { m_retiredBuffers.clear(); }
+
         void setModelMatrix(const ModelID id, const glm::mat4 & modelMatrix)
         {
             if (!idExists(id))
@@ -145,6 +152,7 @@ namespace vw::scene
             const auto idx{ m_idToIdxMap[id] };
             glm::mat4 * modelMat = reinterpret_cast<glm::mat4 *>((reinterpret_cast<uint64_t>(m_dynamicUniformBufferObject.model) + idx * m_dynamicAlignment));
             *modelMat = modelMatrix;
+            markDirty(idx);
         }
 
         void translate(const ModelID id, const glm::vec3 & translate)
@@ -157,6 +165,7 @@ namespace vw::scene
             const auto idx{ m_idToIdxMap[id] };
             glm::mat4 * modelMat = reinterpret_cast<glm::mat4 *>((reinterpret_cast<uint64_t>(m_dynamicUniformBufferObject.model) + (idx * m_dynamicAlignment)));
             *modelMat = glm::translate(*modelMat, translate);
+            markDirty(idx);
         }
 
         void scale(const uint32_t id, const glm::vec3 & scale)
@@ -169,6 +178,7 @@ namespace vw::scene
             const auto idx{ m_idToIdxMap[id] };
             glm::mat4 * modelMat = reinterpret_cast<glm::mat4 *>((reinterpret_cast<uint64_t>(m_dynamicUniformBufferObject.model) + (idx * m_dynamicAlignment)));
             *modelMat = glm::scale(*modelMat, scale);
+            markDirty(idx);
         }
 
         void rotate(const uint32_t id, const glm::vec3 & axis, const float radians)
@@ -181,27 +191,61 @@ namespace vw::scene
             const auto idx{ m_idToIdxMap[id] };
             glm::mat4 * modelMat = reinterpret_cast<glm::mat4 *>((reinterpret_cast<uint64_t>(m_dynamicUniformBufferObject.model) + (idx * m_dynamicAlignment)));
             *modelMat = glm::rotate(*modelMat, radians, axis);
+            markDirty(idx);
         }
 
         auto getNumInstances() const noexcept { return m_numInstances; }
+        auto getCapacity() const noexcept { return m_capacity; }
+
+        // Grows the host copy, the dynamic buffer follows with the next flush
+        void reserve(const uint32_t capacity)
+        {
+            if (capacity <= m_capacity)
+            {
+                return;
+            }
+
+            auto * model{ static_cast<glm::mat4 *>(_aligned_malloc(capacity * m_dynamicAlignment, m_dynamicAlignment)) };
+            if (model == nullptr)
+            {
+                throw std::runtime_error("model matrix pointer must not be null");
+            }
+
+            if (m_dynamicUniformBufferObject.model != nullptr)
+            {
+                memcpy(model, m_dynamicUniformBufferObject.model, m_numInstances * m_dynamicAlignment);
+                _aligned_free(m_dynamicUniformBufferObject.model);
+            }
+
+            m_dynamicUniformBufferObject.model = model;
+            m_dirtyFlags.resize(capacity, 0);
+            if (m_packed && m_format != util::InstanceFormat::Matrix)
+            {
+                m_packedInstances.resize(capacity * m_bufferStride);
+            }
+
+            m_capacity = capacity;
+        }
 
         ModelID addInstance()
         {
-            if (m_numInstances + 1 > m_maxNumInstances)
+            // Doubling keeps the copies amortized constant per instance
+            if (m_numInstances == m_capacity)
             {
-                throw std::invalid_argument("too many instances");
+                reserve(2 * m_capacity);
             }
 
             ModelID id;
+            markDirty(m_numInstances);
             m_idToIdxMap[id] = m_numInstances++;
             return id;
         }
 
         std::vector<ModelID> addInstances(const uint32_t numAdditionalInstances)
         {
-            if (m_numInstances + numAdditionalInstances > m_maxNumInstances)
+            if (m_numInstances + numAdditionalInstances > m_capacity)
             {
-                throw std::invalid_argument("too many instances");
+                reserve(std::max(m_numInstances + numAdditionalInstances, 2 * m_capacity));
             }
 
             std::vector<ModelID> ret;
@@ -215,7 +259,83 @@ namespace vw::scene
 
         void clear() { m_numInstances = 0; m_idToIdxMap.clear(); }
     private:
+        ModelGroup(const vk::PhysicalDeviceProperties & prop, const uint32_t initialCapacity, const util::InstanceFormat format, const bool packed)
+          : m_capacity{ 0 },
+            m_numInstances{ 0 },
+            m_dynamicAlignment{ sizeof(glm::mat4) },
+            m_nonCoherentAtomSize{ prop.limits.nonCoherentAtomSize },
+            m_packed{ packed },
+            m_format{ format },
+            m_bufferStride{ util::getInstanceStride(format) }
+        {
+            // Packed instances keep their matrices back to back on the host as well
+            const auto minUboAlignment = prop.limits.minUniformBufferOffsetAlignment;
+            if (!m_packed && minUboAlignment > 0)
+            {
+                m_dynamicAlignment = (m_dynamicAlignment + minUboAlignment - 1) & ~(minUboAlignment - 1);
+                m_bufferStride = m_dynamicAlignment;
+            }
+
+            reserve(std::max(initialCapacity, 1u));
+        }
+
         bool idExists(const ModelID id) const { return m_idToIdxMap.find(id) != m_idToIdxMap.end(); }
+
+        // Grows the dynamic buffer if needed and sorts the changed instances, returns whether it grew
+        bool prepareFlush(const vk::UniqueDevice & device)
+        {
+            const auto grown{ m_bufferCapacity < m_capacity };
+            if (grown)
+            {
+                m_retiredBuffers.emplace_back(std::move(m_dynamicUniformBufferAllocation), std::move(m_dynamicUniformBuffer));
+                createDynamicBuffer(device);
+
+                // The new buffer starts out empty, so every live instance is uploaded from the host copy
+                for (uint32_t i = 0; i < m_numInstances; ++i)
+                {
+                    markDirty(i);
+                }
+            }
+
+            // Only the instances changed since the last flush are copied
+            std::sort(m_dirtyInstances.begin(), m_dirtyInstances.end());
+            for (const auto idx : m_dirtyInstances)
+            {
+                m_dirtyFlags[idx] = 0;
+            }
+
+            return grown;
+        }
+
+        // The instances in the layout of the device buffer, the changed ones are up to date after prepareFlush()
+        const void * getFlushedInstances()
+        {
+            if (m_packed && m_format != util::InstanceFormat::Matrix)
+            {
+                util::packInstances(m_format, m_dynamicUniformBufferObject.model, m_dirtyInstances, m_packedInstances.data());
+                return m_packedInstances.data();
+            }
+
+            return m_dynamicUniformBufferObject.model;
+        }
+
+        void createDynamicBuffer(const vk::UniqueDevice & device)
+        {
+            const auto dynamicBufferSize{ m_capacity * m_bufferStride };
+            // Written either from the host or with transfers, see flush()
+            const auto usage{ vk::BufferUsageFlagBits::eTransferDst | (m_packed ? vk::BufferUsageFlagBits::eStorageBuffer : vk::BufferUsageFlagBits::eUniformBuffer) };
+            util::createBuffer(device, *m_allocator, dynamicBufferSize, usage, vk::MemoryPropertyFlagBits::eHostVisible, m_dynamicUniformBuffer, m_dynamicUniformBufferAllocation, m_packed ? util::MemoryUsage::Instances : util::MemoryUsage::Uniforms);
+            m_bufferCapacity = m_capacity;
+        }
+
+        void markDirty(const uint32_t idx)
+        {
+            if (!m_dirtyFlags[idx])
+            {
+                m_dirtyFlags[idx] = 1;
+                m_dirtyInstances.push_back(idx);
+            }
+        }
         
         std::unordered_map<ModelID, uint32_t, ModelID::KeyHash> m_idToIdxMap;
 
@@ -224,17 +344,29 @@ namespace vw::scene
             glm::mat4 * model = nullptr;
         } m_dynamicUniformBufferObject;
 
-        uint32_t m_maxNumInstances;
+        uint32_t m_capacity;
         uint32_t m_numInstances;
         size_t m_dynamicAlignment = 0;
+        vk::DeviceSize m_nonCoherentAtomSize;
+        bool m_packed;
+        util::InstanceFormat m_format;
+        // Distance of two instances in the device buffer
+        vk::DeviceSize m_bufferStride;
+        // The instances in the layout of the storage buffer, converted on flush. Unused for full matrices.
+        std::vector<uint8_t> m_packedInstances;
+        std::vector<uint8_t> m_dirtyFlags;
+        std::vector<uint32_t> m_dirtyInstances;
 
         std::vector<Vertex<VD>> m_vertices;
         std::vector<uint32_t> m_indices;
 
-        vk::UniqueDeviceMemory m_dynamicUniformBufferMemory;
+        util::MemoryAllocator * m_allocator = nullptr;
+        util::UniqueAllocation m_dynamicUniformBufferAllocation;
         vk::UniqueBuffer m_dynamicUniformBuffer;
+        uint32_t m_bufferCapacity = 0;
+        std::vector<std::pair<util::UniqueAllocation, vk::UniqueBuffer>> m_retiredBuffers;
 
-        vk::UniqueDeviceMemory m_bufferMemory;
+        util::UniqueAllocation m_bufferAllocation;
         vk::UniqueBuffer m_buffer;
         vk::DeviceSize m_offset = 0;
     };
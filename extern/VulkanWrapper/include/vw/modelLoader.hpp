@@ -4,9 +4,18 @@
 #include <assimp/postprocess.h>
 #include <assimp/scene.h>
 
+#include <algorithm>
+#include <array>
+#include <optional>
 #include <type_traits>
+#include <vector>
 
+#include "bounds.hpp"
+#include "meshCache.hpp"
+#include "meshOptimizer.hpp"
 #include "model.hpp"
+#include "parallel.hpp"
+#include "vertexWelder.hpp"
 
 namespace vw::scene
 {
@@ -21,6 +30,9 @@ namespace vw::scene
             Explicit
         };
 
+        // Imported models are cached next to their source, see meshCache.hpp, so later loads only map the cache
+        explicit ModelLoader(const bool useMeshCache = true) : m_useMeshCache{ useMeshCache } {}
+
         template <VertexDescription vd = VD>
         auto createVertex(const glm::vec3 & v, const glm::vec3 & n, const glm::vec3 & c, const glm::vec2 & t, typename std::enable_if_t<vd == VertexDescription::PositionNormalColorTexture> * = nullptr) const
         {
@@ -33,12 +45,9 @@ namespace vw::scene
             return Vertex<VD>{ v, n, c };
         }
 
-        Model<VD> loadModel(std::string_view file, const NormalCreation normalCreation)
+        // Optimizing reorders the triangles for the vertex cache and overdraw and the vertices for fetching, see optimizeMesh
+        Model<VD> loadModel(std::string_view file, const NormalCreation normalCreation, const bool optimize = false)
         {
-            Model<VD> model;
-            model.getVertices().clear();
-            model.getIndices().clear();
-
             int aiProcessFlags{ aiProcess_Triangulate };
             if (normalCreation == NormalCreation::AssimpNormals)
             {
@@ -49,78 +58,33 @@ namespace vw::scene
                 aiProcessFlags |= aiProcess_GenSmoothNormals;
             }
 
-            const auto * scene = m_importer.ReadFile(file.data(), aiProcessFlags);
-            if (!scene)
+            const std::experimental::filesystem::path path{ std::string{ file } };
+            const auto loaderFlags{ optimize ? k_optimizeLoaderFlag : 0u };
+            m_optimizationStatistics.reset();
+            Model<VD> model;
+            if (m_useMeshCache && loadMeshCache(path, aiProcessFlags, loaderFlags, model))
             {
-                throw std::runtime_error(m_importer.GetErrorString());
+                return model;
             }
 
-            std::unordered_map<Vertex<VD>, uint32_t> uniqueVertices = {};
-
-            const auto meshes = scene->mMeshes;
-            const auto numMeshes = scene->mNumMeshes;
-            for (uint32_t i = 0; i < numMeshes; ++i)
+            model = importModel(file, normalCreation, aiProcessFlags);
+            if (optimize)
             {
-                const auto mesh = meshes[i];
-                const auto vertices = mesh->mVertices;
-                const auto normals = mesh->mNormals;
-                const auto faces = mesh->mFaces;
-                const auto numVertices = mesh->mNumVertices;
-                const auto numFaces = mesh->mNumFaces;
-
-                for (uint32_t j = 0; j < numFaces; ++j)
-                {
-                    const auto face = faces[j];
-                    const auto indices = face.mIndices;
-                    const auto numIndices = face.mNumIndices;
-                    if (numIndices != 3)
-                    {
-                        throw std::runtime_error("no triangles");
-                    }
-                    
-                    glm::vec3 n;
-                    if (normalCreation == NormalCreation::Explicit)
-                    {
-                        const auto a_assimp = vertices[indices[0]];
-                        const auto a = glm::vec3(a_assimp.x, a_assimp.y, a_assimp.z);
-                        const auto b_assimp = vertices[indices[1]];
-                        const auto b = glm::vec3(b_assimp.x, b_assimp.y, b_assimp.z);
-                        const auto c_assimp = vertices[indices[2]];
-                        const auto c = glm::vec3(c_assimp.x, c_assimp.y, c_assimp.z);
-                        n = glm::normalize(glm::cross(b - a, c - a));
-                    }
-
-                    for (uint32_t k = 0; k < numIndices; ++k)
-                    {
-                        const auto index = indices[k];
-                        if (index >= numVertices)
-                        {
-                            throw std::runtime_error("index too big");
-                        }
-
-                        const auto v = vertices[index];
-                        if (normalCreation == NormalCreation::AssimpNormals || normalCreation == NormalCreation::AssimpSmoothNormals)
-                        {
-                            const auto aiN{ normals[index] };
-                            n = { aiN.x, aiN.y, aiN.z };
-                        }
-
-                        const auto vertex{ createVertex<VD>({ v.x, v.y, v.z }, n, { 1.f, 0.f, 0.f }, { 0.f, 1.f }) };
-
-                        if (uniqueVertices.count(vertex) == 0)
-                        {
-                            uniqueVertices[vertex] = static_cast<uint32_t>(model.getVertices().size());
-                            model.getVertices().push_back(vertex);
-                        }
-
-                        model.getIndices().push_back(uniqueVertices[vertex]);
-                    }
-                }
+                m_optimizationStatistics = optimizeMesh(model.getVertices(), model.getIndices());
             }
 
+            if (m_useMeshCache)
+            {
+                // A cache that cannot be written only costs the next load its speed
+                storeMeshCache(path, aiProcessFlags, loaderFlags, model);
+            }
             return model;
         }
 
+        // The vertex cache statistics of the last loadModel, if it optimized the model. A model from the cache was optimized
+        // when it was imported, the statistics are not kept.
+        const auto & getOptimizationStatistics() const noexcept { return m_optimizationStatistics; }
+
         Model<VD> loadTriangle() const
         {
             Model<VD> model;
@@ -153,10 +117,206 @@ namespace vw::scene
             modelIndices.push_back(1);
             modelIndices.push_back(2);
 
+            model.setBoundingSphere(computeBoundingSphere(modelVertices));
             return model;
         }
     private:
+        Model<VD> importModel(std::string_view file, const NormalCreation normalCreation, const int aiProcessFlags)
+        {
+            Model<VD> model;
+            model.getVertices().clear();
+            model.getIndices().clear();
+
+            const auto * scene = m_importer.ReadFile(file.data(), aiProcessFlags);
+            if (!scene)
+            {
+                throw std::runtime_error(m_importer.GetErrorString());
+            }
+
+            // Large meshes are split into chunks of faces, which are turned into vertices and deduplicated in parallel
+            std::vector<FaceChunk> chunks;
+            size_t numCorners = 0;
+            const auto meshes = scene->mMeshes;
+            const auto numMeshes = scene->mNumMeshes;
+            for (uint32_t i = 0; i < numMeshes; ++i)
+            {
+                const auto numFaces = meshes[i]->mNumFaces;
+                for (uint32_t first = 0; first < numFaces; first += k_facesPerChunk)
+                {
+                    const auto end{ std::min(numFaces, first + k_facesPerChunk) };
+                    chunks.push_back({ meshes[i], first, end, numCorners });
+                    numCorners += 3 * static_cast<size_t>(end - first);
+                }
+            }
+
+            util::parallelFor(chunks.size(), [&](const size_t i) { processChunk(chunks[i], normalCreation); });
+
+            // A single chunk is already deduplicated
+            if (chunks.size() == 1)
+            {
+                model.getVertices() = std::move(chunks[0].vertices);
+                model.getIndices() = std::move(chunks[0].indices);
+                model.setBoundingSphere(computeBoundingSphere(model.getVertices()));
+                return model;
+            }
+
+            // The vertices of all chunks are deduplicated once more, split by hash into shards that are worked on in parallel.
+            // Every shard visits the chunks in order, so each vertex ends up owned by its first occurrence.
+            util::parallelFor(k_mergeShards, [&](const size_t shard)
+            {
+                VertexWelder<VD> welder;
+                std::vector<VertexRef> owners;
+                for (uint32_t c = 0; c < chunks.size(); ++c)
+                {
+                    auto & chunk{ chunks[c] };
+                    for (const auto j : chunk.shards[shard])
+                    {
+                        const auto index{ welder.weld(chunk.vertices[j], chunk.hashes[j]) };
+                        if (index == owners.size())
+                        {
+                            owners.push_back({ c, j });
+                        }
+                        chunk.owners[j] = owners[index];
+                    }
+                }
+            });
+
+            // Numbering the owners in chunk order gives every vertex the index of its first occurrence, just like a single pass
+            // over all faces, so the result does not depend on the number of threads
+            auto & modelVertices{ model.getVertices() };
+            for (uint32_t c = 0; c < chunks.size(); ++c)
+            {
+                auto & chunk{ chunks[c] };
+                chunk.remap.resize(chunk.vertices.size());
+                for (uint32_t j = 0; j < chunk.vertices.size(); ++j)
+                {
+                    if (chunk.owners[j].chunk == c && chunk.owners[j].vertex == j)
+                    {
+                        chunk.remap[j] = static_cast<uint32_t>(modelVertices.size());
+                        modelVertices.push_back(chunk.vertices[j]);
+                    }
+                }
+            }
+
+            auto & modelIndices{ model.getIndices() };
+            modelIndices.resize(numCorners);
+            util::parallelFor(chunks.size(), [&](const size_t i)
+            {
+                auto & chunk{ chunks[i] };
+                for (size_t j = 0; j < chunk.vertices.size(); ++j)
+                {
+                    const auto & owner{ chunk.owners[j] };
+                    chunk.remap[j] = chunks[owner.chunk].remap[owner.vertex];
+                }
+
+                std::transform(chunk.indices.begin(), chunk.indices.end(), modelIndices.begin() + chunk.firstCorner, [&chunk](const uint32_t index) { return chunk.remap[index]; });
+            });
+
+            model.setBoundingSphere(computeBoundingSphere(model.getVertices()));
+            return model;
+        }
+
+        static constexpr uint32_t k_optimizeLoaderFlag = 1;
+        static constexpr uint32_t k_facesPerChunk = 1 << 15;
+        static constexpr size_t k_mergeShards = 64;
+        // The shard is taken from the top bits of the hash, the welders use the bottom bits
+        static constexpr uint32_t k_mergeShardShift = 26;
+        static_assert(k_mergeShards << k_mergeShardShift == 1ull << 32);
+
+        struct VertexRef
+        {
+            uint32_t chunk;
+            uint32_t vertex;
+        };
+
+        // A range of faces of one mesh, with its vertices deduplicated on their own
+        struct FaceChunk
+        {
+            const aiMesh * mesh;
+            uint32_t firstFace;
+            uint32_t endFace;
+            size_t firstCorner;
+            std::vector<Vertex<VD>> vertices;
+            // The VertexWelder hash of each vertex
+            std::vector<uint32_t> hashes;
+            // The vertices of each merge shard
+            std::array<std::vector<uint32_t>, k_mergeShards> shards;
+            // One per face corner, into vertices
+            std::vector<uint32_t> indices;
+            // The first occurrence of each vertex in any chunk
+            std::vector<VertexRef> owners;
+            // From vertices to the vertices of the model
+            std::vector<uint32_t> remap;
+        };
+
+        void processChunk(FaceChunk & chunk, const NormalCreation normalCreation) const
+        {
+            const auto mesh = chunk.mesh;
+            const auto vertices = mesh->mVertices;
+            const auto normals = mesh->mNormals;
+            const auto faces = mesh->mFaces;
+            const auto numVertices = mesh->mNumVertices;
+
+            const auto numCorners{ 3 * static_cast<size_t>(chunk.endFace - chunk.firstFace) };
+            VertexWelder<VD> welder{ std::min(static_cast<size_t>(numVertices), numCorners) };
+            chunk.indices.reserve(numCorners);
+            for (auto j = chunk.firstFace; j < chunk.endFace; ++j)
+            {
+                const auto face = faces[j];
+                const auto indices = face.mIndices;
+                const auto numIndices = face.mNumIndices;
+                if (numIndices != 3)
+                {
+                    throw std::runtime_error("no triangles");
+                }
+
+                glm::vec3 n;
+                if (normalCreation == NormalCreation::Explicit)
+                {
+                    const auto a_assimp = vertices[indices[0]];
+                    const auto a = glm::vec3(a_assimp.x, a_assimp.y, a_assimp.z);
+                    const auto b_assimp = vertices[indices[1]];
+                    const auto b = glm::vec3(b_assimp.x, b_assimp.y, b_assimp.z);
+                    const auto c_assimp = vertices[indices[2]];
+                    const auto c = glm::vec3(c_assimp.x, c_assimp.y, c_assimp.z);
+                    n = glm::normalize(glm::cross(b - a, c - a));
+                }
+
+                for (uint32_t k = 0; k < numIndices; ++k)
+                {
+                    const auto index = indices[k];
+                    if (index >= numVertices)
+                    {
+                        throw std::runtime_error("index too big");
+                    }
+
+                    const auto v = vertices[index];
+                    if (normalCreation == NormalCreation::AssimpNormals || normalCreation == NormalCreation::AssimpSmoothNormals)
+                    {
+                        const auto aiN{ normals[index] };
+                        n = { aiN.x, aiN.y, aiN.z };
+                    }
+
+                    const auto vertex{ createVertex<VD>({ v.x, v.y, v.z }, n, { 1.f, 0.f, 0.f }, { 0.f, 1.f }) };
+                    const auto hash{ VertexWelder<VD>::hash(vertex) };
+                    const auto vertexIndex{ welder.weld(vertex, hash) };
+                    if (vertexIndex == chunk.hashes.size())
+                    {
+                        chunk.shards[hash >> k_mergeShardShift].push_back(vertexIndex);
+                        chunk.hashes.push_back(hash);
+                    }
+
+                    chunk.indices.push_back(vertexIndex);
+                }
+            }
+
+            chunk.vertices = welder.releaseVertices();
+            chunk.owners.resize(chunk.vertices.size());
+        }
+
         Assimp::Importer m_importer;
+        bool m_useMeshCache;
+        std::optional<MeshOptimizationStatistics> m_optimizationStatistics;
     };
 
     static_assert(std::is_move_constructible_v<ModelLoader<VertexDescription::PositionNormalColorTexture>>);
@@ -1,28 +1,41 @@
 #pragma once
 
-#include <set>
-
+#include "bounds.hpp"
 #include "vertex.hpp"
 
 namespace vw::scene
 {
+    // The geometry of a resource lives in the shared vertex and index buffers of its repository, only its extent and bounds are
+    // kept on the host.
     template <VertexDescription VD>
     class ModelResource
     {
     public:
-        ModelResource(std::vector<Vertex<VD>> && vertices, std::vector<uint32_t> && indices, const vk::UniqueDevice & device, const vk::PhysicalDevice & physicalDevice, const vk::UniqueCommandPool & commandPool, const vk::Queue & queue);
+        ModelResource(const std::vector<Vertex<VD>> & vertices, const std::vector<uint32_t> & indices, const uint32_t firstIndex, const int32_t vertexOffset);
         ModelResource(const ModelResource &) = delete;
         ModelResource(ModelResource && other) = default;
         ModelResource & operator=(const ModelResource &) = delete;
         ModelResource & operator=(ModelResource && other) = default;
 
-        void draw(const std::set<vk::DeviceSize> & dynamicOffsets, const vk::UniqueCommandBuffer & cmdBuffer, const vk::UniquePipelineLayout & pipelineLayout, const vk::UniqueDescriptorSet & descriptorSet) const;
+        auto getVertexCount() const noexcept { return m_vertexCount; }
+        auto getIndexCount() const noexcept { return m_indexCount; }
+        auto getFirstIndex() const noexcept { return m_firstIndex; }
+        auto getVertexOffset() const noexcept { return m_vertexOffset; }
+        // Moving the geometry inside the shared buffers
+        void setFirstIndex(const uint32_t firstIndex) noexcept { m_firstIndex = firstIndex; }
+        void setVertexOffset(const int32_t vertexOffset) noexcept { m_vertexOffset = vertexOffset; }
+        // Object space bounding sphere, center in xyz and radius in w
+        auto getBoundingSphere() const noexcept { return m_boundingSphere; }
+
+        vk::DrawIndexedIndirectCommand getDrawCommand(const uint32_t firstInstance, const uint32_t instanceCount) const noexcept;
+        // The shared buffers have to be bound
+        void draw(const uint32_t firstInstance, const uint32_t instanceCount, const vk::UniqueCommandBuffer & cmdBuffer) const;
     private:
-        std::vector<Vertex<VD>> m_vertices;
-        std::vector<uint32_t> m_indices;
+        uint32_t m_vertexCount;
+        uint32_t m_indexCount;
 
-        vk::UniqueDeviceMemory m_bufferMemory;
-        vk::UniqueBuffer m_buffer;
-        vk::DeviceSize m_offset = 0;
+        uint32_t m_firstIndex;
+        int32_t m_vertexOffset;
+        glm::vec4 m_boundingSphere;
     };
 }
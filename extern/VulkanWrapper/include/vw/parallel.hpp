@@ -0,0 +1,70 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <future>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace vw::util
+{
+    // Calls body(i) for every i below count, on as many threads as the hardware runs concurrently, the calling thread included.
+    // Items are handed out one at a time in ascending order, so they should be coarse. Once an item throws, no further items
+    // are started; the exception of the lowest failed item is rethrown, which is the one a serial loop would have thrown.
+    template <class F>
+    void parallelFor(const size_t count, const F & body)
+    {
+        const auto numThreads{ std::min(count, static_cast<size_t>(std::max(std::thread::hardware_concurrency(), 1u))) };
+        std::atomic<size_t> next{ 0 };
+        std::atomic<bool> failed{ false };
+        std::mutex mutex;
+        auto failedIndex{ count };
+        std::exception_ptr exception;
+
+        const auto work = [&]()
+        {
+            while (!failed)
+            {
+                const auto i{ next++ };
+                if (i >= count)
+                {
+                    return;
+                }
+
+                try
+                {
+                    body(i);
+                }
+                catch (...)
+                {
+                    std::lock_guard<std::mutex> lock{ mutex };
+                    if (i < failedIndex)
+                    {
+                        failedIndex = i;
+                        exception = std::current_exception();
+                    }
+                    failed = true;
+                }
+            }
+        };
+
+        std::vector<std::future<void>> workers;
+        for (size_t i = 1; i < numThreads; ++i)
+        {
+            workers.emplace_back(std::async(std::launch::async, work));
+        }
+
+        work();
+        for (auto & worker : workers)
+        {
+            worker.get();
+        }
+
+        if (exception)
+        {
+            std::rethrow_exception(exception);
+        }
+    }
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+#define GLM_FORCE_RADIANS
+#include <glm/glm.hpp>
+
+#include <cstdint>
+
+namespace vw::util
+{
+    // Translation, rotation and scale of many objects as structure-of-arrays, one entry per object. Rotations are unit
+    // quaternions. The scale arrays may be left null for unit scale.
+    struct TransformArrays
+    {
+        const float * translationX = nullptr;
+        const float * translationY = nullptr;
+        const float * translationZ = nullptr;
+        const float * rotationX = nullptr;
+        const float * rotationY = nullptr;
+        const float * rotationZ = nullptr;
+        const float * rotationW = nullptr;
+        const float * scaleX = nullptr;
+        const float * scaleY = nullptr;
+        const float * scaleZ = nullptr;
+    };
+
+    // Writes translate(t) * mat4_cast(r) * scale(s) of object i to matrices[indices[i]], for count objects. Four matrices
+    // are composed at once with SSE.
+    void composeTransforms(const TransformArrays & transforms, const size_t count, const uint32_t * indices, glm::mat4 * matrices);
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <vulkan/vulkan.hpp>
+
+#include <type_traits>
+#include <vector>
+
+#include "memoryAllocator.hpp"
+
+namespace vw::util
+{
+    // Creates the attachments that only live within a frame, like depth buffers and intermediate render targets. Attachments
+    // that are only used as attachments get transient usage and lazily allocated memory where the device has it, so tilers
+    // may never back them with memory at all. Attachments whose pass ranges do not overlap share memory.
+    // Aliased attachments lose their contents whenever another one is used, so render passes have to start them in undefined
+    // layout and must not load them.
+    // The memory is kept when the attachments are cleared and reused by the next build if it is large enough, so recreating
+    // them on every resize does not churn the heap. release() returns it to the allocator.
+    class TransientAttachmentAllocator
+    {
+    public:
+        using AttachmentId = uint32_t;
+
+        // The allocator has to outlive this one
+        TransientAttachmentAllocator(const vk::UniqueDevice & device, MemoryAllocator & allocator);
+        TransientAttachmentAllocator(const TransientAttachmentAllocator &) = delete;
+        TransientAttachmentAllocator(TransientAttachmentAllocator && other) = default;
+        TransientAttachmentAllocator & operator=(const TransientAttachmentAllocator &) = delete;
+        TransientAttachmentAllocator & operator=(TransientAttachmentAllocator && other) = default;
+        ~TransientAttachmentAllocator() {}
+
+        // The attachment is used from firstPass up to and including lastPass of a frame
+        AttachmentId addAttachment(const vk::Format format, const vk::Extent2D extent, const vk::ImageUsageFlags usage, const vk::ImageAspectFlags aspect, const uint32_t firstPass = 0, const uint32_t lastPass = 0, const vk::SampleCountFlagBits samples = vk::SampleCountFlagBits::e1);
+        // Creates the images and views of all attachments added since the last clear and binds them to memory
+        void build();
+        // Destroys all attachments, the memory is kept for the next build
+        void clear();
+        void release();
+
+        const vk::UniqueImage & getImage(const AttachmentId id) const { return m_attachments.at(id).image; }
+        const vk::UniqueImageView & getImageView(const AttachmentId id) const { return m_attachments.at(id).view; }
+        bool isLazilyAllocated(const AttachmentId id) const;
+        auto getAttachmentCount() const noexcept { return static_cast<uint32_t>(m_attachments.size()); }
+        auto getMemoryCount() const noexcept { return static_cast<uint32_t>(m_memory.size()); }
+    private:
+        struct Attachment
+        {
+            vk::ImageCreateInfo info;
+            vk::ImageAspectFlags aspect;
+            uint32_t firstPass;
+            uint32_t lastPass;
+            vk::UniqueImage image;
+            vk::UniqueImageView view;
+            uint32_t memoryIndex = 0;
+        };
+
+        // Attachments sharing one allocation, none of their pass ranges overlap
+        struct MemorySlot
+        {
+            vk::MemoryRequirements requirements;
+            vk::MemoryPropertyFlags properties;
+            std::vector<uint32_t> attachments;
+        };
+
+        vk::Device m_device;
+        MemoryAllocator * m_allocator;
+        std::vector<Attachment> m_attachments;
+        std::vector<UniqueAllocation> m_memory;
+
+        bool hasMemoryType(const uint32_t typeFilter, const vk::MemoryPropertyFlags properties) const;
+        bool fits(const UniqueAllocation & allocation, const MemorySlot & slot) const;
+    };
+
+    static_assert(std::is_move_constructible_v<TransientAttachmentAllocator>);
+    static_assert(!std::is_copy_constructible_v<TransientAttachmentAllocator>);
+    static_assert(std::is_move_assignable_v<TransientAttachmentAllocator>);
+    static_assert(!std::is_copy_assignable_v<TransientAttachmentAllocator>);
+}
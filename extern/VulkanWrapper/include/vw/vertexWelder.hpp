@@ -0,0 +1,138 @@
+#pragma once
+
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+#include <type_traits>
+#include <vector>
+
+#include "vertex.hpp"
+
+namespace vw::scene
+{
+    // Deduplicates vertices in a flat open-addressing table. Each slot holds 32 bits of the hash and the index of a vertex, so
+    // a probe only compares the vertex itself when the hashes agree. Vertices are equal when operator== says so, like with
+    // std::unordered_map: 0 and -0 are welded, NaNs never are. The vertices are numbered in the order they were first welded.
+    template<VertexDescription VD>
+    class VertexWelder
+    {
+    public:
+        explicit VertexWelder(const size_t expectedVertices = 0)
+        {
+            reserve(expectedVertices);
+        }
+
+        static uint32_t hash(const Vertex<VD> & vertex)
+        {
+            static_assert(sizeof(Vertex<VD>) % sizeof(float) == 0, "vertices have to consist of floats");
+            float components[sizeof(Vertex<VD>) / sizeof(float)];
+            memcpy(components, &vertex, sizeof(Vertex<VD>));
+
+            // Adding zero turns -0 into 0, so equal vertices hash equally. Two components are mixed in at a time.
+            uint64_t h = 0x9e3779b97f4a7c15ull;
+            for (size_t i = 0; i < std::size(components); i += 2)
+            {
+                const float pair[2]{ components[i] + 0.f, i + 1 < std::size(components) ? components[i + 1] + 0.f : 0.f };
+                uint64_t bits;
+                memcpy(&bits, pair, sizeof(bits));
+                h = (h ^ bits) * 0xff51afd7ed558ccdull;
+                h ^= h >> 32;
+            }
+
+            h *= 0xc4ceb9fe1a85ec53ull;
+            h ^= h >> 29;
+            return static_cast<uint32_t>(h);
+        }
+
+        // Returns the index of the welded vertex equal to this one, adding the vertex if there is none
+        uint32_t weld(const Vertex<VD> & vertex) { return weld(vertex, hash(vertex)); }
+        // The hash has to come from hash()
+        uint32_t weld(const Vertex<VD> & vertex, const uint32_t hash)
+        {
+            if (2 * (m_vertices.size() + 1) > m_slots.size())
+            {
+                rehash(std::max(m_slots.size() * 2, k_minSlots));
+            }
+
+            for (auto position = hash & m_mask;; position = (position + 1) & m_mask)
+            {
+                auto & slot{ m_slots[position] };
+                if (slot.index == k_empty)
+                {
+                    slot = { hash, static_cast<uint32_t>(m_vertices.size()) };
+                    m_vertices.push_back(vertex);
+                    return slot.index;
+                }
+
+                if (slot.hash == hash && m_vertices[slot.index] == vertex)
+                {
+                    return slot.index;
+                }
+            }
+        }
+
+        void reserve(const size_t numVertices)
+        {
+            auto numSlots{ k_minSlots };
+            while (numSlots < 2 * numVertices)
+            {
+                numSlots *= 2;
+            }
+
+            if (numSlots > m_slots.size())
+            {
+                rehash(numSlots);
+            }
+            m_vertices.reserve(numVertices);
+        }
+
+        auto size() const noexcept { return m_vertices.size(); }
+        const std::vector<Vertex<VD>> & getVertices() const noexcept { return m_vertices; }
+        std::vector<Vertex<VD>> releaseVertices()
+        {
+            m_slots.clear();
+            m_mask = 0;
+            return std::move(m_vertices);
+        }
+    private:
+        static constexpr uint32_t k_empty = 0xffffffff;
+        static constexpr size_t k_minSlots = 64;
+
+        struct Slot
+        {
+            uint32_t hash;
+            uint32_t index = k_empty;
+        };
+
+        std::vector<Slot> m_slots;
+        size_t m_mask = 0;
+        std::vector<Vertex<VD>> m_vertices;
+
+        void rehash(const size_t numSlots)
+        {
+            std::vector<Slot> slots(numSlots);
+            const auto mask{ numSlots - 1 };
+            for (const auto & slot : m_slots)
+            {
+                if (slot.index != k_empty)
+                {
+                    auto position{ slot.hash & mask };
+                    while (slots[position].index != k_empty)
+                    {
+                        position = (position + 1) & mask;
+                    }
+                    slots[position] = slot;
+                }
+            }
+
+            m_slots = std::move(slots);
+            m_mask = mask;
+        }
+    };
+
+    static_assert(std::is_move_constructible_v<VertexWelder<VertexDescription::PositionNormalColorTexture>>);
+    static_assert(std::is_move_assignable_v<VertexWelder<VertexDescription::PositionNormalColorTexture>>);
+
+    static_assert(std::is_move_constructible_v<VertexWelder<VertexDescription::PositionNormalColor>>);
+    static_assert(std::is_move_assignable_v<VertexWelder<VertexDescription::PositionNormalColor>>);
+}
@@ -0,0 +1,4 @@
+"%VULKAN_SDK%\Bin\glslangValidator.exe" -V "%~dp0vertex.vert" -o "%~dp0vertex.vert.spv"
+"%VULKAN_SDK%\Bin\glslangValidator.exe" -V "%~dp0fragment.frag" -o "%~dp0fragment.frag.spv"
+"%VULKAN_SDK%\Bin\glslangValidator.exe" -V "%~dp0cull.comp" -o "%~dp0cull.comp.spv"
+pause
\ No newline at end of file
@@ -12,10 +12,17 @@ layout (binding = 0) uniform UboView
     mat4 proj;
 } uboView;
 
-layout (binding = 1) uniform UboInstance
+// Must match vw::util::InstanceFormat
+layout (constant_id = 0) const uint instanceFormat = 0u;
+const uint k_formatAffine = 1u;
+const uint k_formatPositionRotationScale = 2u;
+const uint k_instanceStride = instanceFormat == k_formatAffine ? 3u : (instanceFormat == k_formatPositionRotationScale ? 2u : 4u);
+
+// The instances packed without padding, k_instanceStride vectors each
+layout (std430, binding = 1) readonly buffer InstanceBuffer
 {
-    mat4 model;
-} uboInstance;
+    vec4 data[];
+} instances;
 
 layout (location = 0) out vec3 outColor;
 
@@ -24,9 +31,30 @@ out gl_PerVertex
     vec4 gl_Position;
 };
 
+vec3 toWorld(uint index, vec3 position)
+{
+    uint first = index * k_instanceStride;
+    if (instanceFormat == k_formatAffine)
+    {
+        // The rows of the model matrix
+        vec4 p = vec4(position, 1.0);
+        return vec3(dot(instances.data[first], p), dot(instances.data[first + 1], p), dot(instances.data[first + 2], p));
+    }
+
+    if (instanceFormat == k_formatPositionRotationScale)
+    {
+        vec4 positionScale = instances.data[first];
+        vec4 q = instances.data[first + 1];
+        vec3 v = position * positionScale.w;
+        return v + 2.0 * cross(q.xyz, cross(q.xyz, v) + q.w * v) + positionScale.xyz;
+    }
+
+    mat4 model = mat4(instances.data[first], instances.data[first + 1], instances.data[first + 2], instances.data[first + 3]);
+    return (model * vec4(position, 1.0)).xyz;
+}
+
 void main()
 {
     outColor = inColor;
-    mat4 modelView = uboView.view * uboInstance.model;
-    gl_Position = uboView.proj * modelView * vec4(inPosition.xyz, 1.0);
+    gl_Position = uboView.proj * uboView.view * vec4(toWorld(uint(gl_InstanceIndex), inPosition.xyz), 1.0);
 }